@@ -35,6 +35,33 @@ extern "C" {
 
 LOADER_EXPORT bool NodesetLoader_loadFile(struct UA_Server *, const char *path,
                             NodesetLoader_ExtensionInterface *extensionHandling);
+// loads a nodeset from memory, the buffer has to stay valid during the call
+LOADER_EXPORT bool NodesetLoader_loadBuffer(struct UA_Server *, const char *buffer,
+                            size_t size,
+                            NodesetLoader_ExtensionInterface *extensionHandling);
+// Keeps the reference types of the server between the loads of several
+// nodesets, instead of browsing all of them for each load. The reference types
+// of a load are added to the cache if the load succeeds, types which are added
+// to the server otherwise are looked up when they are used. The cache belongs
+// to the caller and isn't synchronized, loads which use the same cache must
+// not run concurrently. NULL if memory ran out.
+typedef struct NodesetLoader_ReferenceTypeCache
+    NodesetLoader_ReferenceTypeCache;
+LOADER_EXPORT NodesetLoader_ReferenceTypeCache *
+NodesetLoader_enableReferenceTypeCache(struct UA_Server *server);
+// doesn't access the server, the cache can be released after it was deleted
+LOADER_EXPORT void NodesetLoader_cleanupReferenceTypeCache(
+    NodesetLoader_ReferenceTypeCache *cache);
+// like NodesetLoader_loadFile and NodesetLoader_loadBuffer, the reference
+// types are taken from the cache, which has to be enabled for the server
+LOADER_EXPORT bool NodesetLoader_loadFileWithCache(
+    struct UA_Server *, const char *path,
+    NodesetLoader_ExtensionInterface *extensionHandling,
+    NodesetLoader_ReferenceTypeCache *cache);
+LOADER_EXPORT bool NodesetLoader_loadBufferWithCache(
+    struct UA_Server *, const char *buffer, size_t size,
+    NodesetLoader_ExtensionInterface *extensionHandling,
+    NodesetLoader_ReferenceTypeCache *cache);
 
 #ifdef __cplusplus
 }
@@ -9,6 +9,7 @@
 #include <open62541/types.h>
 
 #include "DataTypeImporter.h"
+#include "Ns0Tables.h"
 #include "conversion.h"
 #include "customDataType.h"
 #include "padding.h"
@@ -36,6 +37,12 @@ static UA_NodeId getBinaryEncodingId(const NL_DataTypeNode *node)
         }
         ref = ref->next;
     }
+    // data types of namespace 0 without the encoding nodes
+    const Ns0Tables_DataType *ns0Type = Ns0Tables_findDataType(&node->id);
+    if (ns0Type && ns0Type->binaryEncodingId)
+    {
+        return UA_NODEID_NUMERIC(0, ns0Type->binaryEncodingId);
+    }
     return UA_NODEID_NULL;
 }
 
@@ -60,7 +67,7 @@ static const UA_DataType *getDataType(const UA_NodeId *id,
         {
             if (UA_NodeId_equal(&importer->nodes[i]->id, &type->typeId))
             {
-                if (strcmp(importer->nodes[i]->isAbstract, "true") == 0)
+                if (importer->nodes[i]->flags & NL_NODEFLAG_ISABSTRACT)
                 {
                     return &UA_TYPES[UA_TYPES_VARIANT];
                 }
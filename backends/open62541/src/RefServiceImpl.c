@@ -9,38 +9,168 @@
 
 #include "RefServiceImpl.h"
 #include "NodesetLoader/NodesetLoader.h"
+#include "NodesetLoader/backendOpen62541.h"
+#include "Ns0Tables.h"
 
 #include <assert.h>
 #include <stdlib.h>
 
-struct RefContainer
+// subtypes of a reference type which is not yet known are looked up in the
+// server up to this depth
+#define MAX_SUBTYPE_DEPTH 32
+
+// open addressing hash set of node ids, the ids are copied
+struct RefEntry
+{
+    UA_UInt32 hash;
+    bool used;
+    UA_NodeId id;
+};
+typedef struct RefEntry RefEntry;
+
+struct RefSet
 {
     size_t size;
-    UA_NodeId *ids;
+    size_t capacity;
+    RefEntry *entries;
+};
+typedef struct RefSet RefSet;
+
+// the reference types of a server, either built for one import or kept by
+// a NodesetLoader_ReferenceTypeCache
+struct RefTypeCache
+{
+    RefSet hierachicalRefs;
+    RefSet nonHierachicalRefs;
+    RefSet hasTypeDefRefs;
+};
+typedef struct RefTypeCache RefTypeCache;
+
+struct NodesetLoader_ReferenceTypeCache
+{
+    // only compared, the server isn't accessed through the cache
+    const UA_Server *server;
+    RefTypeCache *types;
 };
-typedef struct RefContainer RefContainer;
 
 struct RefServiceImpl
 {
-    RefContainer hierachicalRefs;
-    RefContainer nonHierachicalRefs;
-    RefContainer hasTypeDefRefs;
+    UA_Server *server;
+    // owned by the service, a copy of the types of shared if there is one
+    RefTypeCache *cache;
+    // the cache of the caller, gets the types of a successful import
+    NodesetLoader_ReferenceTypeCache *shared;
 };
+typedef struct RefServiceImpl RefServiceImpl;
 
-static void
-RefContainer_clear(RefContainer *c) {
-    for (UA_NodeId *id = c->ids; id != c->ids + c->size; id++) {
-        UA_NodeId_clear(id);
+static RefEntry *RefSet_find(RefEntry *entries, size_t capacity,
+                             UA_UInt32 hash, const UA_NodeId *id)
+{
+    size_t mask = capacity - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        RefEntry *e = &entries[i];
+        if (!e->used || (e->hash == hash && UA_NodeId_equal(&e->id, id)))
+        {
+            return e;
+        }
     }
-    free(c->ids);
 }
 
-typedef struct RefServiceImpl RefServiceImpl;
+static bool RefSet_contains(const RefSet *set, const UA_NodeId *id)
+{
+    if (!set->capacity)
+    {
+        return false;
+    }
+    return RefSet_find(set->entries, set->capacity, UA_NodeId_hash(id), id)
+        ->used;
+}
+
+static bool RefSet_grow(RefSet *set)
+{
+    size_t capacity = set->capacity ? set->capacity * 2 : 64;
+    RefEntry *entries = (RefEntry *)calloc(capacity, sizeof(RefEntry));
+    if (!entries)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < set->capacity; i++)
+    {
+        if (set->entries[i].used)
+        {
+            *RefSet_find(entries, capacity, set->entries[i].hash,
+                         &set->entries[i].id) = set->entries[i];
+        }
+    }
+    free(set->entries);
+    set->entries = entries;
+    set->capacity = capacity;
+    return true;
+}
+
+static void RefSet_add(RefSet *set, const UA_NodeId *id)
+{
+    if ((set->size + 1) * 2 > set->capacity && !RefSet_grow(set))
+    {
+        return;
+    }
+    UA_UInt32 hash = UA_NodeId_hash(id);
+    RefEntry *e = RefSet_find(set->entries, set->capacity, hash, id);
+    if (e->used)
+    {
+        return;
+    }
+    e->used = true;
+    e->hash = hash;
+    UA_NodeId_copy(id, &e->id);
+    set->size++;
+}
+
+static void RefSet_clear(RefSet *set)
+{
+    for (size_t i = 0; i < set->capacity; i++)
+    {
+        if (set->entries[i].used)
+        {
+            UA_NodeId_clear(&set->entries[i].id);
+        }
+    }
+    free(set->entries);
+}
+
+static bool RefSet_copy(const RefSet *src, RefSet *dst)
+{
+    dst->size = 0;
+    dst->capacity = 0;
+    dst->entries = NULL;
+    if (!src->capacity)
+    {
+        return true;
+    }
+    dst->entries = (RefEntry *)calloc(src->capacity, sizeof(RefEntry));
+    if (!dst->entries)
+    {
+        return false;
+    }
+    dst->capacity = src->capacity;
+    for (size_t i = 0; i < src->capacity; i++)
+    {
+        if (!src->entries[i].used)
+        {
+            continue;
+        }
+        dst->entries[i] = src->entries[i];
+        UA_NodeId_copy(&src->entries[i].id, &dst->entries[i].id);
+        dst->size++;
+    }
+    return true;
+}
 
-typedef void (*browseFnc)(RefServiceImpl *impl, const UA_NodeId id);
+typedef void (*browseFnc)(RefTypeCache *cache, const UA_NodeId id);
 
 static void iterate(UA_Server *server, const UA_NodeId *startId, browseFnc fnc,
-                    RefServiceImpl *impl)
+                    RefTypeCache *cache)
 {
     UA_BrowseDescription bd;
     UA_BrowseDescription_init(&bd);
@@ -56,120 +186,278 @@ static void iterate(UA_Server *server, const UA_NodeId *startId, browseFnc fnc,
         for (UA_ReferenceDescription *rd = br.references;
              rd != br.references + br.referencesSize; rd++)
         {
-            fnc(impl, rd->nodeId.nodeId);
+            fnc(cache, rd->nodeId.nodeId);
 
-            iterate(server, &rd->nodeId.nodeId, fnc, impl);
+            iterate(server, &rd->nodeId.nodeId, fnc, cache);
         }
     }
     UA_BrowseResult_clear(&br);
 }
 
-static void
-addToRefs(RefContainer *refs, const UA_NodeId id)
+static void addToHierachicalRefs(RefTypeCache *cache, const UA_NodeId id)
 {
-    refs->ids = (UA_NodeId *)realloc(refs->ids, sizeof(UA_NodeId) * (refs->size + 1));
-    UA_NodeId *newId = refs->ids + refs->size;
-    UA_NodeId_copy(&id, newId);
-    refs->size++;
+    RefSet_add(&cache->hierachicalRefs, &id);
 }
 
-static void addToHierachicalRefs(RefServiceImpl *impl, const UA_NodeId id)
+static void addToNonHierachicalRefs(RefTypeCache *cache, const UA_NodeId id)
 {
-    addToRefs(&impl->hierachicalRefs, id);
+    RefSet_add(&cache->nonHierachicalRefs, &id);
 }
 
-static void addToNonHierachicalRefs(RefServiceImpl *impl, const UA_NodeId id)
+static void addToHasTypeDefRefs(RefTypeCache *cache, const UA_NodeId id)
 {
-    addToRefs(&impl->nonHierachicalRefs, id);
+    RefSet_add(&cache->hasTypeDefRefs, &id);
 }
 
-static void addToHasTypeDefRefs(RefServiceImpl *impl, const UA_NodeId id)
+static void getRefs(UA_Server *server, RefTypeCache *cache,
+                    const UA_NodeId startId, browseFnc fn)
 {
-    addToRefs(&impl->hasTypeDefRefs, id);
+    iterate(server, &startId, fn, cache);
 }
 
-static void getRefs(UA_Server *server, RefServiceImpl *impl,
-                    const UA_NodeId startId, browseFnc fn)
+static RefTypeCache *RefTypeCache_new(UA_Server *server)
+{
+    RefTypeCache *cache = (RefTypeCache *)calloc(1, sizeof(RefTypeCache));
+    if (!cache)
+    {
+        return NULL;
+    }
+    UA_NodeId hierachicalRoot =
+        UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
+    UA_NodeId nonHierachicalRoot =
+        UA_NODEID_NUMERIC(0, UA_NS0ID_NONHIERARCHICALREFERENCES);
+    UA_NodeId hasTypeDefRoot = UA_NODEID_NUMERIC(0, UA_NS0ID_HASTYPEDEFINITION);
+    addToHierachicalRefs(cache, hierachicalRoot);
+    addToNonHierachicalRefs(cache, nonHierachicalRoot);
+    addToHasTypeDefRefs(cache, hasTypeDefRoot);
+    getRefs(server, cache, hierachicalRoot, addToHierachicalRefs);
+    getRefs(server, cache, nonHierachicalRoot, addToNonHierachicalRefs);
+    getRefs(server, cache, hasTypeDefRoot, addToHasTypeDefRefs);
+    return cache;
+}
+
+static void RefTypeCache_delete(RefTypeCache *cache)
+{
+    if (!cache)
+    {
+        return;
+    }
+    RefSet_clear(&cache->hierachicalRefs);
+    RefSet_clear(&cache->nonHierachicalRefs);
+    RefSet_clear(&cache->hasTypeDefRefs);
+    free(cache);
+}
+
+static RefTypeCache *RefTypeCache_copy(const RefTypeCache *src)
+{
+    RefTypeCache *cache = (RefTypeCache *)calloc(1, sizeof(RefTypeCache));
+    if (!cache)
+    {
+        return NULL;
+    }
+    if (!RefSet_copy(&src->hierachicalRefs, &cache->hierachicalRefs) ||
+        !RefSet_copy(&src->nonHierachicalRefs, &cache->nonHierachicalRefs) ||
+        !RefSet_copy(&src->hasTypeDefRefs, &cache->hasTypeDefRefs))
+    {
+        RefTypeCache_delete(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+// the reference types of namespace 0 are classified by the generated tables,
+// without looking into the cache
+static bool isClassified(const RefSet *set, const UA_NodeId *id,
+                         uint8_t ns0Flag)
+{
+    const Ns0Tables_ReferenceType *ns0Type = Ns0Tables_findReferenceType(id);
+    if (ns0Type)
+    {
+        return (ns0Type->flags & ns0Flag) != 0;
+    }
+    return RefSet_contains(set, id);
+}
+
+static bool isHierachicalType(const RefTypeCache *cache, const UA_NodeId *id)
+{
+    return isClassified(&cache->hierachicalRefs, id, NS0TABLES_HIERACHICAL);
+}
+
+static bool isNonHierachicalType(const RefTypeCache *cache,
+                                 const UA_NodeId *id)
 {
-    iterate(server, &startId, fn, impl);
+    return isClassified(&cache->nonHierachicalRefs, id,
+                        NS0TABLES_NONHIERACHICAL);
 }
 
-static bool
-isInContainer(const RefContainer c, const NL_Reference *ref) {
-    for (const UA_NodeId *id = c.ids; id != c.ids + c.size; id++)
+static bool isHasTypeDefType(const RefTypeCache *cache, const UA_NodeId *id)
+{
+    return isClassified(&cache->hasTypeDefRefs, id,
+                        NS0TABLES_HASTYPEDEFINITION);
+}
+
+// the subtype inherits the classification of its super type
+static void addSubtype(RefTypeCache *cache, const UA_NodeId *id,
+                       const UA_NodeId *superType)
+{
+    if (isHasTypeDefType(cache, superType))
     {
-        if (UA_NodeId_equal(&ref->refType, id))
-            return true;
+        RefSet_add(&cache->hasTypeDefRefs, id);
+    }
+    if (isHierachicalType(cache, superType))
+    {
+        RefSet_add(&cache->hierachicalRefs, id);
+    }
+    else if (isNonHierachicalType(cache, superType))
+    {
+        RefSet_add(&cache->nonHierachicalRefs, id);
     }
-    return false;
+}
+
+static bool isKnown(const RefTypeCache *cache, const UA_NodeId *id)
+{
+    return Ns0Tables_findReferenceType(id) ||
+           RefSet_contains(&cache->hierachicalRefs, id) ||
+           RefSet_contains(&cache->nonHierachicalRefs, id);
+}
+
+// A cache which is kept between loads misses the reference types which were
+// added to the server by other means than the loader. They are looked up by
+// their super types.
+static void lookupInServer(const RefServiceImpl *impl, const UA_NodeId *id,
+                           size_t depth)
+{
+    if (!impl->shared || depth == MAX_SUBTYPE_DEPTH)
+    {
+        return;
+    }
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.browseDirection = UA_BROWSEDIRECTION_INVERSE;
+    bd.includeSubtypes = false;
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE);
+    bd.resultMask = UA_BROWSERESULTMASK_NONE;
+    bd.nodeId = *id;
+    bd.nodeClassMask = UA_NODECLASS_REFERENCETYPE;
+    UA_BrowseResult br = UA_Server_browse(impl->server, 1, &bd);
+    if (br.statusCode == UA_STATUSCODE_GOOD && br.referencesSize == 1)
+    {
+        const UA_NodeId *superType = &br.references[0].nodeId.nodeId;
+        if (!isKnown(impl->cache, superType))
+        {
+            lookupInServer(impl, superType, depth + 1);
+        }
+        addSubtype(impl->cache, id, superType);
+    }
+    UA_BrowseResult_clear(&br);
 }
 
 static bool isNonHierachicalRef(const RefServiceImpl *service,
                                 const NL_Reference *ref)
 {
-    return isInContainer(service->nonHierachicalRefs, ref);
+    if (!isKnown(service->cache, &ref->refType))
+    {
+        lookupInServer(service, &ref->refType, 0);
+    }
+    return isNonHierachicalType(service->cache, &ref->refType);
 }
 
 static bool isHierachicalRef(const RefServiceImpl *service,
                                    const NL_Reference *ref)
 {
-    return isInContainer(service->hierachicalRefs, ref);
+    if (!isKnown(service->cache, &ref->refType))
+    {
+        lookupInServer(service, &ref->refType, 0);
+    }
+    return isHierachicalType(service->cache, &ref->refType);
 }
 
 static bool isTypeDefRef(const RefServiceImpl *service, const NL_Reference *ref)
 {
-    return isInContainer(service->hasTypeDefRefs, ref);
+    if (!isKnown(service->cache, &ref->refType))
+    {
+        lookupInServer(service, &ref->refType, 0);
+    }
+    return isHasTypeDefType(service->cache, &ref->refType);
 }
 
 static void addnewRefType(RefServiceImpl *service, NL_ReferenceTypeNode *node)
 {
+    RefTypeCache *cache = service->cache;
     NL_Reference *ref = node->hierachicalRefs;
     bool isHierachical = false;
     while (ref) {
         if (!ref->isForward) {
-            for (size_t i = 0; i < service->hierachicalRefs.size; i++) {
-                if (UA_NodeId_equal(&service->hierachicalRefs.ids[i], &ref->target)) {
-                    addToRefs(&service->hierachicalRefs, node->id);
-                    isHierachical = true;
-                }
-            }
-            for (size_t i = 0; i < service->hasTypeDefRefs.size; i++) {
-                if (UA_NodeId_equal(&service->hasTypeDefRefs.ids[i], &ref->target))
-                    addToRefs(&service->hasTypeDefRefs, node->id);
+            if (isHierachicalType(cache, &ref->target)) {
+                RefSet_add(&cache->hierachicalRefs, &node->id);
+                isHierachical = true;
             }
+            if (isHasTypeDefType(cache, &ref->target))
+                RefSet_add(&cache->hasTypeDefRefs, &node->id);
         }
         ref = ref->next;
     }
     if (!isHierachical)
-        addToRefs(&service->nonHierachicalRefs, node->id);
+        RefSet_add(&cache->nonHierachicalRefs, &node->id);
+}
+
+NodesetLoader_ReferenceTypeCache *
+NodesetLoader_enableReferenceTypeCache(struct UA_Server *server)
+{
+    if (!server)
+    {
+        return NULL;
+    }
+    NodesetLoader_ReferenceTypeCache *cache =
+        (NodesetLoader_ReferenceTypeCache *)calloc(
+            1, sizeof(NodesetLoader_ReferenceTypeCache));
+    if (!cache)
+    {
+        return NULL;
+    }
+    cache->types = RefTypeCache_new(server);
+    if (!cache->types)
+    {
+        free(cache);
+        return NULL;
+    }
+    cache->server = server;
+    return cache;
 }
 
-NL_ReferenceService *RefServiceImpl_new(struct UA_Server *server)
+void NodesetLoader_cleanupReferenceTypeCache(
+    NodesetLoader_ReferenceTypeCache *cache)
+{
+    if (!cache)
+    {
+        return;
+    }
+    RefTypeCache_delete(cache->types);
+    free(cache);
+}
+
+NL_ReferenceService *
+RefServiceImpl_new(struct UA_Server *server,
+                   NodesetLoader_ReferenceTypeCache *cache)
 {
     RefServiceImpl *impl = (RefServiceImpl *)calloc(1, sizeof(RefServiceImpl));
     if (!impl)
     {
         return NULL;
     }
-    UA_NodeId hierachicalRoot =
-        UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
-    UA_NodeId nonHierachicalRoot =
-        UA_NODEID_NUMERIC(0, UA_NS0ID_NONHIERARCHICALREFERENCES);
-    UA_NodeId hasTypeDefRoot = UA_NODEID_NUMERIC(0, UA_NS0ID_HASTYPEDEFINITION);
-    addToRefs(&impl->hierachicalRefs, hierachicalRoot);
-    addToRefs(&impl->nonHierachicalRefs, nonHierachicalRoot);
-    addToRefs(&impl->hasTypeDefRefs, hasTypeDefRoot);
-    getRefs(server, impl, hierachicalRoot, addToHierachicalRefs);
-    getRefs(server, impl, nonHierachicalRoot, addToNonHierachicalRefs);
-    getRefs(server, impl, hasTypeDefRoot, addToHasTypeDefRefs);
+    impl->server = server;
+    // the import works on a copy, the cache of the caller only gets the
+    // reference types of successful imports
+    impl->shared = cache;
+    impl->cache =
+        cache ? RefTypeCache_copy(cache->types) : RefTypeCache_new(server);
 
     NL_ReferenceService *refService = (NL_ReferenceService *)calloc(1, sizeof(NL_ReferenceService));
-    if (!refService)
+    if (!refService || !impl->cache)
     {
-        RefContainer_clear(&impl->hierachicalRefs);
-        RefContainer_clear(&impl->nonHierachicalRefs);
-        RefContainer_clear(&impl->hasTypeDefRefs);
+        RefTypeCache_delete(impl->cache);
         free(impl);
+        free(refService);
         return NULL;
     }
     refService->context = impl;
@@ -183,12 +471,37 @@ NL_ReferenceService *RefServiceImpl_new(struct UA_Server *server)
     return refService;
 }
 
+void RefServiceImpl_commit(NL_ReferenceService *service)
+{
+    if (!service)
+    {
+        return;
+    }
+    RefServiceImpl *impl = (RefServiceImpl *)service->context;
+    if (!impl->shared)
+    {
+        return;
+    }
+    // the copy contains the types of the shared cache and the new ones
+    RefTypeCache *previous = impl->shared->types;
+    impl->shared->types = impl->cache;
+    impl->cache = previous;
+}
+
 void RefServiceImpl_delete(NL_ReferenceService *service)
 {
+    if (!service)
+    {
+        return;
+    }
     RefServiceImpl *impl = (RefServiceImpl *)service->context;
-    RefContainer_clear(&impl->hierachicalRefs);
-    RefContainer_clear(&impl->nonHierachicalRefs);
-    RefContainer_clear(&impl->hasTypeDefRefs);
+    RefTypeCache_delete(impl->cache);
     free(impl);
     free(service);
 }
+
+bool RefServiceImpl_isCacheOf(const NodesetLoader_ReferenceTypeCache *cache,
+                              const struct UA_Server *server)
+{
+    return cache->server == server;
+}
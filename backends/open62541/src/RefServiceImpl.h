@@ -10,7 +10,18 @@
 
 #include <open62541/server.h>
 #include "NodesetLoader/ReferenceService.h"
+#include "NodesetLoader/backendOpen62541.h"
 
-NL_ReferenceService *RefServiceImpl_new(struct UA_Server *server);
+// the reference types are taken from cache if it isn't NULL, otherwise they
+// are browsed in the server
+NL_ReferenceService *
+RefServiceImpl_new(struct UA_Server *server,
+                   NodesetLoader_ReferenceTypeCache *cache);
+// stores the reference types of a successful import in the cache the service
+// was created with, if there is one
+void RefServiceImpl_commit(NL_ReferenceService *service);
 void RefServiceImpl_delete(NL_ReferenceService *service);
+// false if the cache was enabled for another server
+bool RefServiceImpl_isCacheOf(const NodesetLoader_ReferenceTypeCache *cache,
+                              const struct UA_Server *server);
 #endif
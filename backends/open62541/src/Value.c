@@ -10,10 +10,12 @@
 #include "Value.h"
 #include "conversion.h"
 #include "NodesetLoader/NodesetLoader.h"
-#include "nodeset_base64.h"
+#include "Base64.h"
+#include "NumberParser.h"
 #include "ServerContext.h"
 
 #include <assert.h>
+#include <ctype.h>
 
 typedef struct TypeList TypeList;
 struct TypeList
@@ -32,52 +34,52 @@ static void setBoolean(uintptr_t adr, const char *value)
 
 static void setSByte(uintptr_t adr, const char *value)
 {
-    *(UA_SByte *)adr = (UA_SByte)atoi(value);
+    *(UA_SByte *)adr = (UA_SByte)NumberParser_toInt64(value);
 }
 
 static void setByte(uintptr_t adr, const char *value)
 {
-    *(UA_Byte *)adr = (UA_Byte)atoi(value);
+    *(UA_Byte *)adr = (UA_Byte)NumberParser_toInt64(value);
 }
 
 static void setInt16(uintptr_t adr, const char *value)
 {
-    *(UA_Int16 *)adr = (UA_Int16)atoi(value);
+    *(UA_Int16 *)adr = (UA_Int16)NumberParser_toInt64(value);
 }
 
 static void setUInt16(uintptr_t adr, const char *value)
 {
-    *(UA_UInt16 *)adr = (UA_UInt16)atoi(value);
+    *(UA_UInt16 *)adr = (UA_UInt16)NumberParser_toInt64(value);
 }
 
 static void setInt32(uintptr_t adr, const char *value)
 {
-    *(UA_Int32 *)adr = atoi(value);
+    *(UA_Int32 *)adr = (UA_Int32)NumberParser_toInt64(value);
 }
 
 static void setUInt32(uintptr_t adr, const char *value)
 {
-    *(UA_UInt32 *)adr = (UA_UInt32)atoi(value);
+    *(UA_UInt32 *)adr = (UA_UInt32)NumberParser_toInt64(value);
 }
 
 static void setInt64(uintptr_t adr, const char *value)
 {
-    *(UA_Int64 *)adr = atoi(value);
+    *(UA_Int64 *)adr = NumberParser_toInt64(value);
 }
 
 static void setUInt64(uintptr_t adr, const char *value)
 {
-    *(UA_UInt64 *)adr = (UA_UInt64)atoi(value);
+    *(UA_UInt64 *)adr = NumberParser_toUInt64(value);
 }
 
 static void setFloat(uintptr_t adr, const char *value)
 {
-    *(UA_Float *)adr = (UA_Float)atof(value);
+    *(UA_Float *)adr = NumberParser_toFloat(value);
 }
 
 static void setDouble(uintptr_t adr, const char *value)
 {
-    *(UA_Double *)adr = atof(value);
+    *(UA_Double *)adr = NumberParser_toDouble(value);
 }
 
 static void setString(uintptr_t adr, const char *value)
@@ -225,15 +227,15 @@ static void setNodeId(const NL_Data *value, RawData *data, const ServerContext *
 static void setByteString(const NL_Data* value, RawData*data)
 {
     UA_ByteString *s = (UA_ByteString *)((uintptr_t)data->mem+data->offset);
-    int len = 0;
+    size_t len = 0;
     unsigned char *val = NULL;
 
     if (value->val.primitiveData.value)
     {
-        val = unbase64(value->val.primitiveData.value, (int)strlen(value->val.primitiveData.value), &len);
+        val = Base64_decode(value->val.primitiveData.value, strlen(value->val.primitiveData.value), &len);
     }
 
-    s->length = (size_t)len;
+    s->length = len;
     s->data = val;
 }
 
@@ -463,3 +465,516 @@ void Value_getData(RawData *outData, const NL_Value *value, const UA_DataType *t
         setScalar(value->data, type, outData, customTypes, serverContext);
     }
 }
+
+// nesting of the elements of a value, elements below are ignored
+#define TYPEDVALUE_MAX_DEPTH 32
+#define TYPEDVALUE_INITIAL_CAPACITY 4
+
+typedef enum
+{
+    FRAME_SKIP,
+    // element which holds a value of type at mem
+    FRAME_VALUE,
+    // element of a NodeId, Guid, StatusCode or the switch field of a union
+    // with the value as text
+    FRAME_TEXT,
+    // list of values of type
+    FRAME_ARRAY,
+    FRAME_EXTENSIONOBJECT,
+    FRAME_BODY
+} FrameKind;
+
+typedef struct
+{
+    FrameKind kind;
+    const UA_DataType *type;
+    void *mem;
+    // the namespace index of a qualified name is translated
+    bool translate;
+    // storage of an array
+    size_t *arraySize;
+    void **array;
+    size_t capacity;
+} Frame;
+
+struct TypedValue
+{
+    const UA_DataType *type;
+    const ServerContext *serverContext;
+    // scalar or array of type, owned until it is moved into a variant
+    void *data;
+    size_t arraySize;
+    bool isArray;
+    bool hasData;
+    // open elements, only allocated while the value is parsed
+    Frame *frames;
+    size_t depth;
+    // number of open elements below the maximum depth
+    size_t skipped;
+    TypedValue *next;
+};
+
+// NULL if text is empty or only whitespace
+static const char *notBlank(const char *text)
+{
+    if (!text)
+    {
+        return NULL;
+    }
+    for (const char *c = text; *c != '\0'; c++)
+    {
+        if (!isspace((unsigned char)*c))
+        {
+            return text;
+        }
+    }
+    return NULL;
+}
+
+static bool isTypeSupported(const UA_DataType *type, size_t depth)
+{
+    if (depth > TYPEDVALUE_MAX_DEPTH)
+    {
+        return false;
+    }
+    if (type->typeKind < CONVERSION_TABLE_SIZE ||
+        type->typeKind == UA_DATATYPEKIND_DATETIME ||
+        type->typeKind == UA_DATATYPEKIND_GUID ||
+        type->typeKind == UA_DATATYPEKIND_BYTESTRING ||
+        type->typeKind == UA_DATATYPEKIND_NODEID ||
+        type->typeKind == UA_DATATYPEKIND_STATUSCODE ||
+        type->typeKind == UA_DATATYPEKIND_QUALIFIEDNAME ||
+        type->typeKind == UA_DATATYPEKIND_LOCALIZEDTEXT ||
+        type->typeKind == UA_DATATYPEKIND_ENUM)
+    {
+        return true;
+    }
+    if (type->typeKind != UA_DATATYPEKIND_STRUCTURE &&
+        type->typeKind != UA_DATATYPEKIND_UNION)
+    {
+        return false;
+    }
+    for (const UA_DataTypeMember *m = type->members;
+         m != type->members + type->membersSize; m++)
+    {
+        if (!isTypeSupported(m->memberType, depth + 1))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TypedValue_isSupported(const UA_DataType *type)
+{
+    return type && isTypeSupported(type, 0);
+}
+
+TypedValue *TypedValue_new(const UA_DataType *type,
+                           const ServerContext *serverContext,
+                           TypedValue *next)
+{
+    TypedValue *value = (TypedValue *)calloc(1, sizeof(TypedValue));
+    if (!value)
+    {
+        return NULL;
+    }
+    value->frames = (Frame *)calloc(TYPEDVALUE_MAX_DEPTH, sizeof(Frame));
+    if (!value->frames)
+    {
+        free(value);
+        return NULL;
+    }
+    value->type = type;
+    value->serverContext = serverContext;
+    value->next = next;
+    return value;
+}
+
+static void setFrame(Frame *frame, FrameKind kind, const UA_DataType *type,
+                     void *mem)
+{
+    frame->kind = kind;
+    frame->type = type;
+    frame->mem = mem;
+}
+
+// an array member which is specified more than once keeps the last list
+static void setArrayFrame(Frame *frame, const UA_DataType *type,
+                          size_t *arraySize, void **array)
+{
+    UA_Array_delete(*array, *arraySize, type);
+    *arraySize = 0;
+    *array = NULL;
+    frame->kind = FRAME_ARRAY;
+    frame->type = type;
+    frame->arraySize = arraySize;
+    frame->array = array;
+}
+
+// zeroed element at the end of the array
+static void *appendElement(Frame *frame)
+{
+    const size_t memSize = frame->type->memSize;
+    if (*frame->arraySize == frame->capacity)
+    {
+        size_t capacity = frame->capacity > 0 ? frame->capacity * 2
+                                              : TYPEDVALUE_INITIAL_CAPACITY;
+        char *array = (char *)realloc(*frame->array, capacity * memSize);
+        if (!array)
+        {
+            return NULL;
+        }
+        memset(array + frame->capacity * memSize, 0,
+               (capacity - frame->capacity) * memSize);
+        *frame->array = array;
+        frame->capacity = capacity;
+    }
+    void *element = (char *)*frame->array + *frame->arraySize * memSize;
+    (*frame->arraySize)++;
+    return element;
+}
+
+static void startRoot(TypedValue *value, Frame *frame, const char *name)
+{
+    if (value->hasData)
+    {
+        return;
+    }
+    if (!strncmp(name, "ListOf", strlen("ListOf")))
+    {
+        value->isArray = true;
+        value->hasData = true;
+        setArrayFrame(frame, value->type, &value->arraySize, &value->data);
+        return;
+    }
+    value->data = calloc(1, value->type->memSize);
+    if (!value->data)
+    {
+        return;
+    }
+    value->hasData = true;
+    setFrame(frame,
+             !strcmp(name, "ExtensionObject") ? FRAME_EXTENSIONOBJECT
+                                              : FRAME_VALUE,
+             value->type, value->data);
+}
+
+// member of a structure with the offset of its storage
+static const UA_DataTypeMember *findMember(const UA_DataType *type,
+                                           const char *name, size_t *offset)
+{
+    size_t pos = 0;
+    for (const UA_DataTypeMember *m = type->members;
+         m != type->members + type->membersSize; m++)
+    {
+        pos += m->padding;
+        if (!strcmp(m->memberName, name))
+        {
+            *offset = pos;
+            return m;
+        }
+        pos += m->isArray ? sizeof(size_t) + sizeof(void *)
+                          : m->memberType->memSize;
+    }
+    return NULL;
+}
+
+static void startField(Frame *frame, const UA_DataTypeMember *m, char *mem)
+{
+    if (m->isArray)
+    {
+        setArrayFrame(frame, m->memberType, (size_t *)mem,
+                      (void **)(mem + sizeof(size_t)));
+    }
+    else
+    {
+        setFrame(frame, FRAME_VALUE, m->memberType, mem);
+    }
+}
+
+static void startMember(const Frame *parent, Frame *frame, const char *name)
+{
+    const UA_DataType *type = parent->type;
+    char *mem = (char *)parent->mem;
+    if (type->typeKind == UA_DATATYPEKIND_STRUCTURE)
+    {
+        size_t offset = 0;
+        const UA_DataTypeMember *m = findMember(type, name, &offset);
+        if (m)
+        {
+            startField(frame, m, mem + offset);
+        }
+    }
+    else if (type->typeKind == UA_DATATYPEKIND_UNION)
+    {
+        // the field is selected by the switch field, which is only set once
+        // to keep the union consistent. The padding of the fields is counted
+        // from the start of the union.
+        const UA_UInt32 switchField = *(UA_UInt32 *)mem;
+        if (!strcmp(name, "SwitchField"))
+        {
+            if (switchField == 0)
+            {
+                setFrame(frame, FRAME_TEXT, type, mem);
+            }
+        }
+        else if (switchField != 0)
+        {
+            const UA_DataTypeMember *m = &type->members[switchField - 1];
+            startField(frame, m, mem + m->padding);
+        }
+    }
+    else if (type->typeKind == UA_DATATYPEKIND_LOCALIZEDTEXT)
+    {
+        UA_LocalizedText *lt = (UA_LocalizedText *)parent->mem;
+        if (!strcmp(name, "Locale"))
+        {
+            setFrame(frame, FRAME_VALUE, &UA_TYPES[UA_TYPES_STRING],
+                     &lt->locale);
+        }
+        else if (!strcmp(name, "Text"))
+        {
+            setFrame(frame, FRAME_VALUE, &UA_TYPES[UA_TYPES_STRING],
+                     &lt->text);
+        }
+    }
+    else if (type->typeKind == UA_DATATYPEKIND_QUALIFIEDNAME)
+    {
+        UA_QualifiedName *qn = (UA_QualifiedName *)parent->mem;
+        if (!strcmp(name, "NamespaceIndex"))
+        {
+            setFrame(frame, FRAME_VALUE, &UA_TYPES[UA_TYPES_UINT16],
+                     &qn->namespaceIndex);
+            frame->translate = true;
+        }
+        else if (!strcmp(name, "Name"))
+        {
+            setFrame(frame, FRAME_VALUE, &UA_TYPES[UA_TYPES_STRING],
+                     &qn->name);
+        }
+    }
+    else if ((type->typeKind == UA_DATATYPEKIND_NODEID &&
+              !strcmp(name, "Identifier")) ||
+             (type->typeKind == UA_DATATYPEKIND_GUID &&
+              !strcmp(name, "String")) ||
+             (type->typeKind == UA_DATATYPEKIND_STATUSCODE &&
+              !strcmp(name, "Code")))
+    {
+        setFrame(frame, FRAME_TEXT, type, mem);
+    }
+}
+
+void TypedValue_start(TypedValue *value, const char *name)
+{
+    if (!value->frames)
+    {
+        return;
+    }
+    if (value->skipped > 0 || value->depth == TYPEDVALUE_MAX_DEPTH)
+    {
+        value->skipped++;
+        return;
+    }
+    Frame *parent = value->depth > 0 ? &value->frames[value->depth - 1] : NULL;
+    Frame *frame = &value->frames[value->depth++];
+    memset(frame, 0, sizeof(Frame));
+    frame->kind = FRAME_SKIP;
+    if (!parent)
+    {
+        startRoot(value, frame, name);
+        return;
+    }
+    switch (parent->kind)
+    {
+    case FRAME_ARRAY:
+    {
+        void *element = appendElement(parent);
+        if (element)
+        {
+            setFrame(frame,
+                     !strcmp(name, "ExtensionObject") ? FRAME_EXTENSIONOBJECT
+                                                      : FRAME_VALUE,
+                     parent->type, element);
+        }
+        break;
+    }
+    case FRAME_EXTENSIONOBJECT:
+        // the type of the body is given by the data type of the variable
+        if (!strcmp(name, "Body"))
+        {
+            setFrame(frame, FRAME_BODY, parent->type, parent->mem);
+        }
+        break;
+    case FRAME_BODY:
+        setFrame(frame, FRAME_VALUE, parent->type, parent->mem);
+        break;
+    case FRAME_VALUE:
+        startMember(parent, frame, name);
+        break;
+    case FRAME_TEXT:
+    case FRAME_SKIP:
+        break;
+    }
+}
+
+static void decodeInnerText(const TypedValue *value, const Frame *frame,
+                            const char *text)
+{
+    const UA_DataType *type = frame->type;
+    void *mem = frame->mem;
+    if (type->typeKind == UA_DATATYPEKIND_NODEID)
+    {
+        UA_NodeId *id = (UA_NodeId *)mem;
+        UA_NodeId_clear(id);
+        *id = extractNodeId((char *)(uintptr_t)text);
+        id->namespaceIndex = ServerContext_translateToServerIdx(
+            value->serverContext, id->namespaceIndex);
+    }
+    else if (type->typeKind == UA_DATATYPEKIND_GUID)
+    {
+        *(UA_Guid *)mem = UA_GUID(text);
+    }
+    else if (type->typeKind == UA_DATATYPEKIND_UNION)
+    {
+        setUInt32((uintptr_t)mem, text);
+        if (*(UA_UInt32 *)mem > type->membersSize)
+        {
+            *(UA_UInt32 *)mem = 0;
+        }
+    }
+    else
+    {
+        setUInt32((uintptr_t)mem, text);
+    }
+}
+
+static void decodeText(const TypedValue *value, const Frame *frame,
+                       const char *text)
+{
+    const UA_DataType *type = frame->type;
+    void *mem = frame->mem;
+    if (frame->kind == FRAME_TEXT)
+    {
+        decodeInnerText(value, frame, text);
+    }
+    else if (type->typeKind < CONVERSION_TABLE_SIZE)
+    {
+        UA_clear(mem, type);
+        conversionTable[type->typeKind]((uintptr_t)mem, text);
+        if (frame->translate)
+        {
+            *(UA_UInt16 *)mem = ServerContext_translateToServerIdx(
+                value->serverContext, *(UA_UInt16 *)mem);
+        }
+    }
+    else if (type->typeKind == UA_DATATYPEKIND_DATETIME)
+    {
+        *(UA_DateTime *)mem = UA_DateTime_fromString(text);
+    }
+    else if (type->typeKind == UA_DATATYPEKIND_BYTESTRING)
+    {
+        UA_ByteString *s = (UA_ByteString *)mem;
+        UA_ByteString_clear(s);
+        s->data = Base64_decode(text, strlen(text), &s->length);
+    }
+    else if (type->typeKind == UA_DATATYPEKIND_ENUM)
+    {
+        setInt32((uintptr_t)mem, getEnumValuePos(text));
+    }
+}
+
+void TypedValue_end(TypedValue *value, const char *name, const char *text)
+{
+    if (value->skipped > 0)
+    {
+        value->skipped--;
+        return;
+    }
+    if (value->depth == 0)
+    {
+        return;
+    }
+    const Frame *frame = &value->frames[--value->depth];
+    text = notBlank(text);
+    if (text && (frame->kind == FRAME_VALUE || frame->kind == FRAME_TEXT))
+    {
+        decodeText(value, frame, text);
+    }
+}
+
+void TypedValue_finish(TypedValue *value)
+{
+    free(value->frames);
+    value->frames = NULL;
+    value->depth = 0;
+}
+
+bool TypedValue_isArray(const TypedValue *value)
+{
+    return value->isArray;
+}
+
+size_t TypedValue_arraySize(const TypedValue *value)
+{
+    return value->arraySize;
+}
+
+bool TypedValue_setVariant(const TypedValue *value, UA_Variant *variant)
+{
+    if (!value->hasData)
+    {
+        return false;
+    }
+    if (value->isArray)
+    {
+        // NULL data would be no value instead of an empty array
+        UA_Variant_setArray(variant,
+                            value->arraySize ? value->data
+                                             : UA_EMPTY_ARRAY_SENTINEL,
+                            value->arraySize, value->type);
+    }
+    else
+    {
+        UA_Variant_setScalar(variant, value->data, value->type);
+    }
+    variant->storageType = UA_VARIANT_DATA_NODELETE;
+    return true;
+}
+
+bool TypedValue_moveTo(TypedValue *value, UA_Variant *variant)
+{
+    if (!TypedValue_setVariant(value, variant))
+    {
+        return false;
+    }
+    variant->storageType = UA_VARIANT_DATA;
+    if (value->isArray && !value->arraySize)
+    {
+        free(value->data);
+    }
+    value->data = NULL;
+    value->arraySize = 0;
+    value->isArray = false;
+    value->hasData = false;
+    return true;
+}
+
+void TypedValue_delete(TypedValue *value)
+{
+    while (value)
+    {
+        TypedValue *tmp = value;
+        value = value->next;
+        if (tmp->isArray)
+        {
+            UA_Array_delete(tmp->data, tmp->arraySize, tmp->type);
+        }
+        else if (tmp->data)
+        {
+            UA_delete(tmp->data, tmp->type);
+        }
+        free(tmp->frames);
+        free(tmp);
+    }
+}
@@ -27,4 +27,28 @@ void RawData_delete(RawData *data);
 
 void Value_getData(RawData *outData, const NL_Value *value, const UA_DataType* type, const UA_DataType* customTypes, const struct ServerContext *serverContext);
 
+// value which is decoded into the memory of its data type while it is parsed,
+// see NL_ValueInterface. Values are chained with next to release them
+// together.
+struct TypedValue;
+typedef struct TypedValue TypedValue;
+// false if values of type are decoded with Value_getData
+bool TypedValue_isSupported(const UA_DataType *type);
+TypedValue *TypedValue_new(const UA_DataType *type,
+                           const struct ServerContext *serverContext,
+                           TypedValue *next);
+void TypedValue_start(TypedValue *value, const char *name);
+void TypedValue_end(TypedValue *value, const char *name, const char *text);
+// releases the state which is only needed while parsing
+void TypedValue_finish(TypedValue *value);
+bool TypedValue_isArray(const TypedValue *value);
+size_t TypedValue_arraySize(const TypedValue *value);
+// points variant to the decoded data, which stays owned by value, so it can be
+// passed to the server more than once. False if nothing was decoded
+bool TypedValue_setVariant(const TypedValue *value, UA_Variant *variant);
+// hands the decoded data over to variant, false if nothing was decoded
+bool TypedValue_moveTo(TypedValue *value, UA_Variant *variant);
+// deletes value and all values which are chained to it
+void TypedValue_delete(TypedValue *value);
+
 #endif
@@ -15,6 +15,7 @@
 #include "ServerContext.h"
 #include "conversion.h"
 #include "NodesetLoader/NodesetLoader.h"
+#include "Ns0Tables.h"
 #include "RefServiceImpl.h"
 #include "nodes/NodeContainer.h"
 
@@ -61,6 +62,13 @@ static UA_NodeId getParentType(UA_Server *server, const UA_NodeId dataTypeId)
     UA_NodeId current = dataTypeId;
     while (!isKnownParent(current))
     {
+        // the server is only browsed for data types of other namespaces
+        const Ns0Tables_DataType *ns0Type = Ns0Tables_findDataType(&current);
+        if (ns0Type)
+        {
+            current = UA_NODEID_NUMERIC(0, ns0Type->superType);
+            continue;
+        }
         current = getParentDataType(server, current);
     }
     return current;
@@ -125,7 +133,7 @@ handleObjectNode(const NL_ObjectNode *node, UA_NodeId *id,
     UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
     oAttr.displayName = *lt;
     oAttr.description = *description;
-    oAttr.eventNotifier = (UA_Byte)atoi(node->eventNotifier);
+    oAttr.eventNotifier = node->eventNotifier;
 
     UA_NodeId typeDefId = UA_NODEID_NULL;
     if (node->refToTypeDef)
@@ -150,8 +158,9 @@ handleViewNode(const NL_ViewNode *node, UA_NodeId *id, const UA_NodeId *parentId
     UA_ViewAttributes attr = UA_ViewAttributes_default;
     attr.displayName = *lt;
     attr.description = *description;
-    attr.eventNotifier = (UA_Byte)atoi(node->eventNotifier);
-    attr.containsNoLoops = isValTrue(node->containsNoLoops);
+    attr.eventNotifier = node->eventNotifier;
+    attr.containsNoLoops =
+        (node->flags & NL_NODEFLAG_CONTAINSNOLOOPS) != 0;
     return UA_Server_addViewNode(server, *id, *parentId, *parentReferenceId, *qn, attr,
                           node->extension, NULL);
 }
@@ -163,8 +172,9 @@ handleMethodNode(const NL_MethodNode *node, UA_NodeId *id,
                  const UA_LocalizedText *description, UA_Server *server)
 {
     UA_MethodAttributes attr = UA_MethodAttributes_default;
-    attr.executable = isValTrue(node->executable);
-    attr.userExecutable = isValTrue(node->userExecutable);
+    attr.executable = (node->flags & NL_NODEFLAG_EXECUTABLE) != 0;
+    attr.userExecutable =
+        (node->flags & NL_NODEFLAG_USEREXECUTABLE) != 0;
     attr.displayName = *lt;
     attr.description = *description;
 
@@ -199,6 +209,29 @@ static size_t getArrayDimensions(const char *s, UA_UInt32 **dims)
     return arrSize;
 }
 
+// data type of values, parent types are only looked up in the server if
+// withParent is set, the types of a nodeset are not yet part of the server
+// while it is parsed
+static const UA_DataType *findDataType(const ServerContext *serverContext,
+                                       const UA_NodeId *dataTypeId,
+                                       bool withParent)
+{
+    UA_Server *server = ServerContext_getServerObject(serverContext);
+    const UA_DataType *dataType = UA_findDataType(dataTypeId);
+    if (!dataType)
+    {
+        // try it with custom types
+        dataType = NodesetLoader_getCustomDataType(server, dataTypeId);
+    }
+    if (!dataType && withParent)
+    {
+        // try it with parent
+        const UA_NodeId parent = getParentType(server, *dataTypeId);
+        dataType = UA_findDataType(&parent);
+    }
+    return dataType;
+}
+
 static UA_StatusCode handleVariableNode(const NL_VariableNode *node, UA_NodeId *id,
                                const UA_NodeId *parentId,
                                const UA_NodeId *parentReferenceId,
@@ -210,16 +243,16 @@ static UA_StatusCode handleVariableNode(const NL_VariableNode *node, UA_NodeId *
     UA_VariableAttributes attr = UA_VariableAttributes_default;
     attr.displayName = *lt;
     attr.dataType = node->datatype;
-    attr.valueRank = atoi(node->valueRank);
+    attr.valueRank = node->valueRank;
     UA_UInt32 *arrDims = NULL;
     attr.arrayDimensionsSize =
         getArrayDimensions(node->arrayDimensions, &arrDims);
     attr.arrayDimensions = arrDims;
-    attr.accessLevel = (UA_Byte)atoi(node->accessLevel);
-    attr.userAccessLevel = (UA_Byte)atoi(node->userAccessLevel);
+    attr.accessLevel = node->accessLevel;
+    attr.userAccessLevel = node->userAccessLevel;
     attr.description = *description;
-    attr.historizing = isValTrue(node->historizing);
-    attr.minimumSamplingInterval = atof(node->minimumSamplingInterval);
+    attr.historizing = (node->flags & NL_NODEFLAG_HISTORIZING) != 0;
+    attr.minimumSamplingInterval = node->minimumSamplingInterval;
 
     // this case is only needed for the euromap83 comparison, think the nodeset
     // is not valid
@@ -230,7 +263,20 @@ static UA_StatusCode handleVariableNode(const NL_VariableNode *node, UA_NodeId *
         *attr.arrayDimensions = 0;
     }
 
-    if (attr.arrayDimensionsSize == 0 && node->value && node->value->isArray)
+    // values which are kept as xml by the loader are decoded here
+    NL_Value_decode(node->value);
+    // values which were decoded while parsing
+    TypedValue *typedValue =
+        node->value ? (TypedValue *)node->value->decoder : NULL;
+    if (attr.arrayDimensionsSize == 0 && typedValue &&
+        TypedValue_isArray(typedValue))
+    {
+        attr.arrayDimensions = UA_UInt32_new();
+        *attr.arrayDimensions = (UA_UInt32)TypedValue_arraySize(typedValue);
+        attr.arrayDimensionsSize = 1;
+    }
+    else if (attr.arrayDimensionsSize == 0 && node->value &&
+             node->value->isArray)
     {
         attr.arrayDimensions = UA_UInt32_new();
         *attr.arrayDimensions =
@@ -238,20 +284,15 @@ static UA_StatusCode handleVariableNode(const NL_VariableNode *node, UA_NodeId *
         attr.arrayDimensionsSize = 1;
     }
     RawData *data = NULL;
-    if (node->value && node->value->data != NULL)
+    if (typedValue)
     {
-        const UA_DataType *dataType = UA_findDataType(&attr.dataType);
-        if (!dataType)
-        {
-            // try it with custom types
-            dataType = NodesetLoader_getCustomDataType(ServerContext_getServerObject(serverContext), &attr.dataType);
-            // try it with parent
-            if (!dataType)
-            {
-                const UA_NodeId parent = getParentType(ServerContext_getServerObject(serverContext), attr.dataType);
-                dataType = UA_findDataType(&parent);
-            }
-        }
+        // the value stays with the decoder, a node which fails is retried
+        TypedValue_setVariant(typedValue, &attr.value);
+    }
+    else if (node->value && node->value->data != NULL)
+    {
+        const UA_DataType *dataType =
+            findDataType(serverContext, &attr.dataType, true);
 
         UA_ServerConfig *config = UA_Server_getConfig(ServerContext_getServerObject(serverContext));
         const UA_DataTypeArray *types = config->customDataTypes;
@@ -263,9 +304,10 @@ static UA_StatusCode handleVariableNode(const NL_VariableNode *node, UA_NodeId *
         {
             if (node->value->isArray)
             {
-                UA_Variant_setArray(
-                    &attr.value, data->mem,
-                    node->value->data->val.complexData.membersSize, dataType);
+                size_t size = node->value->data->val.complexData.membersSize;
+                UA_Variant_setArray(&attr.value,
+                                    size ? data->mem : UA_EMPTY_ARRAY_SENTINEL,
+                                    size, dataType);
             }
             else
             {
@@ -303,7 +345,7 @@ static UA_StatusCode handleObjectTypeNode(const NL_ObjectTypeNode *node, UA_Node
 {
     UA_ObjectTypeAttributes oAttr = UA_ObjectTypeAttributes_default;
     oAttr.displayName = *lt;
-    oAttr.isAbstract = isValTrue(node->isAbstract);
+    oAttr.isAbstract = (node->flags & NL_NODEFLAG_ISABSTRACT) != 0;
     oAttr.description = *description;
 
     return UA_Server_addObjectTypeNode(server, *id, *parentId, *parentReferenceId, *qn,
@@ -319,7 +361,7 @@ static UA_StatusCode handleReferenceTypeNode(const NL_ReferenceTypeNode *node,
                                     UA_Server *server)
 {
     UA_ReferenceTypeAttributes attr = UA_ReferenceTypeAttributes_default;
-    attr.symmetric = isValTrue(node->symmetric);
+    attr.symmetric = (node->flags & NL_NODEFLAG_SYMMETRIC) != 0;
     attr.displayName = *lt;
     attr.description = *description;
     attr.inverseName =
@@ -341,8 +383,8 @@ static UA_StatusCode handleVariableTypeNode(const NL_VariableTypeNode *node, UA_
     attr.displayName = *lt;
     attr.dataType = node->datatype;
     attr.description = *description;
-    attr.valueRank = atoi(node->valueRank);
-    attr.isAbstract = isValTrue(node->isAbstract);
+    attr.valueRank = node->valueRank;
+    attr.isAbstract = (node->flags & NL_NODEFLAG_ISABSTRACT) != 0;
     if (attr.valueRank >= 0)
     {
         if (!strcmp(node->arrayDimensions, ""))
@@ -371,7 +413,7 @@ static UA_StatusCode handleDataTypeNode(const NL_DataTypeNode *node, UA_NodeId *
     UA_DataTypeAttributes attr = UA_DataTypeAttributes_default;
     attr.displayName = *lt;
     attr.description = *description;
-    attr.isAbstract = isValTrue(node->isAbstract);
+    attr.isAbstract = (node->flags & NL_NODEFLAG_ISABSTRACT) != 0;
 
     return UA_Server_addDataTypeNode(server, *id, *parentId, *parentReferenceId, *qn,
                               attr, node->extension, NULL);
@@ -380,7 +422,12 @@ static UA_StatusCode handleDataTypeNode(const NL_DataTypeNode *node, UA_NodeId *
 struct AddNodeContext
 {
     ServerContext* serverContext;
-    NodeContainer* problemNodes;
+    // node classes which are added in the current pass
+    bool addClass[NL_NODECLASS_COUNT];
+    size_t addedCnt;
+    size_t failedCnt;
+    // nodes which couldn't be added, they are retried after the last pass
+    NodeContainer *problemNodes;
 };
 
 typedef struct AddNodeContext AddNodeContext;
@@ -441,11 +488,29 @@ static void addNodeImpl(AddNodeContext *context, NL_Node *node)
                                          &parentReferenceId, &lt, &qn, &description, ServerContext_getServerObject(context->serverContext));
         break;
     }
-    // If a node was not added to the server due to an error, we add such a node
-    // to a special node container. We can then try to add such nodes later.
-    if(context->problemNodes != NULL && UA_StatusCode_isBad(addedNodeStatus))
+    if (UA_StatusCode_isBad(addedNodeStatus))
     {
-        NodeContainer_add(context->problemNodes, node);
+        context->failedCnt++;
+        if (context->problemNodes)
+        {
+            NodeContainer_add(context->problemNodes, node);
+        }
+    }
+    else
+    {
+        context->addedCnt++;
+    }
+}
+
+static void addLevel(AddNodeContext *context, size_t level, NL_Node **nodes,
+                     size_t nodeCount)
+{
+    for (size_t i = 0; i < nodeCount; i++)
+    {
+        if (context->addClass[nodes[i]->nodeClass])
+        {
+            addNodeImpl(context, nodes[i]);
+        }
     }
 }
 
@@ -484,32 +549,60 @@ static void logToOpen(void *context, enum NodesetLoader_LogLevel level,
     va_end(vl);
 }
 
-struct DataTypeImportCtx
+struct EncodingRefCtx
 {
-    DataTypeImporter *importer;
+    NodesetLoader *loader;
     const NL_BiDirectionalReference *hasEncodingRef;
-    UA_Server *server;
+    bool failed;
 };
 
-static void addDataType(struct DataTypeImportCtx *ctx, NL_Node *node)
+static void addEncodingRef(struct EncodingRefCtx *ctx, NL_Node *node)
 {
-    // add only the types
     const NL_BiDirectionalReference *r = ctx->hasEncodingRef;
     while (r)
     {
         if (UA_NodeId_equal(&r->source, &node->id))
         {
-            NL_Reference *ref = (NL_Reference *)calloc(1, sizeof(NL_Reference));
-            ref->refType = r->refType;
-            ref->target = r->target;
+            NL_Reference *ref = NodesetLoader_newReference(ctx->loader);
+            if (!ref)
+            {
+                ctx->failed = true;
+                return;
+            }
+            UA_NodeId_copy(&r->refType, &ref->refType);
+            UA_NodeId_copy(&r->target, &ref->target);
+            ref->isForward = true;
 
             NL_Reference *lastRef = node->nonHierachicalRefs;
             node->nonHierachicalRefs = ref;
             ref->next = lastRef;
-            break;
+            return;
         }
         r = r->next;
     }
+}
+
+// the data types get the forward HasEncoding references of their encoding
+// nodes, this has to happen before the references are compacted
+static bool addEncodingRefs(NodesetLoader *loader)
+{
+    struct EncodingRefCtx ctx;
+    ctx.loader = loader;
+    ctx.hasEncodingRef = NodesetLoader_getBidirectionalRefs(loader);
+    ctx.failed = false;
+    NodesetLoader_forEachNode(loader, NODECLASS_DATATYPE, &ctx,
+                              (NodesetLoader_forEachNode_Func)addEncodingRef);
+    return !ctx.failed;
+}
+
+struct DataTypeImportCtx
+{
+    DataTypeImporter *importer;
+    UA_Server *server;
+};
+
+static void addDataType(struct DataTypeImportCtx *ctx, NL_Node *node)
+{
     const UA_NodeId parent =
         getParentType(ctx->server, node->id);
     DataTypeImporter_addCustomDataType(ctx->importer, (NL_DataTypeNode *)node,
@@ -519,11 +612,8 @@ static void addDataType(struct DataTypeImportCtx *ctx, NL_Node *node)
 static void importDataTypes(NodesetLoader *loader, UA_Server *server)
 {
     // add datatypes
-    const NL_BiDirectionalReference *hasEncodingRef =
-        NodesetLoader_getBidirectionalRefs(loader);
     DataTypeImporter *importer = DataTypeImporter_new(server);
     struct DataTypeImportCtx ctx;
-    ctx.hasEncodingRef = hasEncodingRef;
     ctx.server = server;
     ctx.importer = importer;
     NodesetLoader_forEachNode(loader, NODECLASS_DATATYPE, &ctx,
@@ -535,123 +625,122 @@ static void importDataTypes(NodesetLoader *loader, UA_Server *server)
 
 static void addNonHierachicalRefs(UA_Server *server, NL_Node *node)
 {
-    NL_Reference *ref = node->nonHierachicalRefs;
-    while (ref)
+    // the references are compacted, the non hierachical ones follow the
+    // hierachical ones in the same array
+    size_t size = 0;
+    const NL_Reference *refs = NodesetLoader_getNonHierachicalRefs(node, &size);
+    for (size_t i = 0; i < size; i++)
     {
-
-        UA_NodeId src = node->id;
         UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NULL;
-        target.nodeId = ref->target;
-        UA_NodeId refType = ref->refType;
-        UA_Server_addReference(server, src, refType, target, ref->isForward);
-        ref = ref->next;
+        target.nodeId = refs[i].target;
+        UA_Server_addReference(server, node->id, refs[i].refType, target,
+                               refs[i].isForward);
     }
     // brute force, maybe not the best way to do this
-    ref = node->hierachicalRefs;
-    while (ref)
+    refs = NodesetLoader_getHierachicalRefs(node, &size);
+    for (size_t i = 0; i < size; i++)
     {
-        UA_NodeId src = node->id;
         UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NULL;
-        target.nodeId = ref->target;
-        UA_NodeId refType = ref->refType;
-        UA_Server_addReference(server, src, refType, target, ref->isForward);
-        ref = ref->next;
+        target.nodeId = refs[i].target;
+        UA_Server_addReference(server, node->id, refs[i].refType, target,
+                               refs[i].isForward);
     }
 }
 
-static size_t secondChanceAddNodes(ServerContext *serverContext,
-                                   NodeContainer **badStatusNodes,
-                                   const NodesetLoader_Logger *logger)
+static void addPass(NodesetLoader *loader, AddNodeContext *context,
+                    const char *name, const NL_NodeClass *classes,
+                    size_t classCnt, const NodesetLoader_Logger *logger)
 {
-    const size_t attemptsNum = 10;
+    for (size_t i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        context->addClass[i] = false;
+    }
+    for (size_t i = 0; i < classCnt; i++)
+    {
+        context->addClass[classes[i]] = true;
+    }
+    size_t added = context->addedCnt;
+    size_t failed = context->failedCnt;
+    NodesetLoader_forEachLevel(loader, context,
+                               (NodesetLoader_forEachLevel_Func)addLevel);
+    logger->log(logger->context, NODESETLOADER_LOGLEVEL_DEBUG,
+                "imported %s: %zu, failed: %zu", name,
+                context->addedCnt - added, context->failedCnt - failed);
+}
 
-    size_t numberOfAllAddedNodes = 0;
-    // We will try to add all failed nodes in a certain number of attempts.
-    // This gives us the opportunity to add a chain like Object(child) ->
-    // Variable(parent).
-    // For example, this reference is used in the HasHistoricalConfiguration
-    // reference type.
+// The passes don't cover every dependency, e.g. an object type organized
+// below an object of the nodeset is added before its parent. The failed nodes
+// are added again in their sorted order as long as the number of failed nodes
+// goes down.
+static void retryFailedNodes(AddNodeContext *context,
+                             const NodesetLoader_Logger *logger)
+{
     size_t attempt = 1;
-    while (attempt != attemptsNum && (*badStatusNodes)->size != 0)
-    {
-        NodeContainer *local_badStatusNodes =
-            NodeContainer_new((*badStatusNodes)->size, false);
-        AddNodeContext context;
-        context.problemNodes = local_badStatusNodes;
-        context.serverContext = serverContext;
-        for (size_t counter = 0; counter < (*badStatusNodes)->size; counter++)
+    while (context->problemNodes && context->problemNodes->size)
+    {
+        NodeContainer *failedNodes = context->problemNodes;
+        context->problemNodes = NodeContainer_new(failedNodes->size, false);
+        // the retried nodes are counted again
+        size_t retried = failedNodes->size;
+        context->failedCnt -= retried;
+        size_t failedBefore = context->failedCnt;
+        for (size_t i = 0; i < retried; i++)
         {
-            // Import to server again
-            addNodeImpl(&context, (*badStatusNodes)->nodes[counter]);
+            addNodeImpl(context, failedNodes->nodes[i]);
         }
-        size_t counterOfAdddedNodesForOneAttempt =
-            (*badStatusNodes)->size - local_badStatusNodes->size;
-        numberOfAllAddedNodes += counterOfAdddedNodesForOneAttempt;
+        size_t added = retried - (context->failedCnt - failedBefore);
         logger->log(logger->context, NODESETLOADER_LOGLEVEL_DEBUG,
-                    "attempt (%zu), imported nodes: %zu", attempt,
-                    counterOfAdddedNodesForOneAttempt);
-        NodeContainer_delete((*badStatusNodes));
-        (*badStatusNodes) = local_badStatusNodes;
+                    "attempt (%zu), imported nodes: %zu", attempt, added);
+        NodeContainer_delete(failedNodes);
+        if (!added)
+        {
+            break;
+        }
         attempt++;
     }
-    return numberOfAllAddedNodes;
 }
 
 static void addNodes(NodesetLoader *loader, ServerContext *serverContext,
                      NodesetLoader_Logger *logger)
 {
-    const NL_NodeClass order[NL_NODECLASS_COUNT] = {
-        NODECLASS_REFERENCETYPE, NODECLASS_DATATYPE, NODECLASS_OBJECTTYPE,
-        NODECLASS_VARIABLETYPE,  NODECLASS_OBJECT,   NODECLASS_METHOD,
-        NODECLASS_VARIABLE,      NODECLASS_VIEW};
-    const size_t containerInitialSize = 100;
-
-    // If we have a problem adding nodes to the server, let's add references
-    // to these nodes to the container.
-    NodeContainer* badStatusNodes = NodeContainer_new(containerInitialSize, false);
-    // Since every cycle we add one node class we need to save
-    // counter of previous badStatusNodes because badStatusNodes
-    // will always be adding new bad nodes to one list, and we have to calculate
-    // the real number of bad status nodes on every single cycle.
-    size_t previous_loop_badStatusNodes_size = 0;
+    // Within a pass the nodes are added level by level, so every node is added
+    // after the nodes of the same pass it depends on hierachically (cycles
+    // were already broken by the sort). The passes keep the types in front of
+    // the instances: the custom data types are needed for the values of
+    // variable types and variables, the type definitions for the instances.
+    // Nodes which depend on a node of a later pass fail and are retried.
+    const NL_NodeClass dataTypePass[] = {NODECLASS_REFERENCETYPE,
+                                         NODECLASS_DATATYPE};
+    const NL_NodeClass typePass[] = {NODECLASS_OBJECTTYPE,
+                                     NODECLASS_VARIABLETYPE};
+    const NL_NodeClass instancePass[] = {NODECLASS_OBJECT, NODECLASS_METHOD,
+                                         NODECLASS_VARIABLE, NODECLASS_VIEW};
 
     AddNodeContext context;
-    context.problemNodes = badStatusNodes;
     context.serverContext = serverContext;
-    for (size_t i = 0; i < NL_NODECLASS_COUNT; i++)
-    {
-        const NL_NodeClass classToImport = order[i];
-        size_t cnt =
-            NodesetLoader_forEachNode(loader, classToImport, &context,
-                                      (NodesetLoader_forEachNode_Func)addNodeImpl);
-        if (classToImport == NODECLASS_DATATYPE)
-        {
-            importDataTypes(loader, ServerContext_getServerObject(serverContext));
-        }
-
-        // Now we can see the nodes that could not be added and can calculate
-        // and show the actual nodes added.
-        logger->log(logger->context, NODESETLOADER_LOGLEVEL_DEBUG,
-                    "imported %ss: %zu", NL_NODECLASS_NAME[classToImport],
-                    cnt - (badStatusNodes->size - previous_loop_badStatusNodes_size));
-        previous_loop_badStatusNodes_size = badStatusNodes->size;
-    }
-
-    // second chance algorithm
-    if (badStatusNodes->size != 0)
+    context.addedCnt = 0;
+    context.failedCnt = 0;
+    context.problemNodes = NodeContainer_new(100, false);
+    addPass(loader, &context, "reference and data types", dataTypePass,
+            sizeof(dataTypePass) / sizeof(dataTypePass[0]), logger);
+    importDataTypes(loader, ServerContext_getServerObject(serverContext));
+    addPass(loader, &context, "object and variable types", typePass,
+            sizeof(typePass) / sizeof(typePass[0]), logger);
+    addPass(loader, &context, "instances", instancePass,
+            sizeof(instancePass) / sizeof(instancePass[0]), logger);
+    retryFailedNodes(&context, logger);
+    NodeContainer_delete(context.problemNodes);
+
+    if (context.failedCnt != 0)
     {
         logger->log(logger->context, NODESETLOADER_LOGLEVEL_WARNING,
-                    "Couldn't import: %zu. Let's try adding non-imported "
-                    "nodes a few more times.", badStatusNodes->size);
-        size_t numberOfAllAddedNodes =
-            secondChanceAddNodes(serverContext, &badStatusNodes, logger);
-        logger->log(logger->context, NODESETLOADER_LOGLEVEL_WARNING,
-                    "imported after attempts: %zu", numberOfAllAddedNodes);
+                    "Couldn't import: %zu", context.failedCnt);
     }
 
-    // Delete only reference and container. Not NL_Nodes objects.
-    NodeContainer_delete(badStatusNodes);
-
+    const NL_NodeClass order[NL_NODECLASS_COUNT] = {
+        NODECLASS_REFERENCETYPE, NODECLASS_DATATYPE, NODECLASS_OBJECTTYPE,
+        NODECLASS_VARIABLETYPE,  NODECLASS_OBJECT,   NODECLASS_METHOD,
+        NODECLASS_VARIABLE,      NODECLASS_VIEW};
     for (size_t i = 0; i < NL_NODECLASS_COUNT; i++)
     {
         const NL_NodeClass classToImport = order[i];
@@ -661,18 +750,51 @@ static void addNodes(NodesetLoader *loader, ServerContext *serverContext,
     }
 }
 
-bool NodesetLoader_loadFile(struct UA_Server *server, const char *path,
-                            NodesetLoader_ExtensionInterface *extensionHandling)
+// values of variables which are decoded while the nodeset is parsed
+typedef struct
 {
-    if (!server)
+    const ServerContext *serverContext;
+    TypedValue *values;
+} ValueDecoding;
+
+static void *newTypedValue(void *context, const NL_VariableNode *node)
+{
+    ValueDecoding *decoding = (ValueDecoding *)context;
+    const UA_DataType *type =
+        findDataType(decoding->serverContext, &node->datatype, false);
+    if (!TypedValue_isSupported(type))
     {
-        return false;
+        return NULL;
     }
-    if (!path)
+    TypedValue *value =
+        TypedValue_new(type, decoding->serverContext, decoding->values);
+    if (value)
     {
-        return false;
+        decoding->values = value;
     }
+    return value;
+}
+
+static void startTypedValue(void *value, const char *name)
+{
+    TypedValue_start((TypedValue *)value, name);
+}
+
+static void endTypedValue(void *value, const char *name, const char *text)
+{
+    TypedValue_end((TypedValue *)value, name, text);
+}
 
+static void finishTypedValue(void *value)
+{
+    TypedValue_finish((TypedValue *)value);
+}
+
+static bool loadNodeset(struct UA_Server *server, const char *path,
+                        const char *buffer, size_t size,
+                        NodesetLoader_ExtensionInterface *extensionHandling,
+                        NodesetLoader_ReferenceTypeCache *refTypeCache)
+{
     ServerContext *serverContext = ServerContext_new(server);
 
     NL_FileContext handler;
@@ -690,17 +812,48 @@ bool NodesetLoader_loadFile(struct UA_Server *server, const char *path,
     logger->context = (void*)(uintptr_t)config->logging;
 #endif
     logger->log = &logToOpen;
-    NL_ReferenceService *refService = RefServiceImpl_new(server);
+    // a cache of another server would classify the reference types wrongly
+    if (refTypeCache && !RefServiceImpl_isCacheOf(refTypeCache, server))
+    {
+        logger->log(logger->context, NODESETLOADER_LOGLEVEL_ERROR,
+                    "the reference type cache belongs to another server");
+        ServerContext_delete(serverContext);
+        free(logger);
+        return false;
+    }
+    NL_ReferenceService *refService =
+        RefServiceImpl_new(server, refTypeCache);
 
     NodesetLoader *loader = NodesetLoader_new(logger, refService);
-    logger->log(logger->context, NODESETLOADER_LOGLEVEL_DEBUG,
-                "Start import nodeset: %s", path);
-    bool importStatus = NodesetLoader_importFile(loader, &handler);
-    bool sortStatus = NodesetLoader_sort(loader);
+    // nodes of other namespaces are already part of the server
+    NodesetLoader_setPruneUnloadedNamespaces(loader, true);
+    ValueDecoding decoding = {serverContext, NULL};
+    const NL_ValueInterface valueInterface = {
+        &decoding, newTypedValue, startTypedValue, endTypedValue,
+        finishTypedValue};
+    NodesetLoader_setValueInterface(loader, &valueInterface);
+    bool importStatus = false;
+    if (buffer)
+    {
+        logger->log(logger->context, NODESETLOADER_LOGLEVEL_DEBUG,
+                    "Start import nodeset from buffer (%zu bytes)", size);
+        importStatus =
+            NodesetLoader_importBuffer(loader, &handler, buffer, size);
+    }
+    else
+    {
+        logger->log(logger->context, NODESETLOADER_LOGLEVEL_DEBUG,
+                    "Start import nodeset: %s", path);
+        importStatus = NodesetLoader_importFile(loader, &handler);
+    }
+    bool sortStatus =
+        NodesetLoader_sort(loader) && addEncodingRefs(loader) &&
+        NodesetLoader_compactReferences(loader);
     bool retStatus = importStatus && sortStatus;
     if (retStatus && sortStatus)
     {
         addNodes(loader, serverContext, logger);
+        RefServiceImpl_commit(refService);
     }
     else
     {
@@ -709,7 +862,61 @@ bool NodesetLoader_loadFile(struct UA_Server *server, const char *path,
     }
     RefServiceImpl_delete(refService);
     NodesetLoader_delete(loader);
+    TypedValue_delete(decoding.values);
     ServerContext_delete(serverContext);
     free(logger);
     return retStatus;
 }
+
+bool NodesetLoader_loadFile(struct UA_Server *server, const char *path,
+                            NodesetLoader_ExtensionInterface *extensionHandling)
+{
+    if (!server)
+    {
+        return false;
+    }
+    if (!path)
+    {
+        return false;
+    }
+    return loadNodeset(server, path, NULL, 0, extensionHandling, NULL);
+}
+
+bool NodesetLoader_loadBuffer(struct UA_Server *server, const char *buffer,
+                              size_t size,
+                              NodesetLoader_ExtensionInterface *extensionHandling)
+{
+    if (!server)
+    {
+        return false;
+    }
+    if (!buffer || size == 0)
+    {
+        return false;
+    }
+    return loadNodeset(server, NULL, buffer, size, extensionHandling, NULL);
+}
+
+bool NodesetLoader_loadFileWithCache(
+    struct UA_Server *server, const char *path,
+    NodesetLoader_ExtensionInterface *extensionHandling,
+    NodesetLoader_ReferenceTypeCache *cache)
+{
+    if (!server || !path || !cache)
+    {
+        return false;
+    }
+    return loadNodeset(server, path, NULL, 0, extensionHandling, cache);
+}
+
+bool NodesetLoader_loadBufferWithCache(
+    struct UA_Server *server, const char *buffer, size_t size,
+    NodesetLoader_ExtensionInterface *extensionHandling,
+    NodesetLoader_ReferenceTypeCache *cache)
+{
+    if (!server || !buffer || size == 0 || !cache)
+    {
+        return false;
+    }
+    return loadNodeset(server, NULL, buffer, size, extensionHandling, cache);
+}
@@ -88,6 +88,21 @@ START_TEST(Server_ReadPointWithOffset)
 }
 END_TEST
 
+START_TEST(Server_DataTypeHasEncoding)
+{
+    // the encoding reference is attached to the data type by the backend,
+    // it has to be added together with the references of the nodeset
+    ck_assert(hasReference(server, UA_NODEID_NUMERIC(2, 3002),
+                           UA_NODEID_NUMERIC(2, 5002),
+                           UA_NODEID_NUMERIC(0, UA_NS0ID_HASENCODING),
+                           UA_BROWSEDIRECTION_FORWARD));
+    ck_assert(hasReference(server, UA_NODEID_NUMERIC(2, 3003),
+                           UA_NODEID_NUMERIC(2, 5005),
+                           UA_NODEID_NUMERIC(0, UA_NS0ID_HASENCODING),
+                           UA_BROWSEDIRECTION_FORWARD));
+}
+END_TEST
+
 static Suite *testSuite_Client(void)
 {
     Suite *s = suite_create("server nodeset import");
@@ -95,6 +110,7 @@ static Suite *testSuite_Client(void)
     tcase_add_unchecked_fixture(tc_server, setup, teardown);
     tcase_add_test(tc_server, Server_ReadPoint);
     tcase_add_test(tc_server, Server_ReadPointWithOffset);
+    tcase_add_test(tc_server, Server_DataTypeHasEncoding);
     suite_add_tcase(s, tc_server);
     return s;
 }
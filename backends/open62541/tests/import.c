@@ -53,6 +53,47 @@ START_TEST(Server_EmptyHandler) {
 }
 END_TEST
 
+static const char bufferNodeset[] =
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+    "<UANodeSet xmlns=\"http://opcfoundation.org/UA/2011/03/UANodeSet.xsd\">"
+    "<NamespaceUris><Uri>http://open62541.com/tests/buffer/</Uri>"
+    "</NamespaceUris>"
+    "<UAObject NodeId=\"ns=1;i=4711\" BrowseName=\"1:BufferObject\">"
+    "<DisplayName>BufferObject</DisplayName>"
+    "<References>"
+    "<Reference ReferenceType=\"i=40\">i=58</Reference>"
+    "<Reference ReferenceType=\"i=35\" IsForward=\"false\">i=85</Reference>"
+    "</References>"
+    "</UAObject>"
+    "</UANodeSet>";
+
+START_TEST(Server_ImportBuffer) {
+    ck_assert(NodesetLoader_loadBuffer(server, bufferNodeset,
+                                       sizeof(bufferNodeset) - 1, NULL));
+    size_t nsIdx = 0;
+    ck_assert_uint_eq(UA_STATUSCODE_GOOD,
+                      UA_Server_getNamespaceByName(
+                          server,
+                          UA_STRING("http://open62541.com/tests/buffer/"),
+                          &nsIdx));
+    UA_QualifiedName browseName;
+    ck_assert_uint_eq(UA_STATUSCODE_GOOD,
+                      UA_Server_readBrowseName(
+                          server, UA_NODEID_NUMERIC((UA_UInt16)nsIdx, 4711),
+                          &browseName));
+    UA_String expected = UA_STRING("BufferObject");
+    ck_assert(UA_String_equal(&expected, &browseName.name));
+    UA_QualifiedName_clear(&browseName);
+}
+END_TEST
+
+START_TEST(Server_ImportEmptyBuffer) {
+    ck_assert(!NodesetLoader_loadBuffer(server, NULL, 0, NULL));
+    ck_assert(!NodesetLoader_loadBuffer(NULL, bufferNodeset,
+                                        sizeof(bufferNodeset) - 1, NULL));
+}
+END_TEST
+
 static Suite *testSuite_Client(void) {
     Suite *s = suite_create("server nodeset import");
     TCase *tc_server = tcase_create("server nodeset import");
@@ -60,6 +101,8 @@ static Suite *testSuite_Client(void) {
     tcase_add_test(tc_server, Server_ImportNodeset);
     tcase_add_test(tc_server, Server_ImportNoFile);
     tcase_add_test(tc_server, Server_EmptyHandler);
+    tcase_add_test(tc_server, Server_ImportBuffer);
+    tcase_add_test(tc_server, Server_ImportEmptyBuffer);
     suite_add_tcase(s, tc_server);
     return s;
 }
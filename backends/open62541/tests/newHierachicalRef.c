@@ -15,6 +15,7 @@
 UA_Server *server;
 char *nodesetPath1 = NULL;
 char *nodesetPath2 = NULL;
+NodesetLoader_ReferenceTypeCache *cache = NULL;
 
 static void setup(void)
 {
@@ -25,6 +26,7 @@ static void setup(void)
 
 static void teardown(void)
 {
+    NodesetLoader_cleanupReferenceTypeCache(cache);
     UA_Server_run_shutdown(server);
 #ifdef USE_CLEANUP_CUSTOM_DATATYPES
     const UA_DataTypeArray *customTypes =
@@ -38,8 +40,13 @@ static void teardown(void)
 
 START_TEST(loadNodeset)
 {
-    ck_assert(NodesetLoader_loadFile(server, nodesetPath1, NULL));
-    ck_assert(NodesetLoader_loadFile(server, nodesetPath2, NULL));
+    // the reference type of the first nodeset is used by the second one
+    cache = NodesetLoader_enableReferenceTypeCache(server);
+    ck_assert_ptr_nonnull(cache);
+    ck_assert(
+        NodesetLoader_loadFileWithCache(server, nodesetPath1, NULL, cache));
+    ck_assert(
+        NodesetLoader_loadFileWithCache(server, nodesetPath2, NULL, cache));
 }
 END_TEST
 
@@ -0,0 +1,172 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+#include <open62541/types.h>
+
+#include "check.h"
+
+#include "testHelper.h"
+#include <NodesetLoader/backendOpen62541.h>
+#include <NodesetLoader/dataTypes.h>
+
+#define NAMESPACE_URI "http://yourorganisation.org/RefTypeCache/"
+
+UA_Server *server;
+// uses the reference type ns=1;i=4001
+char *nodesetPath = NULL;
+// defines the reference type ns=1;i=4001
+char *typesPath = NULL;
+// defines the reference type ns=1;i=4001, but fails to import
+char *failedPath = NULL;
+
+NodesetLoader_ReferenceTypeCache *cache = NULL;
+
+static UA_Server *newServer(void)
+{
+    UA_Server *s = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(s);
+    UA_ServerConfig_setDefault(config);
+    return s;
+}
+
+static void deleteServer(UA_Server *s)
+{
+    UA_Server_run_shutdown(s);
+#ifdef USE_CLEANUP_CUSTOM_DATATYPES
+    const UA_DataTypeArray *customTypes =
+        UA_Server_getConfig(s)->customDataTypes;
+#endif
+    UA_Server_delete(s);
+#ifdef USE_CLEANUP_CUSTOM_DATATYPES
+    NodesetLoader_cleanupCustomDataTypes(customTypes);
+#endif
+}
+
+static void setup(void)
+{
+    server = newServer();
+    cache = NodesetLoader_enableReferenceTypeCache(server);
+    ck_assert_ptr_nonnull(cache);
+}
+
+static void teardown(void)
+{
+    NodesetLoader_cleanupReferenceTypeCache(cache);
+    cache = NULL;
+    deleteServer(server);
+}
+
+static void checkPart(UA_UInt16 ns)
+{
+    ck_assert(hasReference(server, UA_NODEID_NUMERIC(ns, 5002),
+                           UA_NODEID_NUMERIC(ns, 5001),
+                           UA_NODEID_NUMERIC(ns, 4001),
+                           UA_BROWSEDIRECTION_INVERSE));
+}
+
+// the reference type of the first load is taken from the cache by the second
+START_TEST(reuseAcrossLoads)
+{
+    ck_assert(NodesetLoader_loadFileWithCache(server, typesPath, NULL, cache));
+    ck_assert(
+        NodesetLoader_loadFileWithCache(server, nodesetPath, NULL, cache));
+    checkPart(UA_Server_addNamespace(server, NAMESPACE_URI));
+}
+END_TEST
+
+// the reference type is added to the server after the cache was enabled
+START_TEST(typeAddedToServer)
+{
+    UA_UInt16 ns = UA_Server_addNamespace(server, NAMESPACE_URI);
+    UA_ReferenceTypeAttributes attr = UA_ReferenceTypeAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("", "HasPart");
+    attr.inverseName = UA_LOCALIZEDTEXT("", "IsPartOf");
+    ck_assert_uint_eq(
+        UA_Server_addReferenceTypeNode(
+            server, UA_NODEID_NUMERIC(ns, 4001),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+            UA_QUALIFIEDNAME(ns, "HasPart"), attr, NULL, NULL),
+        UA_STATUSCODE_GOOD);
+    ck_assert(
+        NodesetLoader_loadFileWithCache(server, nodesetPath, NULL, cache));
+    checkPart(ns);
+}
+END_TEST
+
+// the reference type of a failed import is neither in the server nor in the
+// cache, so the nodeset which uses it can't be imported
+START_TEST(failedImport)
+{
+    ck_assert(!NodesetLoader_loadFileWithCache(
+        server, failedPath, NULL, cache));
+    ck_assert(!NodesetLoader_loadFileWithCache(
+        server, nodesetPath, NULL, cache));
+    ck_assert(NodesetLoader_loadFileWithCache(server, typesPath, NULL, cache));
+    ck_assert(
+        NodesetLoader_loadFileWithCache(server, nodesetPath, NULL, cache));
+    checkPart(UA_Server_addNamespace(server, NAMESPACE_URI));
+}
+END_TEST
+
+// the cache only serves the server it was enabled for, another server neither
+// accepts it nor sees the reference types which were loaded with it
+START_TEST(otherServer)
+{
+    ck_assert(NodesetLoader_loadFileWithCache(server, typesPath, NULL, cache));
+    UA_Server *other = newServer();
+    ck_assert(!NodesetLoader_loadFileWithCache(
+        other, nodesetPath, NULL, cache));
+    ck_assert(!NodesetLoader_loadFile(other, nodesetPath, NULL));
+    deleteServer(other);
+}
+END_TEST
+
+// the cache doesn't access the server, it can be released after the server
+// was deleted
+START_TEST(cleanupAfterServer)
+{
+    UA_Server *other = newServer();
+    NodesetLoader_ReferenceTypeCache *otherCache =
+        NodesetLoader_enableReferenceTypeCache(other);
+    ck_assert_ptr_nonnull(otherCache);
+    ck_assert(
+        NodesetLoader_loadFileWithCache(other, typesPath, NULL, otherCache));
+    deleteServer(other);
+    NodesetLoader_cleanupReferenceTypeCache(otherCache);
+}
+END_TEST
+
+static Suite *testSuite_Client(void)
+{
+    Suite *s = suite_create("referenceTypeCache");
+    TCase *tc_server = tcase_create("referenceTypeCache");
+    tcase_add_checked_fixture(tc_server, setup, teardown);
+    tcase_add_test(tc_server, reuseAcrossLoads);
+    tcase_add_test(tc_server, typeAddedToServer);
+    tcase_add_test(tc_server, failedImport);
+    tcase_add_test(tc_server, otherServer);
+    tcase_add_test(tc_server, cleanupAfterServer);
+    suite_add_tcase(s, tc_server);
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    printf("%s", argv[0]);
+    if (!(argc > 3))
+        return 1;
+    nodesetPath = argv[1];
+    typesPath = argv[2];
+    failedPath = argv[3];
+    Suite *s = testSuite_Client();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
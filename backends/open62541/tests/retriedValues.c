@@ -0,0 +1,119 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+#include <open62541/types.h>
+
+#include "check.h"
+
+#include "testHelper.h"
+#include <NodesetLoader/backendOpen62541.h>
+#include <NodesetLoader/dataTypes.h>
+
+#define NAMESPACE_URI "http://yourorganisation.org/RetriedValues/"
+
+UA_Server *server;
+// variables which are added before their parent and are retried
+char *nodesetPath = NULL;
+
+static void setup(void)
+{
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setDefault(config);
+}
+
+static void teardown(void)
+{
+    UA_Server_run_shutdown(server);
+#ifdef USE_CLEANUP_CUSTOM_DATATYPES
+    const UA_DataTypeArray *customTypes =
+        UA_Server_getConfig(server)->customDataTypes;
+#endif
+    UA_Server_delete(server);
+#ifdef USE_CLEANUP_CUSTOM_DATATYPES
+    NodesetLoader_cleanupCustomDataTypes(customTypes);
+#endif
+}
+
+// reads the value of the retried variable, which is organized by the parent
+static void readRetriedValue(UA_UInt16 ns, UA_UInt32 id, UA_Variant *value,
+                             UA_Variant *arrayDimensions)
+{
+    ck_assert(hasReference(server, UA_NODEID_NUMERIC(ns, id),
+                           UA_NODEID_NUMERIC(ns, 5001),
+                           UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                           UA_BROWSEDIRECTION_INVERSE));
+    UA_Variant_init(value);
+    ck_assert(UA_Server_readValue(server, UA_NODEID_NUMERIC(ns, id), value) ==
+              UA_STATUSCODE_GOOD);
+    UA_Variant_init(arrayDimensions);
+    ck_assert(UA_Server_readArrayDimensions(server, UA_NODEID_NUMERIC(ns, id),
+                                            arrayDimensions) ==
+              UA_STATUSCODE_GOOD);
+}
+
+START_TEST(retriedVariables)
+{
+    ck_assert(NodesetLoader_loadFile(server, nodesetPath, NULL));
+    UA_UInt16 ns = UA_Server_addNamespace(server, NAMESPACE_URI);
+    UA_Variant value;
+    UA_Variant dims;
+
+    readRetriedValue(ns, 6001, &value, &dims);
+    ck_assert(UA_Variant_isScalar(&value));
+    ck_assert_ptr_eq(value.type, &UA_TYPES[UA_TYPES_INT32]);
+    ck_assert_int_eq(*(UA_Int32 *)value.data, 42);
+    UA_Variant_clear(&value);
+    UA_Variant_clear(&dims);
+
+    readRetriedValue(ns, 6002, &value, &dims);
+    ck_assert(!UA_Variant_isScalar(&value));
+    ck_assert_ptr_eq(value.type, &UA_TYPES[UA_TYPES_INT32]);
+    ck_assert_uint_eq(value.arrayLength, 3);
+    for (UA_Int32 i = 0; i < 3; i++)
+    {
+        ck_assert_int_eq(((UA_Int32 *)value.data)[i], i + 1);
+    }
+    ck_assert_uint_eq(dims.arrayLength, 1);
+    ck_assert_uint_eq(*(UA_UInt32 *)dims.data, 3);
+    UA_Variant_clear(&value);
+    UA_Variant_clear(&dims);
+
+    readRetriedValue(ns, 6003, &value, &dims);
+    ck_assert(!UA_Variant_isScalar(&value));
+    ck_assert_ptr_eq(value.type, &UA_TYPES[UA_TYPES_STRING]);
+    ck_assert_uint_eq(value.arrayLength, 0);
+    ck_assert_uint_eq(dims.arrayLength, 1);
+    ck_assert_uint_eq(*(UA_UInt32 *)dims.data, 0);
+    UA_Variant_clear(&value);
+    UA_Variant_clear(&dims);
+}
+END_TEST
+
+static Suite *testSuite_Client(void)
+{
+    Suite *s = suite_create("retriedValues");
+    TCase *tc_server = tcase_create("retriedValues");
+    tcase_add_unchecked_fixture(tc_server, setup, teardown);
+    tcase_add_test(tc_server, retriedVariables);
+    suite_add_tcase(s, tc_server);
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    printf("%s", argv[0]);
+    if (!(argc > 1))
+        return 1;
+    nodesetPath = argv[1];
+    Suite *s = testSuite_Client();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
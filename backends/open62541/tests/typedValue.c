@@ -0,0 +1,292 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+#include <open62541/types.h>
+
+#include "check.h"
+
+#include "../src/ServerContext.h"
+#include "../src/Value.h"
+#include <NodesetLoader/NodesetLoader.h>
+#include <NodesetLoader/backendOpen62541.h>
+#include <NodesetLoader/dataTypes.h>
+
+#include <string.h>
+
+#define NAMESPACE_URI "http://yourorganisation.org/TypedValue/"
+#define TYPES_NAMESPACE_URI "http://yourorganisation.org/TypedValueTypes/"
+
+UA_Server *server;
+// variables with values of the ns0 types and the types of typesPath
+char *nodesetPath = NULL;
+// defines the custom data types of the values
+char *typesPath = NULL;
+
+// the nodeset is parsed twice, the values of typedLoader are decoded while
+// parsing, the values of dataLoader are kept as NL_Data for Value_getData
+static ServerContext *typedContext = NULL;
+static ServerContext *dataContext = NULL;
+static NodesetLoader *typedLoader = NULL;
+static NodesetLoader *dataLoader = NULL;
+static TypedValue *typedValues = NULL;
+// has to stay valid while typedLoader imports
+static NL_ValueInterface valueInterface;
+
+static const UA_DataType *findType(const UA_NodeId *id)
+{
+    const UA_DataType *type = UA_findDataType(id);
+    if (!type)
+    {
+        type = NodesetLoader_getCustomDataType(server, id);
+    }
+    return type;
+}
+
+static void *newTypedValue(void *context, const NL_VariableNode *node)
+{
+    const UA_DataType *type = findType(&node->datatype);
+    if (!TypedValue_isSupported(type))
+    {
+        return NULL;
+    }
+    TypedValue *value =
+        TypedValue_new(type, (const ServerContext *)context, typedValues);
+    if (value)
+    {
+        typedValues = value;
+    }
+    return value;
+}
+
+static void startTypedValue(void *value, const char *name)
+{
+    TypedValue_start((TypedValue *)value, name);
+}
+
+static void endTypedValue(void *value, const char *name, const char *text)
+{
+    TypedValue_end((TypedValue *)value, name, text);
+}
+
+static void finishTypedValue(void *value)
+{
+    TypedValue_finish((TypedValue *)value);
+}
+
+static unsigned short addNamespace(void *userContext, const char *uri)
+{
+    UA_UInt16 idx = UA_Server_addNamespace(server, uri);
+    ServerContext_addNamespaceIdx((ServerContext *)userContext, idx);
+    return idx;
+}
+
+static NodesetLoader *parse(ServerContext *serverContext,
+                            const NL_ValueInterface *values)
+{
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    ck_assert_ptr_nonnull(loader);
+    NodesetLoader_setValueInterface(loader, values);
+    NL_FileContext handler;
+    memset(&handler, 0, sizeof(handler));
+    handler.addNamespace = addNamespace;
+    handler.userContext = serverContext;
+    handler.file = nodesetPath;
+    ck_assert(NodesetLoader_importFile(loader, &handler));
+    return loader;
+}
+
+static void setup(void)
+{
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setDefault(config);
+    // the custom types have to be in the server before the values are parsed
+    ck_assert(NodesetLoader_loadFile(server, typesPath, NULL));
+
+    typedContext = ServerContext_new(server);
+    dataContext = ServerContext_new(server);
+    valueInterface.context = typedContext;
+    valueInterface.newValue = newTypedValue;
+    valueInterface.start = startTypedValue;
+    valueInterface.end = endTypedValue;
+    valueInterface.finish = finishTypedValue;
+    typedLoader = parse(typedContext, &valueInterface);
+    dataLoader = parse(dataContext, NULL);
+}
+
+static void teardown(void)
+{
+    NodesetLoader_delete(typedLoader);
+    NodesetLoader_delete(dataLoader);
+    TypedValue_delete(typedValues);
+    typedValues = NULL;
+    ServerContext_delete(typedContext);
+    ServerContext_delete(dataContext);
+    UA_Server_run_shutdown(server);
+#ifdef USE_CLEANUP_CUSTOM_DATATYPES
+    const UA_DataTypeArray *customTypes =
+        UA_Server_getConfig(server)->customDataTypes;
+#endif
+    UA_Server_delete(server);
+#ifdef USE_CLEANUP_CUSTOM_DATATYPES
+    NodesetLoader_cleanupCustomDataTypes(customTypes);
+#endif
+}
+
+typedef struct
+{
+    UA_NodeId id;
+    const NL_VariableNode *node;
+} NodeLookup;
+
+static void matchNode(void *context, NL_Node *node)
+{
+    NodeLookup *lookup = (NodeLookup *)context;
+    if (UA_NodeId_equal(&node->id, &lookup->id))
+    {
+        lookup->node = (const NL_VariableNode *)node;
+    }
+}
+
+static const NL_VariableNode *getVariable(NodesetLoader *loader, UA_UInt32 id)
+{
+    NodeLookup lookup;
+    lookup.id =
+        UA_NODEID_NUMERIC(UA_Server_addNamespace(server, NAMESPACE_URI), id);
+    lookup.node = NULL;
+    NodesetLoader_forEachNode(loader, NODECLASS_VARIABLE, &lookup, matchNode);
+    ck_assert_ptr_nonnull(lookup.node);
+    return lookup.node;
+}
+
+// decodes the value of the variable with TypedValue and with Value_getData,
+// like the import does for types which aren't supported, and compares them
+static void compareValue(UA_UInt32 id)
+{
+    const NL_VariableNode *typedNode = getVariable(typedLoader, id);
+    const NL_VariableNode *dataNode = getVariable(dataLoader, id);
+    const UA_DataType *type = findType(&dataNode->datatype);
+    ck_assert(TypedValue_isSupported(type));
+    ck_assert_ptr_nonnull(typedNode->value);
+    ck_assert_ptr_nonnull(typedNode->value->decoder);
+    ck_assert_ptr_nonnull(dataNode->value);
+    ck_assert_ptr_nonnull(dataNode->value->data);
+
+    TypedValue *typedValue = (TypedValue *)typedNode->value->decoder;
+    const bool isArray = TypedValue_isArray(typedValue);
+    ck_assert(isArray == dataNode->value->isArray);
+    UA_Variant typed;
+    UA_Variant_init(&typed);
+    ck_assert(TypedValue_moveTo(typedValue, &typed));
+
+    RawData *data = RawData_new(NULL);
+    Value_getData(data, dataNode->value, type,
+                  UA_Server_getConfig(server)->customDataTypes->types,
+                  dataContext);
+    const size_t size =
+        isArray ? dataNode->value->data->val.complexData.membersSize : 1;
+    ck_assert_uint_eq(isArray ? typed.arrayLength : 1, size);
+    for (size_t i = 0; i < size; i++)
+    {
+        const void *expected = (const char *)data->mem + i * type->memSize;
+        const void *actual = (const char *)typed.data + i * type->memSize;
+        ck_assert_msg(UA_order(expected, actual, type) == UA_ORDER_EQ,
+                      "value of variable %u differs at %zu", id, i);
+    }
+
+    if (isArray)
+    {
+        UA_Array_delete(data->mem, size, type);
+    }
+    else
+    {
+        UA_delete(data->mem, type);
+    }
+    RawData_delete(data);
+    UA_Variant_clear(&typed);
+}
+
+static void compareValues(UA_UInt32 first, UA_UInt32 last)
+{
+    for (UA_UInt32 id = first; id <= last; id++)
+    {
+        compareValue(id);
+    }
+}
+
+// Int32, Double, String, Boolean, DateTime, Guid, NodeId, StatusCode,
+// LocalizedText, QualifiedName and ByteString
+START_TEST(scalars)
+{
+    compareValues(1001, 1011);
+}
+END_TEST
+
+// ListOf elements of primitive and builtin types, including an empty list
+START_TEST(arrays)
+{
+    compareValues(2001, 2006);
+}
+END_TEST
+
+// Argument and a custom structure with a nested structure, an array of
+// Arguments, QualifiedName, ByteString and LocalizedText, as scalars and as
+// ListOfExtensionObject
+START_TEST(extensionObjects)
+{
+    compareValues(3001, 3004);
+}
+END_TEST
+
+// union with the first, the second and no field selected
+START_TEST(unions)
+{
+    compareValues(4001, 4003);
+}
+END_TEST
+
+// neither Value_getData nor TypedValue decode structures with optional fields,
+// the value interface has to decline them
+START_TEST(optionalFields)
+{
+    const UA_NodeId id = UA_NODEID_NUMERIC(
+        UA_Server_addNamespace(server, TYPES_NAMESPACE_URI), 3004);
+    const UA_DataType *type = findType(&id);
+    ck_assert_ptr_nonnull(type);
+    ck_assert_uint_eq(type->typeKind, UA_DATATYPEKIND_OPTSTRUCT);
+    ck_assert(!TypedValue_isSupported(type));
+}
+END_TEST
+
+static Suite *testSuite_Client(void)
+{
+    Suite *s = suite_create("typedValue");
+    TCase *tc_server = tcase_create("typedValue");
+    tcase_add_checked_fixture(tc_server, setup, teardown);
+    tcase_add_test(tc_server, scalars);
+    tcase_add_test(tc_server, arrays);
+    tcase_add_test(tc_server, extensionObjects);
+    tcase_add_test(tc_server, unions);
+    tcase_add_test(tc_server, optionalFields);
+    suite_add_tcase(s, tc_server);
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    printf("%s", argv[0]);
+    if (!(argc > 2))
+        return 1;
+    nodesetPath = argv[1];
+    typesPath = argv[2];
+    Suite *s = testSuite_Client();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
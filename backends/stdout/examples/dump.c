@@ -31,16 +31,16 @@ void dumpNode(void *userContext, const NL_Node *node)
     {
     case NODECLASS_OBJECT:
         printf("\tparentNodeId: %s\n", printId(&((const NL_ObjectNode *)node)->parentNodeId));
-        printf("\teventNotifier: %s\n", ((const NL_ObjectNode *)node)->eventNotifier);
+        printf("\teventNotifier: %d\n", ((const NL_ObjectNode *)node)->eventNotifier);
         break;
     case NODECLASS_VARIABLE:
         printf("\tparentNodeId: %s\n",
                printId(&((const NL_VariableNode *)node)->parentNodeId));
         printf("\tdatatype: %s\n", printId(&((const NL_VariableNode *)node)->datatype));
-        printf("\tvalueRank: %s\n", ((const NL_VariableNode *)node)->valueRank);
+        printf("\tvalueRank: %d\n", ((const NL_VariableNode *)node)->valueRank);
         printf("\tarrayDimensions: %s\n",
-               ((const NL_VariableNode *)node)->valueRank);
-        printf("\tminimumSamplingInterval: %s\n",
+               ((const NL_VariableNode *)node)->arrayDimensions);
+        printf("\tminimumSamplingInterval: %g\n",
                ((const NL_VariableNode *)node)->minimumSamplingInterval);
         break;
     case NODECLASS_OBJECTTYPE:
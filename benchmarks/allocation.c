@@ -0,0 +1,168 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// compares allocating every node and reference on its own with the slab pools
+// of the loader and measures import and teardown of a generated instance model
+// usage: allocationBenchmark [objects] [variablesPerObject]
+
+#include "ObjectPool.h"
+#include <NodesetLoader/NodesetLoader.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define REFS_PER_NODE 3
+
+static double elapsedMs(clock_t start)
+{
+    return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+static void individualAllocations(size_t nodeCount)
+{
+    size_t allocations = 0;
+    NL_VariableNode **nodes =
+        (NL_VariableNode **)calloc(nodeCount, sizeof(NL_VariableNode *));
+    clock_t start = clock();
+    for (size_t i = 0; i < nodeCount; i++)
+    {
+        nodes[i] = (NL_VariableNode *)calloc(1, sizeof(NL_VariableNode));
+        allocations++;
+        for (int r = 0; r < REFS_PER_NODE; r++)
+        {
+            NL_Reference *ref = (NL_Reference *)calloc(1, sizeof(NL_Reference));
+            allocations++;
+            ref->next = nodes[i]->hierachicalRefs;
+            nodes[i]->hierachicalRefs = ref;
+        }
+    }
+    double allocMs = elapsedMs(start);
+    start = clock();
+    for (size_t i = 0; i < nodeCount; i++)
+    {
+        NL_Reference *ref = nodes[i]->hierachicalRefs;
+        while (ref)
+        {
+            NL_Reference *next = ref->next;
+            free(ref);
+            ref = next;
+        }
+        free(nodes[i]);
+    }
+    double teardownMs = elapsedMs(start);
+    free(nodes);
+    printf("calloc per object: %10zu allocations, alloc %8.2f ms, teardown "
+           "%8.2f ms\n",
+           allocations, allocMs, teardownMs);
+}
+
+static void pooledAllocations(size_t nodeCount)
+{
+    ObjectPool *nodePool = ObjectPool_new(sizeof(NL_VariableNode), 10000);
+    ObjectPool *refPool = ObjectPool_new(sizeof(NL_Reference), 10000);
+    clock_t start = clock();
+    for (size_t i = 0; i < nodeCount; i++)
+    {
+        NL_VariableNode *node = (NL_VariableNode *)ObjectPool_alloc(nodePool);
+        for (int r = 0; r < REFS_PER_NODE; r++)
+        {
+            NL_Reference *ref = (NL_Reference *)ObjectPool_alloc(refPool);
+            ref->next = node->hierachicalRefs;
+            node->hierachicalRefs = ref;
+        }
+    }
+    double allocMs = elapsedMs(start);
+    size_t allocations =
+        ObjectPool_slabCount(nodePool) + ObjectPool_slabCount(refPool);
+    start = clock();
+    ObjectPool_delete(nodePool);
+    ObjectPool_delete(refPool);
+    double teardownMs = elapsedMs(start);
+    printf("object pools:      %10zu allocations, alloc %8.2f ms, teardown "
+           "%8.2f ms\n",
+           allocations, allocMs, teardownMs);
+}
+
+static char *generateNodeset(size_t objects, size_t variables, size_t *size)
+{
+    const size_t perNode = 512;
+    size_t capacity = (objects * (variables + 1) + 1) * perNode;
+    char *buffer = (char *)malloc(capacity);
+    size_t len = (size_t)sprintf(
+        buffer, "<UANodeSet><NamespaceUris><Uri>http://benchmark/</Uri>"
+                "</NamespaceUris>");
+    unsigned long id = 1;
+    for (size_t o = 0; o < objects; o++)
+    {
+        unsigned long objectId = id++;
+        len += (size_t)sprintf(
+            buffer + len,
+            "<UAObject NodeId=\"ns=1;i=%lu\" BrowseName=\"1:Object%lu\">"
+            "<DisplayName>Object</DisplayName><References>"
+            "<Reference ReferenceType=\"HasTypeDefinition\">i=58</Reference>"
+            "<Reference ReferenceType=\"Organizes\" IsForward=\"false\">"
+            "i=85</Reference></References></UAObject>",
+            objectId, objectId);
+        for (size_t v = 0; v < variables; v++)
+        {
+            unsigned long varId = id++;
+            len += (size_t)sprintf(
+                buffer + len,
+                "<UAVariable NodeId=\"ns=1;i=%lu\" BrowseName=\"1:Var%lu\" "
+                "DataType=\"i=6\" ParentNodeId=\"ns=1;i=%lu\">"
+                "<DisplayName>Var</DisplayName><References>"
+                "<Reference ReferenceType=\"HasTypeDefinition\">i=63"
+                "</Reference><Reference ReferenceType=\"HasComponent\" "
+                "IsForward=\"false\">ns=1;i=%lu</Reference></References>"
+                "</UAVariable>",
+                varId, varId, objectId, objectId);
+        }
+    }
+    len += (size_t)sprintf(buffer + len, "</UANodeSet>");
+    *size = len;
+    return buffer;
+}
+
+static unsigned short addNamespace(void *userContext, const char *uri)
+{
+    return 1;
+}
+
+static void loadNodeset(size_t objects, size_t variables)
+{
+    size_t size = 0;
+    char *buffer = generateNodeset(objects, variables, &size);
+    NL_FileContext handler;
+    handler.addNamespace = addNamespace;
+    handler.extensionHandling = NULL;
+    handler.userContext = NULL;
+    handler.file = NULL;
+
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    clock_t start = clock();
+    bool imported = NodesetLoader_importBuffer(loader, &handler, buffer, size);
+    bool sorted = imported && NodesetLoader_sort(loader);
+    double importMs = elapsedMs(start);
+    start = clock();
+    NodesetLoader_delete(loader);
+    double teardownMs = elapsedMs(start);
+    free(buffer);
+    printf("loader: %zu nodes, import and sort %8.2f ms, teardown %8.2f ms%s\n",
+           objects * (variables + 1), importMs, teardownMs,
+           sorted ? "" : " (import failed)");
+}
+
+int main(int argc, char *argv[])
+{
+    size_t objects = argc > 1 ? (size_t)strtoul(argv[1], NULL, 10) : 50000;
+    size_t variables = argc > 2 ? (size_t)strtoul(argv[2], NULL, 10) : 9;
+    size_t nodeCount = objects * (variables + 1);
+
+    printf("%zu nodes with %d references each\n", nodeCount, REFS_PER_NODE);
+    individualAllocations(nodeCount);
+    pooledAllocations(nodeCount);
+    loadNodeset(objects, variables);
+    return 0;
+}
@@ -0,0 +1,103 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// compares the decoding of large ByteString values by Base64_decode with
+// unbase64 of nodeset_base64.h, once as a single line and once wrapped after
+// 76 characters like in certificates and firmware images
+// usage: base64Benchmark [bytes] [repetitions]
+
+#include "Base64.h"
+#include "nodeset_base64.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LINE_LENGTH 76
+
+static double elapsedMs(clock_t start)
+{
+    return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+static char *wrapLines(const char *text, size_t size)
+{
+    char *wrapped = (char *)malloc(size + (size / LINE_LENGTH + 1) * 2 + 1);
+    size_t pos = 0;
+    for (size_t i = 0; i < size; i += LINE_LENGTH)
+    {
+        size_t n = size - i < LINE_LENGTH ? size - i : LINE_LENGTH;
+        memcpy(wrapped + pos, text + i, n);
+        pos += n;
+        wrapped[pos++] = '\r';
+        wrapped[pos++] = '\n';
+    }
+    wrapped[pos] = '\0';
+    return wrapped;
+}
+
+static void measure(const char *name, const char *text,
+                    const unsigned char *data, size_t size, int repetitions)
+{
+    size_t textSize = strlen(text);
+    size_t decodedSize = 0;
+    clock_t start = clock();
+    for (int i = 0; i < repetitions; i++)
+    {
+        unsigned char *decoded = Base64_decode(text, textSize, &decodedSize);
+        if (!decoded || decodedSize != size || memcmp(decoded, data, size))
+        {
+            printf("%s: Base64_decode failed\n", name);
+        }
+        free(decoded);
+    }
+    double decodeMs = elapsedMs(start);
+    start = clock();
+    for (int i = 0; i < repetitions; i++)
+    {
+        int len = 0;
+        unsigned char *decoded = unbase64(text, (int)textSize, &len);
+        if (!decoded || (size_t)len != size || memcmp(decoded, data, size))
+        {
+            printf("%s: unbase64 failed\n", name);
+        }
+        free(decoded);
+    }
+    double unbase64Ms = elapsedMs(start);
+    double megaBytes = (double)textSize * repetitions / (1024.0 * 1024.0);
+    printf("%-12s Base64_decode %8.2f ms (%7.1f MB/s), unbase64 %8.2f ms "
+           "(%7.1f MB/s)\n",
+           name, decodeMs, megaBytes * 1000.0 / decodeMs, unbase64Ms,
+           megaBytes * 1000.0 / unbase64Ms);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t size = argc > 1 ? (size_t)strtoul(argv[1], NULL, 10) : 4000000;
+    int repetitions = argc > 2 ? atoi(argv[2]) : 20;
+    if (size == 0 || repetitions <= 0)
+    {
+        return 1;
+    }
+    unsigned char *data = (unsigned char *)malloc(size);
+    if (!data)
+    {
+        return 1;
+    }
+    srand(1);
+    for (size_t i = 0; i < size; i++)
+    {
+        data[i] = (unsigned char)(rand() & 0xff);
+    }
+    int textSize = 0;
+    char *text = base64(data, (int)size, &textSize);
+    char *wrapped = wrapLines(text, (size_t)textSize);
+    printf("%zu bytes, %d repetitions\n", size, repetitions);
+    measure("single line", text, data, size, repetitions);
+    measure("wrapped", wrapped, data, size, repetitions);
+    free(wrapped);
+    free(text);
+    free(data);
+    return 0;
+}
@@ -0,0 +1,79 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// measures the topological sort of a generated tree of nodes, every node has
+// an inverse hierachical reference to its parent, the nodes are added leaves
+// first, so no node can be emitted before its parent was seen
+// usage: sortBenchmark [nodes] [childrenPerNode]
+
+#include "Sort.h"
+#include <NodesetLoader/NodesetLoader.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double elapsedMs(clock_t start)
+{
+    return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+static size_t sortedCnt = 0;
+
+static bool countSorted(struct Nodeset *nodeset, NL_Node *node, size_t level)
+{
+    sortedCnt++;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t nodeCount = argc > 1 ? (size_t)strtoul(argv[1], NULL, 10) : 500000;
+    size_t children = argc > 2 ? (size_t)strtoul(argv[2], NULL, 10) : 4;
+    if (nodeCount == 0 || children == 0)
+    {
+        return 1;
+    }
+    NL_ObjectTypeNode *nodes =
+        (NL_ObjectTypeNode *)calloc(nodeCount, sizeof(NL_ObjectTypeNode));
+    NL_Reference *refs =
+        (NL_Reference *)calloc(nodeCount, sizeof(NL_Reference));
+    if (!nodes || !refs)
+    {
+        return 1;
+    }
+    for (size_t i = 0; i < nodeCount; i++)
+    {
+        nodes[i].nodeClass = NODECLASS_OBJECTTYPE;
+        nodes[i].id = UA_NODEID_NUMERIC(1, (UA_UInt32)(i + 1));
+        if (i > 0)
+        {
+            refs[i].isForward = false;
+            refs[i].refType = UA_NODEID_NUMERIC(0, 45);
+            refs[i].target =
+                UA_NODEID_NUMERIC(1, (UA_UInt32)((i - 1) / children + 1));
+            nodes[i].hierachicalRefs = &refs[i];
+        }
+    }
+
+    SortContext *ctx = Sort_init();
+    clock_t start = clock();
+    for (size_t i = nodeCount; i > 0; i--)
+    {
+        Sort_addNode(ctx, (NL_Node *)&nodes[i - 1]);
+    }
+    double addMs = elapsedMs(start);
+    start = clock();
+    bool sorted = Sort_start(ctx, NULL, countSorted, NULL);
+    double sortMs = elapsedMs(start);
+    start = clock();
+    Sort_cleanup(ctx);
+    double cleanupMs = elapsedMs(start);
+
+    printf("%zu nodes: add %8.2f ms, sort %8.2f ms, cleanup %8.2f ms%s\n",
+           nodeCount, addMs, sortMs, cleanupMs,
+           sorted && sortedCnt == nodeCount ? "" : " (sort failed)");
+    free(nodes);
+    free(refs);
+    return sorted ? 0 : 1;
+}
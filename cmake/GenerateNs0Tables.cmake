@@ -0,0 +1,181 @@
+# Generates the metadata tables of namespace 0 (see src/Ns0Tables.h) from
+# Opc.Ua.NodeSet2.xml.
+#
+# Either include this file and call
+#   nodesetloader_generate_ns0_tables(<nodeset> <output>)
+# or run it as a script:
+#   cmake -DNODESET=<nodeset> -DOUTPUT=<output> -P GenerateNs0Tables.cmake
+#
+# The output is only rewritten if its content changes.
+
+# well known ids of namespace 0
+set(NS0_NONHIERARCHICALREFERENCES 32)
+set(NS0_HIERARCHICALREFERENCES 33)
+set(NS0_HASENCODING 38)
+set(NS0_HASTYPEDEFINITION 40)
+set(NS0_HASSUBTYPE 45)
+
+# zero padded ids are sorted numerically by list(SORT)
+function(ns0_pad_id id out)
+    string(LENGTH "${id}" len)
+    set(padded "${id}")
+    while(len LESS 10)
+        set(padded "0${padded}")
+        math(EXPR len "${len} + 1")
+    endwhile()
+    set(${out} "${padded}" PARENT_SCOPE)
+endfunction()
+
+function(nodesetloader_generate_ns0_tables nodeset output)
+    # only the start tags of nodes, the aliases and the inverse references
+    # are of interest
+    file(STRINGS "${nodeset}" lines
+         REGEX "<Alias |<UA[A-Za-z]+ NodeId=\"i=|IsForward=\"false\"")
+
+    set(refTypes "")
+    set(dataTypes "")
+    set(currentId "")
+    set(currentClass "")
+    set(currentName "")
+    foreach(line IN LISTS lines)
+        if(line MATCHES "<Alias Alias=\"([^\"]+)\">i=([0-9]+)<")
+            set(alias_${CMAKE_MATCH_1} ${CMAKE_MATCH_2})
+        elseif(line MATCHES "<UA([A-Za-z]+) NodeId=\"i=([0-9]+)\"")
+            set(currentClass ${CMAKE_MATCH_1})
+            set(currentId ${CMAKE_MATCH_2})
+            set(currentName "")
+            if(line MATCHES "BrowseName=\"([^\"]*)\"")
+                set(currentName "${CMAKE_MATCH_1}")
+            endif()
+            if(currentClass STREQUAL "ReferenceType")
+                list(APPEND refTypes ${currentId})
+            elseif(currentClass STREQUAL "DataType")
+                list(APPEND dataTypes ${currentId})
+            endif()
+        elseif(currentId AND line MATCHES
+               "ReferenceType=\"([^\"]+)\" IsForward=\"false\">i=([0-9]+)<")
+            set(target ${CMAKE_MATCH_2})
+            set(refType "${CMAKE_MATCH_1}")
+            if(DEFINED alias_${refType})
+                set(refType ${alias_${refType}})
+            elseif(refType MATCHES "^i=([0-9]+)$")
+                set(refType ${CMAKE_MATCH_1})
+            endif()
+            if(refType EQUAL NS0_HASSUBTYPE)
+                set(superType_${currentId} ${target})
+            elseif(refType EQUAL NS0_HASENCODING AND
+                   currentClass STREQUAL "Object")
+                if(currentName STREQUAL "Default Binary")
+                    set(binaryEncoding_${target} ${currentId})
+                elseif(currentName STREQUAL "Default XML")
+                    set(xmlEncoding_${target} ${currentId})
+                elseif(currentName STREQUAL "Default JSON")
+                    set(jsonEncoding_${target} ${currentId})
+                endif()
+            endif()
+        endif()
+    endforeach()
+
+    list(LENGTH refTypes refTypesSize)
+    list(LENGTH dataTypes dataTypesSize)
+    if(refTypesSize EQUAL 0 OR dataTypesSize EQUAL 0)
+        message(FATAL_ERROR "no reference types or data types in ${nodeset}")
+    endif()
+
+    # reference types, classified by walking up the supertype chain
+    set(rows "")
+    foreach(id IN LISTS refTypes)
+        set(flags "")
+        set(superType 0)
+        if(DEFINED superType_${id})
+            set(superType ${superType_${id}})
+        endif()
+        set(current ${id})
+        set(depth 0)
+        while(current)
+            if(current EQUAL NS0_HIERARCHICALREFERENCES)
+                list(APPEND flags NS0TABLES_HIERACHICAL)
+            elseif(current EQUAL NS0_NONHIERARCHICALREFERENCES)
+                list(APPEND flags NS0TABLES_NONHIERACHICAL)
+            elseif(current EQUAL NS0_HASTYPEDEFINITION)
+                list(APPEND flags NS0TABLES_HASTYPEDEFINITION)
+            endif()
+            math(EXPR depth "${depth} + 1")
+            if(depth GREATER 64)
+                message(FATAL_ERROR "cyclic supertypes of i=${id}")
+            endif()
+            if(DEFINED superType_${current})
+                set(current ${superType_${current}})
+            else()
+                set(current "")
+            endif()
+        endwhile()
+        if(flags)
+            list(SORT flags)
+            string(REPLACE ";" " | " flags "${flags}")
+        else()
+            set(flags 0)
+        endif()
+        ns0_pad_id(${id} key)
+        list(APPEND rows "${key}|    {${id}, ${superType}, ${flags}},")
+    endforeach()
+    list(SORT rows)
+    set(refTypeRows "")
+    foreach(row IN LISTS rows)
+        string(REGEX REPLACE "^[0-9]+\\|" "" row "${row}")
+        set(refTypeRows "${refTypeRows}${row}\n")
+    endforeach()
+
+    # data types with their direct supertype and encodings
+    set(rows "")
+    foreach(id IN LISTS dataTypes)
+        set(values "")
+        foreach(v superType binaryEncoding xmlEncoding jsonEncoding)
+            if(DEFINED ${v}_${id})
+                list(APPEND values ${${v}_${id}})
+            else()
+                list(APPEND values 0)
+            endif()
+        endforeach()
+        string(REPLACE ";" ", " values "${values}")
+        ns0_pad_id(${id} key)
+        list(APPEND rows "${key}|    {${id}, ${values}},")
+    endforeach()
+    list(SORT rows)
+    set(dataTypeRows "")
+    foreach(row IN LISTS rows)
+        string(REGEX REPLACE "^[0-9]+\\|" "" row "${row}")
+        set(dataTypeRows "${dataTypeRows}${row}\n")
+    endforeach()
+
+    get_filename_component(nodesetName "${nodeset}" NAME)
+    set(content "/* Generated by cmake/GenerateNs0Tables.cmake from ${nodesetName},
+ * do not edit. */
+
+#include \"Ns0Tables.h\"
+
+const Ns0Tables_ReferenceType Ns0Tables_referenceTypes[] = {
+${refTypeRows}};
+
+const size_t Ns0Tables_referenceTypesSize =
+    sizeof(Ns0Tables_referenceTypes) / sizeof(Ns0Tables_referenceTypes[0]);
+
+const Ns0Tables_DataType Ns0Tables_dataTypes[] = {
+${dataTypeRows}};
+
+const size_t Ns0Tables_dataTypesSize =
+    sizeof(Ns0Tables_dataTypes) / sizeof(Ns0Tables_dataTypes[0]);
+")
+
+    if(EXISTS "${output}")
+        file(READ "${output}" oldContent)
+        if(oldContent STREQUAL content)
+            return()
+        endif()
+    endif()
+    file(WRITE "${output}" "${content}")
+endfunction()
+
+if(CMAKE_SCRIPT_MODE_FILE STREQUAL CMAKE_CURRENT_LIST_FILE)
+    nodesetloader_generate_ns0_tables("${NODESET}" "${OUTPUT}")
+endif()
@@ -26,6 +26,12 @@
 extern "C" {
 #endif
 
+// 1.0 replaced the attribute strings of the node structs by typed fields, see
+// the migration notes in README.md
+#define NODESETLOADER_VERSION_MAJOR 1
+#define NODESETLOADER_VERSION_MINOR 0
+#define NODESETLOADER_VERSION_PATCH 0
+
 #define NL_NODECLASS_COUNT 8
 typedef enum
 {
@@ -69,6 +75,16 @@ struct NL_BiDirectionalReference
     NL_BiDirectionalReference *next;
 };
 
+// references of a node in the contiguous reference array of the loader, the
+// hierachical references are followed by the non hierachical ones
+struct NL_ReferenceSpan
+{
+    NL_Reference *refs;
+    size_t hierachicalSize;
+    size_t nonHierachicalSize;
+};
+typedef struct NL_ReferenceSpan NL_ReferenceSpan;
+
 struct NL_LocalizedText
 {
     char *locale;
@@ -86,10 +102,19 @@ typedef struct NL_LocalizedText NL_LocalizedText;
     NL_Reference *hierachicalRefs;                                                \
     NL_Reference *nonHierachicalRefs;                                             \
     NL_Reference *unknownRefs;                                                    \
-    void *extension;
+    void *extension;                                                             \
+    NL_ReferenceSpan compactRefs;
 
 #define NL_NODE_INSTANCE_ATTRIBUTES UA_NodeId parentNodeId;
 
+// boolean attributes, packed into the flags of the nodes
+#define NL_NODEFLAG_ISABSTRACT 0x01
+#define NL_NODEFLAG_HISTORIZING 0x02
+#define NL_NODEFLAG_EXECUTABLE 0x04
+#define NL_NODEFLAG_USEREXECUTABLE 0x08
+#define NL_NODEFLAG_SYMMETRIC 0x10
+#define NL_NODEFLAG_CONTAINSNOLOOPS 0x20
+
 struct NL_Node
 {
     NL_NODE_ATTRIBUTES
@@ -107,7 +132,7 @@ struct NL_ObjectNode
 {
     NL_NODE_ATTRIBUTES
     NL_NODE_INSTANCE_ATTRIBUTES
-    char *eventNotifier;
+    uint8_t eventNotifier;
     NL_Reference *refToTypeDef;
 };
 typedef struct NL_ObjectNode NL_ObjectNode;
@@ -115,17 +140,19 @@ typedef struct NL_ObjectNode NL_ObjectNode;
 struct NL_ObjectTypeNode
 {
     NL_NODE_ATTRIBUTES
-    char *isAbstract;
+    // NL_NODEFLAG_ISABSTRACT
+    uint8_t flags;
 };
 typedef struct NL_ObjectTypeNode NL_ObjectTypeNode;
 
 struct NL_VariableTypeNode
 {
     NL_NODE_ATTRIBUTES
-    char *isAbstract;
     UA_NodeId datatype;
     char *arrayDimensions;
-    char *valueRank;
+    int32_t valueRank;
+    // NL_NODEFLAG_ISABSTRACT
+    uint8_t flags;
 };
 typedef struct NL_VariableTypeNode NL_VariableTypeNode;
 
@@ -172,6 +199,13 @@ struct NL_Value
     const char *type;
     UA_NodeId typeId;
     NL_Data *data;
+    // content of the value element if values are decoded lazily, data is
+    // NULL until NL_Value_decode is called
+    const char *xml;
+    size_t xmlSize;
+    // decoder which was returned by NL_ValueInterface::newValue, data is
+    // NULL if the value was passed to the decoder
+    void *decoder;
 };
 typedef struct NL_Value NL_Value;
 struct NL_VariableNode
@@ -180,16 +214,40 @@ struct NL_VariableNode
     NL_NODE_INSTANCE_ATTRIBUTES
     UA_NodeId datatype;
     char *arrayDimensions;
-    char *valueRank;
-    char *accessLevel;
-    char *userAccessLevel;
-    char *historizing;
-    char *minimumSamplingInterval;
+    int32_t valueRank;
+    uint8_t accessLevel;
+    uint8_t userAccessLevel;
+    // NL_NODEFLAG_HISTORIZING
+    uint8_t flags;
+    double minimumSamplingInterval;
     NL_Value *value;
     NL_Reference *refToTypeDef;
 };
 typedef struct NL_VariableNode NL_VariableNode;
 
+// decodes the values of variables while they are parsed, e.g. straight into
+// the types of a backend, instead of building NL_Data trees
+typedef void *(*NL_newValueCb)(void *context, const NL_VariableNode *node);
+typedef void (*NL_startValueCb)(void *decoder, const char *name);
+typedef void (*NL_endValueCb)(void *decoder, const char *name,
+                              const char *text);
+typedef void (*NL_finishValueCb)(void *decoder);
+
+typedef struct
+{
+    void *context;
+    // called when the value element of a variable starts, the attributes of
+    // the node are already set. Returns the decoder of the value or NULL if
+    // the value is built as NL_Data tree.
+    NL_newValueCb newValue;
+    // called for the elements inside of the value element, name and text are
+    // only valid during the call, text is NULL if the element has no text
+    NL_startValueCb start;
+    NL_endValueCb end;
+    // called when the value element is closed
+    NL_finishValueCb finish;
+} NL_ValueInterface;
+
 typedef struct
 {
     char *name;
@@ -212,7 +270,8 @@ struct NL_DataTypeNode
 {
     NL_NODE_ATTRIBUTES
     NL_DataTypeDefinition *definition;
-    char *isAbstract;
+    // NL_NODEFLAG_ISABSTRACT
+    uint8_t flags;
 };
 typedef struct NL_DataTypeNode NL_DataTypeNode;
 
@@ -220,8 +279,8 @@ struct NL_MethodNode
 {
     NL_NODE_ATTRIBUTES
     NL_NODE_INSTANCE_ATTRIBUTES
-    char *executable;
-    char *userExecutable;
+    // NL_NODEFLAG_EXECUTABLE, NL_NODEFLAG_USEREXECUTABLE
+    uint8_t flags;
 };
 typedef struct NL_MethodNode NL_MethodNode;
 
@@ -229,7 +288,8 @@ struct NL_ReferenceTypeNode
 {
     NL_NODE_ATTRIBUTES
     NL_LocalizedText inverseName;
-    char *symmetric;
+    // NL_NODEFLAG_SYMMETRIC
+    uint8_t flags;
 };
 typedef struct NL_ReferenceTypeNode NL_ReferenceTypeNode;
 
@@ -237,8 +297,9 @@ struct NL_ViewNode
 {
     NL_NODE_ATTRIBUTES
     NL_NODE_INSTANCE_ATTRIBUTES
-    char *containsNoLoops;
-    char *eventNotifier;
+    uint8_t eventNotifier;
+    // NL_NODEFLAG_CONTAINSNOLOOPS
+    uint8_t flags;
 };
 typedef struct NL_ViewNode NL_ViewNode;
 
@@ -260,15 +321,74 @@ LOADER_EXPORT NodesetLoader *NodesetLoader_new(NodesetLoader_Logger *logger,
                                                struct NL_ReferenceService *refService);
 LOADER_EXPORT bool NodesetLoader_importFile(NodesetLoader *loader,
                                             const NL_FileContext *fileContext);
+// imports a nodeset which is already in memory, fileContext->file is ignored
+// the buffer is not copied and has to stay valid during the call
+LOADER_EXPORT bool NodesetLoader_importBuffer(NodesetLoader *loader,
+                                              const NL_FileContext *fileContext,
+                                              const char *buffer, size_t size);
 LOADER_EXPORT void NodesetLoader_delete(NodesetLoader *loader);
 LOADER_EXPORT const NL_BiDirectionalReference *
 NodesetLoader_getBidirectionalRefs(const NodesetLoader *loader);
 LOADER_EXPORT bool NodesetLoader_sort(NodesetLoader *loader);
+// references to nodes of namespaces without any imported node, e.g. the nodes
+// of namespace 0 which already exist in the server, are treated as satisfied
+// by NodesetLoader_sort and are left out of the sorting graph. A node of such
+// a namespace which depends on an imported node is not taken into account
+// anymore, so this is off by default.
+LOADER_EXPORT void
+NodesetLoader_setPruneUnloadedNamespaces(NodesetLoader *loader, bool prune);
+// the values of variables are not decoded while parsing, only the content of
+// the value element is kept and decoded by NL_Value_decode. Applies to
+// uncompressed files and buffers, values of other input are decoded at once.
+// Off by default.
+LOADER_EXPORT void NodesetLoader_setLazyValues(NodesetLoader *loader,
+                                               bool lazy);
+// the values of variables are passed to the decoders of valueInterface, which
+// has to stay valid during the imports. Values which are declined by the
+// interface are decoded as without it. NULL resets the interface.
+LOADER_EXPORT void
+NodesetLoader_setValueInterface(NodesetLoader *loader,
+                                const NL_ValueInterface *valueInterface);
+// builds the data of a value which was kept as xml, does nothing if the value
+// is already decoded. The data is released together with the loader, the
+// values of one loader must not be decoded concurrently.
+LOADER_EXPORT bool NL_Value_decode(NL_Value *value);
 typedef void (*NodesetLoader_forEachNode_Func)(void *context, NL_Node *node);
 LOADER_EXPORT size_t
 NodesetLoader_forEachNode(NodesetLoader *loader, NL_NodeClass nodeClass,
                           void *context, NodesetLoader_forEachNode_Func fn);
+// nodes of all classes grouped by their dependency level after
+// NodesetLoader_sort: the nodes of one level don't depend on each other, all
+// nodes they depend on are part of lower levels. The nodes of a level can be
+// prepared concurrently, fn is called for the levels in ascending order.
+// Returns the number of levels.
+typedef void (*NodesetLoader_forEachLevel_Func)(void *context, size_t level,
+                                                NL_Node **nodes,
+                                                size_t nodeCount);
+LOADER_EXPORT size_t
+NodesetLoader_forEachLevel(NodesetLoader *loader, void *context,
+                           NodesetLoader_forEachLevel_Func fn);
 LOADER_EXPORT bool NodesetLoader_isInstanceNode (const NL_Node *baseNode);
+// allocates a zeroed reference which can be added to a node of the loader,
+// the reference is released together with the loader, the node ids of
+// references in the lists of a node are cleared by the loader
+LOADER_EXPORT NL_Reference *NodesetLoader_newReference(NodesetLoader *loader);
+// returns the node with this id or NULL, the namespace index of the id is the
+// one of the server (after the namespace translation of the import)
+LOADER_EXPORT NL_Node *NodesetLoader_getNode(const NodesetLoader *loader,
+                                             const UA_NodeId *id);
+// moves the references of all sorted nodes into one contiguous array, has to
+// be called after NodesetLoader_sort. The reference lists of the nodes stay
+// valid and point into the array, the next pointers link adjacent elements.
+// References which are added to a node afterwards are not part of the array,
+// they have to be added before this call.
+LOADER_EXPORT bool NodesetLoader_compactReferences(NodesetLoader *loader);
+// array access to the references of a node after
+// NodesetLoader_compactReferences, returns NULL if there are none
+LOADER_EXPORT const NL_Reference *
+NodesetLoader_getHierachicalRefs(const NL_Node *node, size_t *size);
+LOADER_EXPORT const NL_Reference *
+NodesetLoader_getNonHierachicalRefs(const NL_Node *node, size_t *size);
 #ifdef __cplusplus
 }
 #endif
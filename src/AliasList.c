@@ -6,17 +6,78 @@
  */
 
 #include "AliasList.h"
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define MAX_ALIAS 300
+#define INITIAL_CAPACITY 64
+
+// open addressing with linear probing, the capacity is a power of two and the
+// table grows before it is half full
+typedef struct
+{
+    uint32_t hash;
+    Alias alias;
+} Entry;
 
 struct AliasList
 {
-    Alias *data;
+    Entry *entries;
+    size_t capacity;
     size_t size;
+    // target of aliases which are defined twice, the first definition wins
+    Alias duplicate;
 };
 
+// FNV-1a
+static uint32_t hashName(const char *name)
+{
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *c = (const unsigned char *)name; *c; c++)
+    {
+        hash ^= *c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static Entry *findSlot(Entry *entries, size_t capacity, uint32_t hash,
+                       const char *name)
+{
+    size_t mask = capacity - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        Entry *e = &entries[i];
+        if (!e->alias.name ||
+            (e->hash == hash && !strcmp(e->alias.name, name)))
+        {
+            return e;
+        }
+    }
+}
+
+static bool grow(AliasList *list)
+{
+    size_t capacity = list->capacity * 2;
+    Entry *entries = (Entry *)calloc(capacity, sizeof(Entry));
+    if (!entries)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < list->capacity; i++)
+    {
+        const Entry *e = &list->entries[i];
+        if (e->alias.name)
+        {
+            *findSlot(entries, capacity, e->hash, e->alias.name) = *e;
+        }
+    }
+    free(list->entries);
+    list->entries = entries;
+    list->capacity = capacity;
+    return true;
+}
+
 AliasList *AliasList_new(void)
 {
     struct AliasList *list = (AliasList *)calloc(1, sizeof(*list));
@@ -24,8 +85,9 @@ AliasList *AliasList_new(void)
     {
         return NULL;
     }
-    list->data = (Alias *)calloc(MAX_ALIAS, sizeof(Alias));
-    if(!list->data)
+    list->capacity = INITIAL_CAPACITY;
+    list->entries = (Entry *)calloc(list->capacity, sizeof(Entry));
+    if(!list->entries)
     {
         free(list);
         return NULL;
@@ -35,14 +97,28 @@ AliasList *AliasList_new(void)
 
 Alias *AliasList_newAlias(AliasList *list, char *name)
 {
-    if(list->size >= MAX_ALIAS)
+    if (!name)
+    {
+        return NULL;
+    }
+    if ((list->size + 1) * 2 > list->capacity && !grow(list))
     {
         return NULL;
     }
-    list->data[list->size].name = name;
-    UA_NodeId_init(&list->data[list->size].id);
+    uint32_t hash = hashName(name);
+    Entry *e = findSlot(list->entries, list->capacity, hash, name);
+    if (e->alias.name)
+    {
+        // the target of the previous duplicate is not needed anymore
+        UA_NodeId_clear(&list->duplicate.id);
+        list->duplicate.name = name;
+        return &list->duplicate;
+    }
+    e->hash = hash;
+    e->alias.name = name;
+    UA_NodeId_init(&e->alias.id);
     list->size++;
-    return &list->data[list->size - 1];
+    return &e->alias;
 }
 
 const UA_NodeId *
@@ -50,15 +126,39 @@ const UA_NodeId *
     if(!name)
         return NULL;
 
-    for(Alias* alias = list->data; alias != list->data + list->size; alias++) {
-        if (!strcmp(name, alias->name))
-            return &alias->id;
+    const Entry *e =
+        findSlot(list->entries, list->capacity, hashName(name), name);
+    return e->alias.name ? &e->alias.id : NULL;
+}
+
+// the targets are parsed from the alias definitions and may own memory, e.g.
+// string node ids
+static void clearTargets(AliasList *list)
+{
+    for (size_t i = 0; i < list->capacity; i++)
+    {
+        if (list->entries[i].alias.name)
+        {
+            UA_NodeId_clear(&list->entries[i].alias.id);
+        }
     }
-    return NULL;
+    UA_NodeId_clear(&list->duplicate.id);
+}
+
+void AliasList_clear(AliasList *list)
+{
+    clearTargets(list);
+    memset(list->entries, 0, list->capacity * sizeof(Entry));
+    list->size = 0;
 }
 
 void AliasList_delete(AliasList *list)
 {
-    free(list->data);
+    if (!list)
+    {
+        return;
+    }
+    clearTargets(list);
+    free(list->entries);
     free(list);
 }
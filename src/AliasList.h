@@ -18,11 +18,17 @@ struct Alias
 
 typedef struct Alias Alias;
 
+// aliases by their name, the names are not copied and have to stay valid
+// while they are part of the list
 struct AliasList;
 typedef struct AliasList AliasList;
 AliasList *AliasList_new(void);
+// the returned alias is valid until the next alias is added, NULL if name is
+// NULL or on allocation failures
 Alias *AliasList_newAlias(AliasList *list, char *name);
 const UA_NodeId *AliasList_getNodeId(const AliasList *list, const char *alias);
+// removes all aliases
+void AliasList_clear(AliasList *list);
 void AliasList_delete(AliasList *list);
 
 #endif
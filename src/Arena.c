@@ -0,0 +1,126 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "Arena.h"
+#include <stdlib.h>
+
+// allocations are placed at multiples of the strictest alignment of the
+// types stored in nodes
+typedef union
+{
+    void *p;
+    double d;
+    long long ll;
+} MaxAlign;
+
+struct Block
+{
+    struct Block *next;
+    size_t capacity;
+    char *mem;
+};
+
+struct Arena
+{
+    size_t blockSize;
+    // bytes which are already handed out from the current block
+    size_t used;
+    size_t blockCount;
+    struct Block *current;
+};
+
+Arena *Arena_new(size_t blockSize)
+{
+    Arena *arena = (Arena *)calloc(1, sizeof(Arena));
+    if (!arena)
+    {
+        return NULL;
+    }
+    arena->blockSize = blockSize > 0 ? blockSize : 1;
+    return arena;
+}
+
+static struct Block *Block_new(size_t capacity)
+{
+    struct Block *block = (struct Block *)malloc(sizeof(struct Block));
+    if (!block)
+    {
+        return NULL;
+    }
+    block->mem = (char *)calloc(1, capacity);
+    if (!block->mem)
+    {
+        free(block);
+        return NULL;
+    }
+    block->capacity = capacity;
+    block->next = NULL;
+    return block;
+}
+
+void *Arena_alloc(Arena *arena, size_t size)
+{
+    const size_t align = sizeof(MaxAlign);
+    size = size > 0 ? (size + align - 1) / align * align : align;
+    if (arena->current && arena->used + size <= arena->current->capacity)
+    {
+        void *mem = arena->current->mem + arena->used;
+        arena->used += size;
+        return mem;
+    }
+    if (size > arena->blockSize / 4)
+    {
+        // large allocations get a block of their own, the remainder of the
+        // current block stays usable
+        struct Block *block = Block_new(size);
+        if (!block)
+        {
+            return NULL;
+        }
+        if (arena->current)
+        {
+            block->next = arena->current->next;
+            arena->current->next = block;
+        }
+        else
+        {
+            arena->current = block;
+            arena->used = size;
+        }
+        arena->blockCount++;
+        return block->mem;
+    }
+    struct Block *block = Block_new(arena->blockSize);
+    if (!block)
+    {
+        return NULL;
+    }
+    block->next = arena->current;
+    arena->current = block;
+    arena->used = size;
+    arena->blockCount++;
+    return block->mem;
+}
+
+size_t Arena_blockCount(const Arena *arena)
+{
+    return arena->blockCount;
+}
+
+void Arena_delete(Arena *arena)
+{
+    if (!arena)
+    {
+        return;
+    }
+    struct Block *block = arena->current;
+    while (block)
+    {
+        struct Block *next = block->next;
+        free(block->mem);
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
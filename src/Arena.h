@@ -0,0 +1,21 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef ARENA_H
+#define ARENA_H
+#include <stddef.h>
+
+// allocates objects of any size from blocks, single objects cannot be freed,
+// all of them are released at once when the arena is deleted
+struct Arena;
+typedef struct Arena Arena;
+
+Arena *Arena_new(size_t blockSize);
+// returns zeroed memory which is aligned for any type stored in nodes, NULL
+// if no new block can be allocated
+void *Arena_alloc(Arena *arena, size_t size);
+size_t Arena_blockCount(const Arena *arena);
+void Arena_delete(Arena *arena);
+
+#endif
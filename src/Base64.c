@@ -0,0 +1,278 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "Base64.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// blocks without whitespace and padding are decoded with ssse3 or avx2 if the
+// cpu supports it, the selection needs the target attribute of gcc and clang
+#if (defined(__GNUC__) || defined(__clang__)) &&                              \
+    (defined(__x86_64__) || defined(__i386__))
+#define BASE64_X86
+#include <immintrin.h>
+#endif
+
+#define SIXTET_PAD 64
+#define SIXTET_SPACE 65
+#define SIXTET_INVALID 66
+
+typedef struct
+{
+    const unsigned char *in;
+    const unsigned char *inEnd;
+    unsigned char *out;
+    unsigned char *outEnd;
+    // significant characters, including padding
+    size_t count;
+    // the last two significant characters were padding
+    unsigned pads;
+} Decoder;
+
+// sixtet of each character, 64 is padding, 65 whitespace and 66 invalid
+static const unsigned char sixtets[256] = {
+    66, 66, 66, 66, 66, 66, 66, 66, 66, 65, 65, 65, 65, 65, 66, 66,
+    66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66,
+    65, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 62, 66, 66, 66, 63,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 66, 66, 66, 64, 66, 66,
+    66,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 66, 66, 66, 66, 66,
+    66, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 66, 66, 66, 66, 66,
+    66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66,
+    66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66,
+    66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66,
+    66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66,
+    66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66,
+    66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66,
+    66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66,
+    66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66, 66,
+};
+
+#ifdef BASE64_X86
+// decodes 16 characters to 12 bytes, 16 bytes are written. Returns false if a
+// character is not part of the alphabet, padding and whitespace included.
+// Lookup tables by Wojciech Muła, see
+// http://0x80.pl/notesen/2016-01-17-sse-base64-decoding.html
+__attribute__((target("ssse3"))) static bool decodeBlock16(Decoder *d)
+{
+    const __m128i in = _mm_loadu_si128((const __m128i *)(const void *)d->in);
+    const __m128i loLut =
+        _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                      0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i hiLut =
+        _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10,
+                      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i rollLut = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0,
+                                          0, 0, 0, 0, 0, 0, 0);
+    const __m128i nibbleMask = _mm_set1_epi8(0x0f);
+    const __m128i hiNibbles =
+        _mm_and_si128(_mm_srli_epi32(in, 4), nibbleMask);
+    const __m128i loNibbles = _mm_and_si128(in, nibbleMask);
+    const __m128i lo = _mm_shuffle_epi8(loLut, loNibbles);
+    const __m128i hi = _mm_shuffle_epi8(hiLut, hiNibbles);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi),
+                                         _mm_setzero_si128())) != 0xFFFF)
+    {
+        return false;
+    }
+    const __m128i isSlash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+    const __m128i roll =
+        _mm_shuffle_epi8(rollLut, _mm_add_epi8(isSlash, hiNibbles));
+    const __m128i values = _mm_add_epi8(in, roll);
+    // 4 sixtets to 24 bits in each 32 bit lane
+    const __m128i pairs =
+        _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    const __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    const __m128i out = _mm_shuffle_epi8(
+        quads, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1,
+                             -1, -1));
+    _mm_storeu_si128((__m128i *)(void *)d->out, out);
+    d->in += 16;
+    d->out += 12;
+    d->count += 16;
+    d->pads = 0;
+    return true;
+}
+
+// decodes 32 characters to 24 bytes, 32 bytes are written
+__attribute__((target("avx2"))) static bool decodeBlock32(Decoder *d)
+{
+    const __m256i in =
+        _mm256_loadu_si256((const __m256i *)(const void *)d->in);
+    const __m256i loLut = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A,
+        0x1B, 0x1B, 0x1B, 0x1A, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i hiLut = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i rollLut = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 19, 4,
+        -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i nibbleMask = _mm256_set1_epi8(0x0f);
+    const __m256i hiNibbles =
+        _mm256_and_si256(_mm256_srli_epi32(in, 4), nibbleMask);
+    const __m256i loNibbles = _mm256_and_si256(in, nibbleMask);
+    const __m256i lo = _mm256_shuffle_epi8(loLut, loNibbles);
+    const __m256i hi = _mm256_shuffle_epi8(hiLut, hiNibbles);
+    if (!_mm256_testz_si256(lo, hi))
+    {
+        return false;
+    }
+    const __m256i isSlash = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('/'));
+    const __m256i roll =
+        _mm256_shuffle_epi8(rollLut, _mm256_add_epi8(isSlash, hiNibbles));
+    const __m256i values = _mm256_add_epi8(in, roll);
+    const __m256i pairs =
+        _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    const __m256i quads =
+        _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+    // 12 bytes in each 128 bit lane, then both lanes are joined
+    const __m256i packed = _mm256_shuffle_epi8(
+        quads, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1,
+                                -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                                -1, -1, -1, -1));
+    const __m256i out = _mm256_permutevar8x32_epi32(
+        packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+    _mm256_storeu_si256((__m256i *)(void *)d->out, out);
+    d->in += 32;
+    d->out += 24;
+    d->count += 32;
+    d->pads = 0;
+    return true;
+}
+
+typedef enum
+{
+    SIMD_NONE,
+    SIMD_SSSE3,
+    SIMD_AVX2
+} SimdLevel;
+
+static SimdLevel detectSimd(void)
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        return SIMD_SSSE3;
+    }
+    return SIMD_NONE;
+}
+
+// decodes blocks as long as they contain only characters of the alphabet
+static void decodeBlocks(Decoder *d, SimdLevel simdLevel)
+{
+    if (simdLevel == SIMD_AVX2)
+    {
+        while (d->inEnd - d->in >= 32 && d->outEnd - d->out >= 32 &&
+               decodeBlock32(d))
+        {
+        }
+    }
+    if (simdLevel >= SIMD_SSSE3)
+    {
+        while (d->inEnd - d->in >= 16 && d->outEnd - d->out >= 16 &&
+               decodeBlock16(d))
+        {
+        }
+    }
+}
+#endif
+
+// decodes characters until the next group of 4 sixtets is complete, returns
+// false on invalid characters
+static bool decodeGroup(Decoder *d)
+{
+    uint32_t group = 0;
+    unsigned sixtetCount = 0;
+    while (d->in < d->inEnd)
+    {
+        unsigned char sixtet = sixtets[*d->in++];
+        if (sixtet == SIXTET_SPACE)
+        {
+            continue;
+        }
+        if (sixtet == SIXTET_INVALID)
+        {
+            return false;
+        }
+        d->count++;
+        d->pads = ((d->pads << 1) | (sixtet == SIXTET_PAD)) & 3u;
+        // padding inside of the text counts as zero bits
+        group = (group << 6) | (sixtet == SIXTET_PAD ? 0u : sixtet);
+        if (++sixtetCount == 4)
+        {
+            d->out[0] = (unsigned char)(group >> 16);
+            d->out[1] = (unsigned char)(group >> 8);
+            d->out[2] = (unsigned char)group;
+            d->out += 3;
+            return true;
+        }
+    }
+    // incomplete group at the end of the text
+    if (sixtetCount == 2)
+    {
+        *d->out++ = (unsigned char)(group >> 4);
+    }
+    else if (sixtetCount == 3)
+    {
+        d->out[0] = (unsigned char)(group >> 10);
+        d->out[1] = (unsigned char)(group >> 2);
+        d->out += 2;
+    }
+    return true;
+}
+
+unsigned char *Base64_decode(const char *text, size_t size,
+                             size_t *decodedSize)
+{
+    *decodedSize = 0;
+    // whitespace only makes the decoded data smaller
+    const size_t capacity = size / 4 * 3 + 3;
+    unsigned char *data = (unsigned char *)malloc(capacity);
+    if (!data)
+    {
+        return NULL;
+    }
+    Decoder d;
+    d.in = (const unsigned char *)text;
+    d.inEnd = d.in + size;
+    d.out = data;
+    d.outEnd = data + capacity;
+    d.count = 0;
+    d.pads = 0;
+#ifdef BASE64_X86
+    const SimdLevel simdLevel = detectSimd();
+#endif
+    while (d.in < d.inEnd)
+    {
+#ifdef BASE64_X86
+        decodeBlocks(&d, simdLevel);
+#endif
+        if (!decodeGroup(&d))
+        {
+            free(data);
+            return NULL;
+        }
+    }
+    if (d.count < 2)
+    {
+        free(data);
+        return NULL;
+    }
+    // the padding at the end is not part of the data
+    size_t pads = (d.pads & 1u) + (d.pads >> 1);
+    size_t length = d.count / 4 * 3 + (d.count % 4 * 3) / 4;
+    length = length > pads ? length - pads : 0;
+    size_t written = (size_t)(d.out - data);
+    *decodedSize = length < written ? length : written;
+    return data;
+}
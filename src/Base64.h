@@ -0,0 +1,16 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BASE64_H
+#define BASE64_H
+#include <stddef.h>
+
+// decodes base64 text of length size, whitespace is skipped. Returns the
+// allocated data with its length in decodedSize or NULL if the text contains
+// other characters or has less than 2 significant characters. Missing
+// padding at the end is accepted.
+unsigned char *Base64_decode(const char *text, size_t size,
+                             size_t *decodedSize);
+
+#endif
@@ -55,6 +55,11 @@ CharArenaAllocator *CharArenaAllocator_new(size_t initialSize)
     }
     arena->initialSize = initialSize;
     arena->current = Region_new(arena->initialSize);
+    if(!arena->current)
+    {
+        free(arena);
+        return NULL;
+    }
     return arena;
 }
 
@@ -111,6 +116,10 @@ char *CharArenaAllocator_realloc(CharArenaAllocator *arena, size_t size)
 
 void CharArenaAllocator_delete(CharArenaAllocator *arena)
 {
+    if (!arena)
+    {
+        return;
+    }
     struct Region *r = arena->current;
     while (r)
     {
@@ -0,0 +1,380 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "CompressedInput.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NODESETLOADER_ENABLE_GZIP
+#include <zlib.h>
+#endif
+#ifdef NODESETLOADER_ENABLE_ZSTD
+#include <zstd.h>
+#endif
+
+#define FILE_CHUNK_SIZE (64 * 1024)
+// limit of a single block handed over to the decompressor
+#define MAX_BLOCK_SIZE ((size_t)1 << 30)
+
+struct CompressedInput
+{
+    CompressedInput_Format format;
+    // compressed bytes, either the whole memory block or the last chunk
+    // which was read from file
+    const char *src;
+    size_t srcLen;
+    size_t srcPos;
+    FILE *file;
+    char *fileChunk;
+    // set as soon as a complete stream or frame was decoded
+    bool streamEnded;
+    const char *error;
+#ifdef NODESETLOADER_ENABLE_GZIP
+    z_stream zs;
+    bool zsInitialized;
+#endif
+#ifdef NODESETLOADER_ENABLE_ZSTD
+    ZSTD_DStream *zds;
+    ZSTD_inBuffer zin;
+#endif
+};
+
+static const unsigned char gzipMagic[] = {0x1f, 0x8b};
+static const unsigned char zstdMagic[] = {0x28, 0xb5, 0x2f, 0xfd};
+
+static bool hasMagic(const char *data, size_t size, const unsigned char *magic,
+                     size_t magicSize)
+{
+    return size >= magicSize && !memcmp(data, magic, magicSize);
+}
+
+CompressedInput_Format CompressedInput_detect(const char *data, size_t size)
+{
+    if (!data)
+    {
+        return COMPRESSION_NONE;
+    }
+    if (hasMagic(data, size, gzipMagic, sizeof(gzipMagic)))
+    {
+        return COMPRESSION_GZIP;
+    }
+    if (hasMagic(data, size, zstdMagic, sizeof(zstdMagic)))
+    {
+        return COMPRESSION_ZSTD;
+    }
+    return COMPRESSION_NONE;
+}
+
+bool CompressedInput_isSupported(CompressedInput_Format format)
+{
+    switch (format)
+    {
+    case COMPRESSION_NONE:
+        return true;
+    case COMPRESSION_GZIP:
+#ifdef NODESETLOADER_ENABLE_GZIP
+        return true;
+#else
+        return false;
+#endif
+    case COMPRESSION_ZSTD:
+#ifdef NODESETLOADER_ENABLE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+const char *CompressedInput_formatName(CompressedInput_Format format)
+{
+    switch (format)
+    {
+    case COMPRESSION_NONE:
+        return "uncompressed";
+    case COMPRESSION_GZIP:
+        return "gzip";
+    case COMPRESSION_ZSTD:
+        return "zstd";
+    }
+    return "unknown";
+}
+
+// reads the next chunk if all bytes of the current one are consumed, returns
+// false at the end of the input
+static bool refill(CompressedInput *input)
+{
+    if (input->srcPos == input->srcLen && input->file)
+    {
+        input->srcLen =
+            fread(input->fileChunk, 1, FILE_CHUNK_SIZE, input->file);
+        input->srcPos = 0;
+        if (ferror(input->file))
+        {
+            input->error = "read error";
+            input->srcLen = 0;
+        }
+    }
+    return input->srcPos < input->srcLen;
+}
+
+#if defined(NODESETLOADER_ENABLE_GZIP) || defined(NODESETLOADER_ENABLE_ZSTD)
+// hands the next block of compressed bytes over to the decompressor
+static bool fetch(CompressedInput *input, const char **data, size_t *len)
+{
+    if (!refill(input))
+    {
+        return false;
+    }
+    size_t pending = input->srcLen - input->srcPos;
+    *data = input->src + input->srcPos;
+    *len = pending < MAX_BLOCK_SIZE ? pending : MAX_BLOCK_SIZE;
+    input->srcPos += *len;
+    return true;
+}
+#endif
+
+static int readPlain(CompressedInput *input, char *buffer, int len)
+{
+    size_t written = 0;
+    while (written < (size_t)len && refill(input))
+    {
+        size_t n = input->srcLen - input->srcPos;
+        if (n > (size_t)len - written)
+        {
+            n = (size_t)len - written;
+        }
+        memcpy(buffer + written, input->src + input->srcPos, n);
+        input->srcPos += n;
+        written += n;
+    }
+    return input->error ? -1 : (int)written;
+}
+
+#ifdef NODESETLOADER_ENABLE_GZIP
+static bool initGzip(CompressedInput *input)
+{
+    // 15 + 32: maximum window size, detect the gzip or zlib header
+    if (inflateInit2(&input->zs, 15 + 32) != Z_OK)
+    {
+        return false;
+    }
+    input->zsInitialized = true;
+    return true;
+}
+
+static int readGzip(CompressedInput *input, char *buffer, int len)
+{
+    z_stream *zs = &input->zs;
+    zs->next_out = (Bytef *)buffer;
+    zs->avail_out = (uInt)len;
+    while (zs->avail_out > 0 && !input->error)
+    {
+        if (zs->avail_in == 0)
+        {
+            const char *data = NULL;
+            size_t avail = 0;
+            if (!fetch(input, &data, &avail))
+            {
+                if (!input->streamEnded && !input->error)
+                {
+                    input->error = "gzip stream is truncated";
+                }
+                break;
+            }
+            zs->next_in = (Bytef *)(uintptr_t)data;
+            zs->avail_in = (uInt)avail;
+        }
+        if (input->streamEnded)
+        {
+            // concatenated gzip members are decoded as one stream
+            inflateReset(zs);
+            input->streamEnded = false;
+        }
+        int res = inflate(zs, Z_NO_FLUSH);
+        if (res == Z_STREAM_END)
+        {
+            input->streamEnded = true;
+        }
+        else if (res != Z_OK && res != Z_BUF_ERROR)
+        {
+            input->error = "gzip stream is corrupt";
+        }
+    }
+    if (input->error)
+    {
+        return -1;
+    }
+    return len - (int)zs->avail_out;
+}
+#endif
+
+#ifdef NODESETLOADER_ENABLE_ZSTD
+static bool initZstd(CompressedInput *input)
+{
+    input->zds = ZSTD_createDStream();
+    if (!input->zds)
+    {
+        return false;
+    }
+    return !ZSTD_isError(ZSTD_initDStream(input->zds));
+}
+
+static int readZstd(CompressedInput *input, char *buffer, int len)
+{
+    ZSTD_outBuffer out = {buffer, (size_t)len, 0};
+    while (out.pos < out.size && !input->error)
+    {
+        if (input->zin.pos == input->zin.size)
+        {
+            const char *data = NULL;
+            size_t avail = 0;
+            if (!fetch(input, &data, &avail))
+            {
+                if (!input->streamEnded && !input->error)
+                {
+                    input->error = "zstd stream is truncated";
+                }
+                break;
+            }
+            input->zin.src = data;
+            input->zin.size = avail;
+            input->zin.pos = 0;
+        }
+        size_t res = ZSTD_decompressStream(input->zds, &out, &input->zin);
+        if (ZSTD_isError(res))
+        {
+            input->error = "zstd stream is corrupt";
+        }
+        // 0 is returned when a frame is completely decoded and flushed,
+        // further frames are decoded as continuation of the stream
+        input->streamEnded = res == 0;
+    }
+    if (input->error)
+    {
+        return -1;
+    }
+    return (int)out.pos;
+}
+#endif
+
+static CompressedInput *init(CompressedInput *input)
+{
+    input->format = CompressedInput_detect(input->src, input->srcLen);
+    bool ok = true;
+    switch (input->format)
+    {
+    case COMPRESSION_NONE:
+        break;
+    case COMPRESSION_GZIP:
+#ifdef NODESETLOADER_ENABLE_GZIP
+        ok = initGzip(input);
+#endif
+        break;
+    case COMPRESSION_ZSTD:
+#ifdef NODESETLOADER_ENABLE_ZSTD
+        ok = initZstd(input);
+#endif
+        break;
+    }
+    if (!ok)
+    {
+        CompressedInput_delete(input);
+        return NULL;
+    }
+    return input;
+}
+
+CompressedInput *CompressedInput_newFromMemory(const char *data, size_t size)
+{
+    CompressedInput *input =
+        (CompressedInput *)calloc(1, sizeof(CompressedInput));
+    if (!input)
+    {
+        return NULL;
+    }
+    input->src = data;
+    input->srcLen = size;
+    return init(input);
+}
+
+CompressedInput *CompressedInput_newFromFile(FILE *file)
+{
+    CompressedInput *input =
+        (CompressedInput *)calloc(1, sizeof(CompressedInput));
+    if (!input)
+    {
+        return NULL;
+    }
+    input->fileChunk = (char *)malloc(FILE_CHUNK_SIZE);
+    if (!input->fileChunk)
+    {
+        free(input);
+        return NULL;
+    }
+    input->file = file;
+    input->src = input->fileChunk;
+    // the first chunk is needed to detect the format
+    input->srcLen = fread(input->fileChunk, 1, FILE_CHUNK_SIZE, file);
+    return init(input);
+}
+
+CompressedInput_Format CompressedInput_format(const CompressedInput *input)
+{
+    return input->format;
+}
+
+int CompressedInput_read(void *ctx, char *buffer, int len)
+{
+    CompressedInput *input = (CompressedInput *)ctx;
+    if (len <= 0)
+    {
+        return 0;
+    }
+    switch (input->format)
+    {
+    case COMPRESSION_NONE:
+        return readPlain(input, buffer, len);
+    case COMPRESSION_GZIP:
+#ifdef NODESETLOADER_ENABLE_GZIP
+        return readGzip(input, buffer, len);
+#else
+        break;
+#endif
+    case COMPRESSION_ZSTD:
+#ifdef NODESETLOADER_ENABLE_ZSTD
+        return readZstd(input, buffer, len);
+#else
+        break;
+#endif
+    }
+    input->error = "compression format not supported";
+    return -1;
+}
+
+const char *CompressedInput_error(const CompressedInput *input)
+{
+    return input->error;
+}
+
+void CompressedInput_delete(CompressedInput *input)
+{
+    if (!input)
+    {
+        return;
+    }
+#ifdef NODESETLOADER_ENABLE_GZIP
+    if (input->zsInitialized)
+    {
+        inflateEnd(&input->zs);
+    }
+#endif
+#ifdef NODESETLOADER_ENABLE_ZSTD
+    ZSTD_freeDStream(input->zds);
+#endif
+    free(input->fileChunk);
+    free(input);
+}
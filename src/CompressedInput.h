@@ -0,0 +1,40 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef COMPRESSEDINPUT_H
+#define COMPRESSEDINPUT_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+typedef enum
+{
+    COMPRESSION_NONE,
+    COMPRESSION_GZIP,
+    COMPRESSION_ZSTD
+} CompressedInput_Format;
+
+// input of a nodeset which is decompressed on the fly, the format is detected
+// by the magic bytes at the start of the input, uncompressed input is passed
+// through unchanged
+struct CompressedInput;
+typedef struct CompressedInput CompressedInput;
+
+CompressedInput_Format CompressedInput_detect(const char *data, size_t size);
+// false if the loader was built without support for this format
+bool CompressedInput_isSupported(CompressedInput_Format format);
+const char *CompressedInput_formatName(CompressedInput_Format format);
+
+// data has to stay valid until the input is deleted
+CompressedInput *CompressedInput_newFromMemory(const char *data, size_t size);
+CompressedInput *CompressedInput_newFromFile(FILE *file);
+CompressedInput_Format CompressedInput_format(const CompressedInput *input);
+// Parser_callbackRead, returns the number of decompressed bytes written to
+// buffer, 0 at the end of the input and -1 on errors
+int CompressedInput_read(void *input, char *buffer, int len);
+// description of the last error or NULL
+const char *CompressedInput_error(const CompressedInput *input);
+void CompressedInput_delete(CompressedInput *input);
+
+#endif
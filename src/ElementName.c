@@ -0,0 +1,65 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "ElementName.h"
+#include <string.h>
+
+#define TABLE_SIZE 64
+
+typedef struct
+{
+    const char *name;
+    size_t len;
+    ElementName element;
+} Entry;
+
+// perfect hash over the known element names: length, third and last
+// character. All known names have at least 3 characters and no two of them
+// share a slot, so a single compare confirms the match.
+static size_t hash(const char *name, size_t len)
+{
+    return (len + (size_t)(unsigned char)name[2] * 15 +
+            (size_t)(unsigned char)name[len - 1]) &
+           (TABLE_SIZE - 1);
+}
+
+static const Entry table[TABLE_SIZE] = {
+    [2] = {"UAReferenceType", 15, ELEMENT_UAREFERENCETYPE},
+    [3] = {"Extension", 9, ELEMENT_EXTENSION},
+    [7] = {"UAView", 6, ELEMENT_UAVIEW},
+    [9] = {"Extensions", 10, ELEMENT_EXTENSIONS},
+    [15] = {"UANodeSet", 9, ELEMENT_UANODESET},
+    [18] = {"UAObjectType", 12, ELEMENT_UAOBJECTTYPE},
+    [19] = {"Uri", 3, ELEMENT_URI},
+    [20] = {"Field", 5, ELEMENT_FIELD},
+    [26] = {"InverseName", 11, ELEMENT_INVERSENAME},
+    [29] = {"UAObject", 8, ELEMENT_UAOBJECT},
+    [31] = {"Alias", 5, ELEMENT_ALIAS},
+    [33] = {"Aliases", 7, ELEMENT_ALIASES},
+    [35] = {"NamespaceUris", 13, ELEMENT_NAMESPACEURIS},
+    [40] = {"Reference", 9, ELEMENT_REFERENCE},
+    [43] = {"UADataType", 10, ELEMENT_UADATATYPE},
+    [45] = {"DisplayName", 11, ELEMENT_DISPLAYNAME},
+    [47] = {"UAMethod", 8, ELEMENT_UAMETHOD},
+    [50] = {"Definition", 10, ELEMENT_DEFINITION},
+    [54] = {"Description", 11, ELEMENT_DESCRIPTION},
+    [55] = {"References", 10, ELEMENT_REFERENCES},
+    [57] = {"UAVariable", 10, ELEMENT_UAVARIABLE},
+    [61] = {"UAVariableType", 14, ELEMENT_UAVARIABLETYPE},
+    [62] = {"Value", 5, ELEMENT_VALUE}};
+
+ElementName ElementName_lookup(const char *localname)
+{
+    size_t len = strlen(localname);
+    if (len < 3)
+    {
+        return ELEMENT_UNKNOWN;
+    }
+    const Entry *entry = &table[hash(localname, len)];
+    if (entry->len != len || memcmp(entry->name, localname, len))
+    {
+        return ELEMENT_UNKNOWN;
+    }
+    return entry->element;
+}
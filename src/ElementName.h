@@ -0,0 +1,40 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef ELEMENTNAME_H
+#define ELEMENTNAME_H
+
+// xml elements of a nodeset which are handled by the parser
+typedef enum
+{
+    ELEMENT_UNKNOWN,
+    ELEMENT_UANODESET,
+    ELEMENT_NAMESPACEURIS,
+    ELEMENT_URI,
+    ELEMENT_ALIASES,
+    ELEMENT_ALIAS,
+    ELEMENT_UAOBJECT,
+    ELEMENT_UAOBJECTTYPE,
+    ELEMENT_UAVARIABLE,
+    ELEMENT_UAVARIABLETYPE,
+    ELEMENT_UADATATYPE,
+    ELEMENT_UAREFERENCETYPE,
+    ELEMENT_UAMETHOD,
+    ELEMENT_UAVIEW,
+    ELEMENT_DISPLAYNAME,
+    ELEMENT_DESCRIPTION,
+    ELEMENT_REFERENCES,
+    ELEMENT_REFERENCE,
+    ELEMENT_VALUE,
+    ELEMENT_EXTENSIONS,
+    ELEMENT_EXTENSION,
+    ELEMENT_INVERSENAME,
+    ELEMENT_DEFINITION,
+    ELEMENT_FIELD
+} ElementName;
+
+// resolves the local name of an element with one hash and one compare
+ElementName ElementName_lookup(const char *localname);
+
+#endif
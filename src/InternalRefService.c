@@ -6,183 +6,98 @@
  */
 
 #include "InternalRefService.h"
-#include "nodes/NodeContainer.h"
+#include "NodeIdMap.h"
 #include "NodesetLoader/NodesetLoader.h"
+#include "Ns0Tables.h"
+#include <stdint.h>
 #include <stdlib.h>
 
+// numeric ids of namespace 0 below this bound are looked up in a bitmap
+#define NS0_BITMAP_IDS 32768
+
 struct InternalRefService
 {
-    size_t hierachicalRefsSize;
-    NL_ReferenceTypeNode *hierachicalRefs;
-    struct NodeContainer *nonHierachicalRefs;
+    // hierachical reference types of namespace 0 which are not part of the
+    // generated tables
+    uint8_t ns0Hierachical[NS0_BITMAP_IDS / 8];
+    // all other hierachical reference types by their id
+    NodeIdMap *hierachicalRefs;
+    NodeIdMap *nonHierachicalRefs;
 };
 
 typedef struct InternalRefService InternalRefService;
 
-#define MAX_HIERACHICAL_REFS 50
-NL_ReferenceTypeNode hierachicalRefs[MAX_HIERACHICAL_REFS] = {
-    {NODECLASS_REFERENCETYPE,
-     {0, UA_NODEIDTYPE_NUMERIC, {35}},
-     {0, "Organizes"},
-     {NULL, NULL},
-     {NULL, NULL},
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     {NULL, NULL},
-     NULL,
-    },
-    {NODECLASS_REFERENCETYPE,
-     {0, UA_NODEIDTYPE_NUMERIC, {36}},
-     {0, "HasEventSource"},
-     {NULL, NULL},
-     {NULL, NULL},
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     {NULL, NULL},
-     NULL},
-    {NODECLASS_REFERENCETYPE,
-     {0, UA_NODEIDTYPE_NUMERIC, {48}},
-     {0, "HasNotifier"},
-     {NULL, NULL},
-     {NULL, NULL},
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     {NULL, NULL},
-     NULL},
-    {NODECLASS_REFERENCETYPE,
-     {0, UA_NODEIDTYPE_NUMERIC, {44}},
-     {0, "Aggregates"},
-     {NULL, NULL},
-     {NULL, NULL},
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     {NULL, NULL},
-     NULL},
-    {NODECLASS_REFERENCETYPE,
-     {0, UA_NODEIDTYPE_NUMERIC, {45}},
-     {0, "HasSubtype"},
-     {NULL, NULL},
-     {NULL, NULL},
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     {NULL, NULL},
-     NULL},
-    {NODECLASS_REFERENCETYPE,
-     {0, UA_NODEIDTYPE_NUMERIC, {47}},
-     {0, "HasComponent"},
-     {NULL, NULL},
-     {NULL, NULL},
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     {NULL, NULL},
-     NULL},
-    {NODECLASS_REFERENCETYPE,
-     {0, UA_NODEIDTYPE_NUMERIC, {46}},
-     {0, "HasProperty"},
-     {NULL, NULL},
-     {NULL, NULL},
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     {NULL, NULL},
-     NULL},
-    {NODECLASS_REFERENCETYPE,
-     {0, UA_NODEIDTYPE_NUMERIC, {38}},
-     {0, "HasEncoding"},
-     {NULL, NULL},
-     {NULL, NULL},
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     {NULL, NULL},
-     NULL},
-    {NODECLASS_REFERENCETYPE,
-     {0, UA_NODEIDTYPE_NUMERIC, {33}},
-     {0, "HierarchicalReferences"},
-     {NULL, NULL},
-     {NULL, NULL},
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     NULL,
-     {NULL, NULL},
-     NULL},
-};
+static bool isInNs0Bitmap(const UA_NodeId *id)
+{
+    return id->namespaceIndex == 0 &&
+           id->identifierType == UA_NODEIDTYPE_NUMERIC &&
+           id->identifier.numeric < NS0_BITMAP_IDS;
+}
+
+static void setNs0Hierachical(InternalRefService *service, UA_UInt32 id)
+{
+    service->ns0Hierachical[id / 8] |= (uint8_t)(1u << (id % 8));
+}
+
+static bool isHierachicalType(const InternalRefService *service,
+                              const UA_NodeId *id)
+{
+    const Ns0Tables_ReferenceType *ns0Type = Ns0Tables_findReferenceType(id);
+    if (ns0Type)
+    {
+        return (ns0Type->flags & NS0TABLES_HIERACHICAL) != 0;
+    }
+    if (isInNs0Bitmap(id))
+    {
+        UA_UInt32 n = id->identifier.numeric;
+        return (service->ns0Hierachical[n / 8] & (1u << (n % 8))) != 0;
+    }
+    return NodeIdMap_get(service->hierachicalRefs, id) != NULL;
+}
 
 static bool
 isRefNonHierachical(const InternalRefService *service,
                     const NL_Reference *ref) {
+    const Ns0Tables_ReferenceType *ns0Type =
+        Ns0Tables_findReferenceType(&ref->refType);
+    if (ns0Type)
+        return (ns0Type->flags & NS0TABLES_NONHIERACHICAL) != 0;
     // TODO: nonHierachicalrefs should also be imported first
     // we state that we know all references from namespace 0
     if (ref->refType.namespaceIndex == 0)
         return true;
 
-    for (size_t i = 0; i < service->nonHierachicalRefs->size; i++) {
-        if (UA_NodeId_equal(&ref->refType,
-                            &service->nonHierachicalRefs->nodes[i]->id))
-            return true;
-    }
-    return false;
+    return NodeIdMap_get(service->nonHierachicalRefs, &ref->refType) != NULL;
 }
 
 static bool
 isReferenceHierachical(const InternalRefService *service,
                        const NL_Reference *ref) {
-    for (size_t i = 0; i < service->hierachicalRefsSize; i++) {
-        if (UA_NodeId_equal(&ref->refType, &service->hierachicalRefs[i].id))
-            return true;
-    }
-    return false;
+    return isHierachicalType(service, &ref->refType);
 }
 
 static bool
 isRefTypeDef(const InternalRefService* service, const NL_Reference* ref) {
-    UA_NodeId hasTypeDefId = UA_NODEID_NUMERIC(0, 40);
-    return UA_NodeId_equal(&ref->refType, &hasTypeDefId);
+    const Ns0Tables_ReferenceType *ns0Type =
+        Ns0Tables_findReferenceType(&ref->refType);
+    return ns0Type && (ns0Type->flags & NS0TABLES_HASTYPEDEFINITION) != 0;
 }
 
 static void
 addnewRefTypeImpl(InternalRefService *service, NL_ReferenceTypeNode *node) {
-    NL_Reference *ref = node->hierachicalRefs;
+    // a subtype of a hierachical reference type is hierachical
     bool isHierachical = false;
-    while (ref) {
-        if (!ref->isForward) {
-            for (size_t i = 0; i < service->hierachicalRefsSize; i++) {
-                if (UA_NodeId_equal(&service->hierachicalRefs[i].id, &ref->target)) {
-                    service->hierachicalRefs[service->hierachicalRefsSize++] =
-                        *(NL_ReferenceTypeNode *)node;
-                    isHierachical = true;
-                    break;
-                }
-            }
-        }
-        ref = ref->next;
+    for (NL_Reference *ref = node->hierachicalRefs; ref && !isHierachical;
+         ref = ref->next) {
+        isHierachical =
+            !ref->isForward && isHierachicalType(service, &ref->target);
     }
     if (!isHierachical) {
-        NodeContainer_add(service->nonHierachicalRefs, (NL_Node *)node);
+        NodeIdMap_insert(service->nonHierachicalRefs, (NL_Node *)node);
+    } else if (isInNs0Bitmap(&node->id)) {
+        setNs0Hierachical(service, node->id.identifier.numeric);
+    } else {
+        NodeIdMap_insert(service->hierachicalRefs, (NL_Node *)node);
     }
 }
 
@@ -194,14 +109,16 @@ NL_ReferenceService *InternalRefService_new(void)
     {
         return NULL;
     }
-    service->hierachicalRefs = hierachicalRefs;
-    service->hierachicalRefsSize = 9;
-    service->nonHierachicalRefs = NodeContainer_new(100, false);
+    service->hierachicalRefs = NodeIdMap_new(64);
+    service->nonHierachicalRefs = NodeIdMap_new(64);
 
     NL_ReferenceService *refService = (NL_ReferenceService *)calloc(1, sizeof(NL_ReferenceService));
-    if(!refService)
+    if(!refService || !service->hierachicalRefs || !service->nonHierachicalRefs)
     {
+        NodeIdMap_delete(service->hierachicalRefs);
+        NodeIdMap_delete(service->nonHierachicalRefs);
         free(service);
+        free(refService);
         return NULL;
     }
     refService->context = service;
@@ -219,7 +136,8 @@ void InternalRefService_delete(NL_ReferenceService *refService)
 {
     InternalRefService *internalService =
         (InternalRefService *)refService->context;
-    NodeContainer_delete(internalService->nonHierachicalRefs);
+    NodeIdMap_delete(internalService->hierachicalRefs);
+    NodeIdMap_delete(internalService->nonHierachicalRefs);
     free(internalService);
     free(refService);
 }
@@ -0,0 +1,139 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "MappedFile.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#define NL_HAVE_MMAP 0
+#else
+#define NL_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+struct MappedFile
+{
+    const char *data;
+    size_t size;
+    bool mapped;
+};
+
+bool MappedFile_isRegularFile(const char *path)
+{
+    struct stat st;
+    if (!path || stat(path, &st) != 0)
+    {
+        return false;
+    }
+    return S_ISREG(st.st_mode);
+}
+
+static bool readWholeFile(MappedFile *file, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        return false;
+    }
+    bool ok = false;
+    if (fseek(f, 0, SEEK_END) == 0)
+    {
+        long size = ftell(f);
+        if (size > 0 && fseek(f, 0, SEEK_SET) == 0)
+        {
+            char *mem = (char *)malloc((size_t)size);
+            if (mem && fread(mem, 1, (size_t)size, f) == (size_t)size)
+            {
+                file->data = mem;
+                file->size = (size_t)size;
+                ok = true;
+            }
+            else
+            {
+                free(mem);
+            }
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
+#if NL_HAVE_MMAP
+static bool mapWholeFile(MappedFile *file, const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+    void *mem = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+    if (mem == MAP_FAILED)
+    {
+        return false;
+    }
+#ifdef POSIX_MADV_SEQUENTIAL
+    posix_madvise(mem, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+#endif
+    file->data = (const char *)mem;
+    file->size = (size_t)st.st_size;
+    file->mapped = true;
+    return true;
+}
+#endif
+
+MappedFile *MappedFile_open(const char *path)
+{
+    MappedFile *file = (MappedFile *)calloc(1, sizeof(MappedFile));
+    if (!file)
+    {
+        return NULL;
+    }
+#if NL_HAVE_MMAP
+    if (mapWholeFile(file, path))
+    {
+        return file;
+    }
+#endif
+    if (readWholeFile(file, path))
+    {
+        return file;
+    }
+    free(file);
+    return NULL;
+}
+
+const char *MappedFile_data(const MappedFile *file) { return file->data; }
+
+size_t MappedFile_size(const MappedFile *file) { return file->size; }
+
+void MappedFile_close(MappedFile *file)
+{
+    if (!file)
+    {
+        return;
+    }
+#if NL_HAVE_MMAP
+    if (file->mapped)
+    {
+        munmap((void *)(uintptr_t)file->data, file->size);
+        free(file);
+        return;
+    }
+#endif
+    free((void *)(uintptr_t)file->data);
+    free(file);
+}
@@ -0,0 +1,23 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+#include <stdbool.h>
+#include <stddef.h>
+
+// read only view of a whole file, memory mapped if the platform supports it,
+// otherwise read into one buffer
+struct MappedFile;
+typedef struct MappedFile MappedFile;
+
+// returns true if path refers to a regular file which can be mapped, pipes
+// and character devices have to be read as a stream
+bool MappedFile_isRegularFile(const char *path);
+MappedFile *MappedFile_open(const char *path);
+const char *MappedFile_data(const MappedFile *file);
+size_t MappedFile_size(const MappedFile *file);
+void MappedFile_close(MappedFile *file);
+
+#endif
@@ -37,6 +37,10 @@ NamespaceList *NamespaceList_new(NL_addNamespaceCallback cb)
 
 void NamespaceList_delete(NamespaceList *list)
 {
+    if (!list)
+    {
+        return;
+    }
     free(list->data);
     free(list);
 }
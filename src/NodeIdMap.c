@@ -0,0 +1,149 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "NodeIdMap.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+// open addressing with linear probing, the capacity is a power of two and the
+// map grows before it is half full
+typedef struct
+{
+    uint32_t hash;
+    size_t position;
+    NL_Node *node;
+} Entry;
+
+struct NodeIdMap
+{
+    Entry *entries;
+    size_t capacity;
+    size_t size;
+};
+
+static size_t roundCapacity(size_t capacity)
+{
+    size_t c = 16;
+    while (c < capacity)
+    {
+        c <<= 1;
+    }
+    return c;
+}
+
+NodeIdMap *NodeIdMap_new(size_t initialCapacity)
+{
+    NodeIdMap *map = (NodeIdMap *)calloc(1, sizeof(NodeIdMap));
+    if (!map)
+    {
+        return NULL;
+    }
+    map->capacity = roundCapacity(initialCapacity);
+    map->entries = (Entry *)calloc(map->capacity, sizeof(Entry));
+    if (!map->entries)
+    {
+        free(map);
+        return NULL;
+    }
+    return map;
+}
+
+static Entry *findSlot(Entry *entries, size_t capacity, uint32_t hash,
+                       const UA_NodeId *id)
+{
+    size_t mask = capacity - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        Entry *e = &entries[i];
+        if (!e->node ||
+            (e->hash == hash && UA_NodeId_equal(&e->node->id, id)))
+        {
+            return e;
+        }
+    }
+}
+
+static bool grow(NodeIdMap *map)
+{
+    size_t capacity = map->capacity * 2;
+    Entry *entries = (Entry *)calloc(capacity, sizeof(Entry));
+    if (!entries)
+    {
+        return false;
+    }
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < map->capacity; i++)
+    {
+        const Entry *e = &map->entries[i];
+        if (!e->node)
+        {
+            continue;
+        }
+        // all ids are distinct, the first free slot is the right one
+        size_t pos = e->hash & mask;
+        while (entries[pos].node)
+        {
+            pos = (pos + 1) & mask;
+        }
+        entries[pos] = *e;
+    }
+    free(map->entries);
+    map->entries = entries;
+    map->capacity = capacity;
+    return true;
+}
+
+NodeIdMap_InsertResult NodeIdMap_insert(NodeIdMap *map, NL_Node *node)
+{
+    uint32_t hash = UA_NodeId_hash(&node->id);
+    Entry *e = findSlot(map->entries, map->capacity, hash, &node->id);
+    if (e->node)
+    {
+        return NODEIDMAP_DUPLICATE;
+    }
+    if ((map->size + 1) * 2 > map->capacity)
+    {
+        if (!grow(map))
+        {
+            return NODEIDMAP_OUT_OF_MEMORY;
+        }
+        e = findSlot(map->entries, map->capacity, hash, &node->id);
+    }
+    e->hash = hash;
+    e->position = map->size;
+    e->node = node;
+    map->size++;
+    return NODEIDMAP_INSERTED;
+}
+
+NL_Node *NodeIdMap_get(const NodeIdMap *map, const UA_NodeId *id)
+{
+    uint32_t hash = UA_NodeId_hash(id);
+    return findSlot(map->entries, map->capacity, hash, id)->node;
+}
+
+bool NodeIdMap_getPosition(const NodeIdMap *map, const UA_NodeId *id,
+                           size_t *position)
+{
+    uint32_t hash = UA_NodeId_hash(id);
+    const Entry *e = findSlot(map->entries, map->capacity, hash, id);
+    if (!e->node)
+    {
+        return false;
+    }
+    *position = e->position;
+    return true;
+}
+
+size_t NodeIdMap_size(const NodeIdMap *map) { return map->size; }
+
+void NodeIdMap_delete(NodeIdMap *map)
+{
+    if (!map)
+    {
+        return;
+    }
+    free(map->entries);
+    free(map);
+}
@@ -0,0 +1,34 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NODEIDMAP_H
+#define NODEIDMAP_H
+#include "NodesetLoader/NodesetLoader.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// hash index of nodes by their id, the map doesn't own the nodes, the id of
+// a node must not change while it's part of the map
+struct NodeIdMap;
+typedef struct NodeIdMap NodeIdMap;
+
+typedef enum
+{
+    NODEIDMAP_INSERTED,
+    // a node with the same id is already in the map, it is kept
+    NODEIDMAP_DUPLICATE,
+    // the map couldn't grow, it is unchanged
+    NODEIDMAP_OUT_OF_MEMORY
+} NodeIdMap_InsertResult;
+
+NodeIdMap *NodeIdMap_new(size_t initialCapacity);
+NodeIdMap_InsertResult NodeIdMap_insert(NodeIdMap *map, NL_Node *node);
+NL_Node *NodeIdMap_get(const NodeIdMap *map, const UA_NodeId *id);
+// position of the node in the order of insertion, false if the id is unknown
+bool NodeIdMap_getPosition(const NodeIdMap *map, const UA_NodeId *id,
+                           size_t *position);
+size_t NodeIdMap_size(const NodeIdMap *map);
+void NodeIdMap_delete(NodeIdMap *map);
+
+#endif
@@ -7,8 +7,13 @@
 
 #include "Nodeset.h"
 #include "AliasList.h"
+#include "Arena.h"
 #include "NamespaceList.h"
+#include "NodeIdMap.h"
+#include "NumberParser.h"
+#include "ObjectPool.h"
 #include "Sort.h"
+#include "Value.h"
 #include "nodes/DataTypeNode.h"
 #include "nodes/Node.h"
 #include "nodes/NodeContainer.h"
@@ -23,6 +28,9 @@ static NL_BrowseName translateBrowseName(const NamespaceList *namespaces,
                                          NL_BrowseName id);
 NL_BrowseName extractBrowseName(const NamespaceList *namespaces, char *s);
 
+static const UA_UInt32 NL_REFERENCES_ID = 31;
+static const UA_UInt32 NL_HASSUBTYPE_ID = 45;
+
 // UANode
 #define ATTRIBUTE_NODEID "NodeId"
 #define ATTRIBUTE_BROWSENAME "BrowseName"
@@ -162,6 +170,8 @@ Nodeset *Nodeset_new(NL_addNamespaceCallback nsCallback,
     {
         return NULL;
     }
+    nodeset->refService = refService;
+    nodeset->logger = logger;
     nodeset->aliasList = AliasList_new();
     nodeset->namespaces = NamespaceList_new(nsCallback);
     nodeset->charArena = CharArenaAllocator_new(1024 * 1024);
@@ -173,17 +183,80 @@ Nodeset *Nodeset_new(NL_addNamespaceCallback nsCallback,
     nodeset->nodes[NODECLASS_REFERENCETYPE] = NodeContainer_new(100, true);
     nodeset->nodes[NODECLASS_VARIABLETYPE] = NodeContainer_new(100, true);
     nodeset->nodes[NODECLASS_VIEW] = NodeContainer_new(10, true);
+    bool ok = nodeset->aliasList && nodeset->namespaces && nodeset->charArena;
+    for (size_t cnt = 0; cnt < NL_NODECLASS_COUNT && ok; cnt++)
+    {
+        ok = nodeset->nodes[cnt] != NULL;
+        if (ok)
+        {
+            // one slab holds as many nodes as the container grows at once
+            nodeset->nodePools[cnt] =
+                ObjectPool_new(Node_size((NL_NodeClass)cnt),
+                               nodeset->nodes[cnt]->incrementSize);
+            ok = nodeset->nodePools[cnt] != NULL;
+        }
+    }
+    nodeset->refPool = ObjectPool_new(sizeof(NL_Reference), 10000);
+    nodeset->valueArena = Arena_new(64 * 1024);
+    if (nodeset->valueArena)
+    {
+        nodeset->lazyValueCtx = (NL_ParserCtx *)Arena_alloc(
+            nodeset->valueArena, sizeof(NL_ParserCtx));
+    }
+    if (nodeset->lazyValueCtx)
+    {
+        nodeset->lazyValueCtx->arena = nodeset->valueArena;
+    }
+    nodeset->nodeIds = NodeIdMap_new(1024);
+    nodeset->docOrder = NodeContainer_new(10000, false);
+    nodeset->levelNodes = NodeContainer_new(10000, false);
     nodeset->nodesWithUnknownRefs = NodeContainer_new(100, false);
-    nodeset->refTypesWithUnknownRefs = NodeContainer_new(100, false);
-    nodeset->refService = refService;
+    nodeset->pendingRefTypes = NodeContainer_new(100, false);
     nodeset->sortCtx = Sort_init();
-    nodeset->logger = logger;
+    if (!ok || !nodeset->refPool || !nodeset->lazyValueCtx ||
+        !nodeset->nodeIds || !nodeset->docOrder || !nodeset->levelNodes ||
+        !nodeset->nodesWithUnknownRefs || !nodeset->pendingRefTypes ||
+        !nodeset->sortCtx)
+    {
+        // the cleanup copes with the members which weren't allocated
+        Nodeset_cleanup(nodeset);
+        return NULL;
+    }
     return nodeset;
 }
 
-static void Nodeset_addNode(Nodeset *nodeset, NL_Node *node)
+// false if memory ran out, the node wouldn't be imported then
+static bool Nodeset_addNode(Nodeset *nodeset, NL_Node *node, size_t level)
 {
-    NodeContainer_add(nodeset->nodes[node->nodeClass], node);
+    if (!NodeContainer_add(nodeset->nodes[node->nodeClass], node))
+    {
+        return false;
+    }
+    // levels which only contain nodes of other nodesets are skipped
+    if (nodeset->levelCnt == 0 || level != nodeset->lastSortLevel)
+    {
+        if (nodeset->levelCnt == nodeset->levelCapacity)
+        {
+            size_t capacity =
+                nodeset->levelCapacity ? nodeset->levelCapacity * 2 : 64;
+            size_t *levelEnds = (size_t *)realloc(nodeset->levelEnds,
+                                                  capacity * sizeof(size_t));
+            if (!levelEnds)
+            {
+                return false;
+            }
+            nodeset->levelEnds = levelEnds;
+            nodeset->levelCapacity = capacity;
+        }
+        nodeset->levelCnt++;
+        nodeset->lastSortLevel = level;
+    }
+    if (!NodeContainer_add(nodeset->levelNodes, node))
+    {
+        return false;
+    }
+    nodeset->levelEnds[nodeset->levelCnt - 1] = nodeset->levelNodes->size;
+    return true;
 }
 
 static void insertElementAtFront(NL_Reference **toList, NL_Reference *elem)
@@ -192,20 +265,67 @@ static void insertElementAtFront(NL_Reference **toList, NL_Reference *elem)
     *toList = elem;
 }
 
+#define REFTYPE_HASTYPEDEF 0x01
+#define REFTYPE_HIERACHICAL 0x02
+#define REFTYPE_NONHIERACHICAL 0x04
+
+// Classifies the type of a reference, the reference service is only asked
+// for reference types which weren't classified before. Nodesets use only a
+// few reference types for all of their references.
+static uint8_t classifyReference(Nodeset *nodeset, const NL_Reference *ref)
+{
+    struct RefTypeClass *entry = NULL;
+    if (ref->refType.identifierType == UA_NODEIDTYPE_NUMERIC)
+    {
+        // the ids of the reference types of a namespace are mostly
+        // consecutive and end up in different slots
+        UA_UInt32 slot = ref->refType.identifier.numeric +
+                         7u * ref->refType.namespaceIndex;
+        entry = &nodeset->refTypeCache[slot % NODESET_REFTYPE_CACHE_SIZE];
+        if (entry->used && entry->id == ref->refType.identifier.numeric &&
+            entry->namespaceIndex == ref->refType.namespaceIndex)
+        {
+            return entry->flags;
+        }
+    }
+    NL_ReferenceService *service = nodeset->refService;
+    uint8_t flags = 0;
+    if (service->isHasTypeDefRef(service->context, ref))
+    {
+        flags |= REFTYPE_HASTYPEDEF;
+    }
+    if (service->isHierachicalRef(service->context, ref))
+    {
+        flags |= REFTYPE_HIERACHICAL;
+    }
+    else if (service->isNonHierachicalRef(service->context, ref))
+    {
+        flags |= REFTYPE_NONHIERACHICAL;
+    }
+    // a colliding reference type is replaced
+    if (entry)
+    {
+        entry->id = ref->refType.identifier.numeric;
+        entry->namespaceIndex = ref->refType.namespaceIndex;
+        entry->flags = flags;
+        entry->used = true;
+    }
+    return flags;
+}
+
 static bool lookupUnknownReferences(Nodeset *nodeset, NL_Node *node)
 {
     while (node->unknownRefs)
     {
         NL_Reference *nextUnknown = node->unknownRefs->next;
-        if (nodeset->refService->isHierachicalRef(nodeset->refService->context,
-                                                  node->unknownRefs))
+        uint8_t flags = classifyReference(nodeset, node->unknownRefs);
+        if (flags & REFTYPE_HIERACHICAL)
         {
             insertElementAtFront(&node->hierachicalRefs, node->unknownRefs);
             node->unknownRefs = nextUnknown;
             continue;
         }
-        if (nodeset->refService->isNonHierachicalRef(
-                nodeset->refService->context, node->unknownRefs))
+        if (flags & REFTYPE_NONHIERACHICAL)
         {
             insertElementAtFront(&node->nonHierachicalRefs, node->unknownRefs);
             node->unknownRefs = nextUnknown;
@@ -216,31 +336,315 @@ static bool lookupUnknownReferences(Nodeset *nodeset, NL_Node *node)
     return true;
 }
 
-static void lookupReferenceTypes(Nodeset *nodeset)
+static void addReferenceType(Nodeset *nodeset, NL_Node *node)
+{
+    nodeset->refService->addNewReferenceType(nodeset->refService->context,
+                                             (NL_ReferenceTypeNode *)node);
+    // the new type may change the classification of its subtypes
+    memset(nodeset->refTypeCache, 0, sizeof(nodeset->refTypeCache));
+}
+
+// the target of the HasSubtype reference of a reference type, NULL for the
+// root of the type hierarchy
+static const UA_NodeId *getSuperType(const NL_Node *refType)
 {
-    bool allRefTypesKnown = false;
-    while (!allRefTypesKnown)
+    for (const NL_Reference *ref = refType->hierachicalRefs; ref;
+         ref = ref->next)
     {
-        allRefTypesKnown = true;
-        for (size_t i = 0; i < nodeset->refTypesWithUnknownRefs->size; i++)
+        if (!ref->isForward && ref->refType.namespaceIndex == 0 &&
+            ref->refType.identifierType == UA_NODEIDTYPE_NUMERIC &&
+            ref->refType.identifier.numeric == NL_HASSUBTYPE_ID)
         {
-            allRefTypesKnown = lookupUnknownReferences(
-                nodeset, nodeset->refTypesWithUnknownRefs->nodes[i]);
+            return &ref->target;
         }
     }
+    return NULL;
+}
 
-    for (size_t i = 0; i < nodeset->refTypesWithUnknownRefs->size; i++)
+static bool isKnownReferenceType(Nodeset *nodeset, const UA_NodeId *id)
+{
+    // the root of the type hierarchy is neither hierachical nor
+    // non hierachical
+    if (id->namespaceIndex == 0 &&
+        id->identifierType == UA_NODEIDTYPE_NUMERIC &&
+        id->identifier.numeric == NL_REFERENCES_ID)
     {
-        Sort_addNode(nodeset->sortCtx,
-                     nodeset->refTypesWithUnknownRefs->nodes[i]);
+        return true;
     }
+    NL_Reference ref;
+    memset(&ref, 0, sizeof(NL_Reference));
+    ref.refType = *id;
+    return (classifyReference(nodeset, &ref) &
+            (REFTYPE_HIERACHICAL | REFTYPE_NONHIERACHICAL)) != 0;
+}
+
+static void logOutOfMemory(const Nodeset *nodeset)
+{
+    nodeset->logger->log(nodeset->logger->context,
+                         NODESETLOADER_LOGLEVEL_ERROR,
+                         "NodesetLoader: out of memory while sorting nodes");
 }
 
-bool Nodeset_sort(Nodeset *nodeset)
+static void logUnresolvedReferenceType(const Nodeset *nodeset,
+                                       const NL_Node *refType)
+{
+    UA_String nodeIdStr = {0};
+    UA_String superTypeStr = {0};
+    UA_NodeId_print(&refType->id, &nodeIdStr);
+    UA_NodeId_print(getSuperType(refType), &superTypeStr);
+    nodeset->logger->log(
+        nodeset->logger->context, NODESETLOADER_LOGLEVEL_ERROR,
+        "reference type with unresolved supertype: NodeId(%.*s), "
+        "supertype NodeId(%.*s)",
+        (int)nodeIdStr.length, (char *)nodeIdStr.data,
+        (int)superTypeStr.length, (char *)superTypeStr.data);
+    UA_String_clear(&nodeIdStr);
+    UA_String_clear(&superTypeStr);
+}
+
+enum
+{
+    REFTYPE_PENDING,
+    REFTYPE_VISITING,
+    REFTYPE_RESOLVED,
+    REFTYPE_FAILED
+};
+
+// Adds the reference types whose supertype was unknown while parsing to the
+// reference service. The HasSubtype chain of each type is followed once up to
+// a known type, the supertypes are added before their subtypes. Types whose
+// chain ends in an unknown type or in a cycle can't be resolved.
+static bool resolvePendingReferenceTypes(Nodeset *nodeset)
+{
+    NodeContainer *pending = nodeset->pendingRefTypes;
+    if (!pending->size)
+    {
+        return true;
+    }
+    NodeIdMap *index = NodeIdMap_new(pending->size);
+    uint8_t *state = (uint8_t *)calloc(pending->size, sizeof(uint8_t));
+    size_t *chain = (size_t *)calloc(pending->size, sizeof(size_t));
+    bool ok = index && state && chain;
+    for (size_t i = 0; ok && i < pending->size; i++)
+    {
+        ok = NodeIdMap_insert(index, pending->nodes[i]) == NODEIDMAP_INSERTED;
+    }
+    for (size_t i = 0; ok && i < pending->size; i++)
+    {
+        size_t len = 0;
+        size_t current = i;
+        uint8_t result = REFTYPE_FAILED;
+        while (true)
+        {
+            if (state[current] != REFTYPE_PENDING)
+            {
+                // the chain joins a chain which was resolved before or it is
+                // a cycle
+                result = state[current] == REFTYPE_RESOLVED ? REFTYPE_RESOLVED
+                                                            : REFTYPE_FAILED;
+                break;
+            }
+            state[current] = REFTYPE_VISITING;
+            chain[len++] = current;
+            const UA_NodeId *superType = getSuperType(pending->nodes[current]);
+            if (!NodeIdMap_getPosition(index, superType, &current))
+            {
+                result = isKnownReferenceType(nodeset, superType)
+                             ? REFTYPE_RESOLVED
+                             : REFTYPE_FAILED;
+                break;
+            }
+        }
+        for (size_t k = len; k-- > 0;)
+        {
+            state[chain[k]] = result;
+            if (result == REFTYPE_RESOLVED)
+            {
+                addReferenceType(nodeset, pending->nodes[chain[k]]);
+            }
+            else
+            {
+                logUnresolvedReferenceType(nodeset, pending->nodes[chain[k]]);
+            }
+        }
+    }
+    for (size_t i = 0; ok && i < pending->size; i++)
+    {
+        ok = state[i] == REFTYPE_RESOLVED;
+    }
+    pending->size = 0;
+    NodeIdMap_delete(index);
+    free(state);
+    free(chain);
+    return ok;
+}
+
+// Sort_TargetFilter, false for nodes of namespaces without imported nodes
+static bool isLoadedTarget(const void *context, const UA_NodeId *target)
+{
+    const Nodeset *nodeset = (const Nodeset *)context;
+    UA_UInt16 ns = target->namespaceIndex;
+    return (nodeset->loadedNamespaces[ns / 8] & (1u << (ns % 8))) != 0;
+}
+
+typedef enum
+{
+    DOCORDER_SORTED,
+    // the nodes have to be sorted by the sorting algorithm
+    DOCORDER_UNSORTED,
+    DOCORDER_FAILED
+} DocOrderResult;
+
+// Computes the dependency level of each node in a single pass over the nodes
+// if every node is preceded by the nodes it depends on, which is the case for
+// most exported nodesets. Returns DOCORDER_UNSORTED without modifying any node
+// if the order of the file is not a valid order.
+static DocOrderResult sortInDocumentOrder(Nodeset *nodeset,
+                                          bool pruneUnloadedNamespaces)
+{
+    const NodeContainer *nodes = nodeset->docOrder;
+    size_t *levels = (size_t *)calloc(nodes->size + 1, sizeof(size_t));
+    if (!levels)
+    {
+        return DOCORDER_UNSORTED;
+    }
+    size_t maxLevel = 0;
+    for (size_t i = 0; i < nodes->size; i++)
+    {
+        // the reference to the parent which is added to instance nodes
+        // without hierachical references is a dependency as well
+        const UA_NodeId *parentId = Sort_missingParentId(nodes->nodes[i]);
+        size_t parentPos = 0;
+        if (parentId &&
+            NodeIdMap_getPosition(nodeset->nodeIds, parentId, &parentPos) &&
+            parentPos != i)
+        {
+            if (parentPos > i)
+            {
+                free(levels);
+                return DOCORDER_UNSORTED;
+            }
+            if (levels[i] <= levels[parentPos])
+            {
+                levels[i] = levels[parentPos] + 1;
+            }
+        }
+        // the level of a node is final once its inverse references are
+        // applied, afterwards it is passed on to the targets of the forward
+        // references
+        for (int forward = 0; forward < 2; forward++)
+        {
+            const NL_Reference *ref = nodes->nodes[i]->hierachicalRefs;
+            for (; ref; ref = ref->next)
+            {
+                if (ref->isForward != (forward == 1))
+                {
+                    continue;
+                }
+                size_t pos = 0;
+                if (!NodeIdMap_getPosition(nodeset->nodeIds, &ref->target,
+                                           &pos))
+                {
+                    // a node of another nodeset which depends on this node,
+                    // unless its namespace is pruned
+                    if (ref->isForward &&
+                        (!pruneUnloadedNamespaces ||
+                         isLoadedTarget(nodeset, &ref->target)))
+                    {
+                        free(levels);
+                        return DOCORDER_UNSORTED;
+                    }
+                    continue;
+                }
+                if (pos == i)
+                {
+                    continue;
+                }
+                if (ref->isForward != (pos > i))
+                {
+                    free(levels);
+                    return DOCORDER_UNSORTED;
+                }
+                if (ref->isForward && levels[pos] <= levels[i])
+                {
+                    levels[pos] = levels[i] + 1;
+                }
+                else if (!ref->isForward && levels[i] <= levels[pos])
+                {
+                    levels[i] = levels[pos] + 1;
+                }
+            }
+        }
+        if (levels[i] > maxLevel)
+        {
+            maxLevel = levels[i];
+        }
+    }
+    // nodes are reported level by level, in the order of the file within a
+    // level
+    size_t *levelStart = (size_t *)calloc(maxLevel + 2, sizeof(size_t));
+    size_t *order = (size_t *)malloc((nodes->size + 1) * sizeof(size_t));
+    if (!levelStart || !order)
+    {
+        free(levels);
+        free(levelStart);
+        free(order);
+        return DOCORDER_UNSORTED;
+    }
+    for (size_t i = 0; i < nodes->size; i++)
+    {
+        levelStart[levels[i] + 1]++;
+    }
+    for (size_t l = 0; l < maxLevel; l++)
+    {
+        levelStart[l + 1] += levelStart[l];
+    }
+    for (size_t i = 0; i < nodes->size; i++)
+    {
+        order[levelStart[levels[i]]++] = i;
+    }
+    // the sorting algorithm adds the references to the parents of instance
+    // nodes, the parent is only known if it was added before
+    DocOrderResult result = DOCORDER_SORTED;
+    for (size_t i = 0; i < nodes->size && result == DOCORDER_SORTED; i++)
+    {
+        NL_Node *node = nodes->nodes[i];
+        const UA_NodeId *parentId = Sort_missingParentId(node);
+        if (!parentId)
+        {
+            continue;
+        }
+        size_t pos = 0;
+        bool parentKnown =
+            NodeIdMap_getPosition(nodeset->nodeIds, parentId, &pos) && pos < i;
+        if (!Sort_addParentReference(nodeset->refPool, node,
+                                     parentKnown ? nodes->nodes[pos] : NULL))
+        {
+            result = DOCORDER_FAILED;
+        }
+    }
+    for (size_t i = 0; i < nodes->size && result == DOCORDER_SORTED; i++)
+    {
+        if (!Nodeset_addNode(nodeset, nodes->nodes[order[i]],
+                             levels[order[i]]))
+        {
+            result = DOCORDER_FAILED;
+        }
+    }
+    free(levels);
+    free(levelStart);
+    free(order);
+    return result;
+}
+
+bool Nodeset_sort(Nodeset *nodeset, bool pruneUnloadedNamespaces)
 {
     // first we have to figure out, if there are reference types, for which we
     // cannot state if they are hierachical or nonhierachical
-    lookupReferenceTypes(nodeset);
+    if (!resolvePendingReferenceTypes(nodeset))
+    {
+        return false;
+    }
     // all hierachical references of a node should be known at this point
     // if there are nodes with unknown references, the import will be aborted
     for (size_t i = 0; i < nodeset->nodesWithUnknownRefs->size; i++)
@@ -259,15 +663,146 @@ bool Nodeset_sort(Nodeset *nodeset)
             UA_String_clear(&nodeIdStr);
             return false;
         }
-        Sort_addNode(nodeset->sortCtx, nodeset->nodesWithUnknownRefs->nodes[i]);
     }
 
+    switch (sortInDocumentOrder(nodeset, pruneUnloadedNamespaces))
+    {
+    case DOCORDER_SORTED:
+        nodeset->logger->log(nodeset->logger->context,
+                             NODESETLOADER_LOGLEVEL_DEBUG,
+                             "nodes are in dependency order, sorting skipped");
+        return true;
+    case DOCORDER_FAILED:
+        logOutOfMemory(nodeset);
+        return false;
+    case DOCORDER_UNSORTED:
+        break;
+    }
+    if (pruneUnloadedNamespaces)
+    {
+        Sort_setTargetFilter(nodeset->sortCtx, isLoadedTarget, nodeset);
+    }
+    for (size_t i = 0; i < nodeset->docOrder->size; i++)
+    {
+        if (!Sort_addNode(nodeset->sortCtx, nodeset->docOrder->nodes[i]))
+        {
+            logOutOfMemory(nodeset);
+            return false;
+        }
+    }
     return Sort_start(nodeset->sortCtx, nodeset, Nodeset_addNode,
                       nodeset->logger);
 }
 
+static size_t countRefs(const NL_Reference *ref)
+{
+    size_t cnt = 0;
+    for (; ref; ref = ref->next)
+    {
+        cnt++;
+    }
+    return cnt;
+}
+
+// copies a reference list to refs + *pos, the copies are linked in the same
+// order, returns the new head of the list
+static NL_Reference *moveRefs(NL_Reference *ref, NL_Reference *refs,
+                              size_t *pos)
+{
+    NL_Reference *head = ref ? &refs[*pos] : NULL;
+    for (; ref; ref = ref->next)
+    {
+        NL_Reference *copy = &refs[(*pos)++];
+        *copy = *ref;
+        copy->next = ref->next ? copy + 1 : NULL;
+    }
+    return head;
+}
+
+static NL_Reference **getRefToTypeDef(NL_Node *node)
+{
+    switch (node->nodeClass)
+    {
+    case NODECLASS_OBJECT:
+        return &((NL_ObjectNode *)node)->refToTypeDef;
+    case NODECLASS_VARIABLE:
+        return &((NL_VariableNode *)node)->refToTypeDef;
+    case NODECLASS_OBJECTTYPE:
+    case NODECLASS_DATATYPE:
+    case NODECLASS_METHOD:
+    case NODECLASS_REFERENCETYPE:
+    case NODECLASS_VARIABLETYPE:
+    case NODECLASS_VIEW:
+        break;
+    }
+    return NULL;
+}
+
+NL_Node *Nodeset_getNode(const Nodeset *nodeset, const UA_NodeId *id)
+{
+    return NodeIdMap_get(nodeset->nodeIds, id);
+}
+
+bool Nodeset_compactReferences(Nodeset *nodeset)
+{
+    size_t total = 0;
+    for (size_t cnt = 0; cnt < NL_NODECLASS_COUNT; cnt++)
+    {
+        const NodeContainer *c = nodeset->nodes[cnt];
+        for (size_t i = 0; i < c->size; i++)
+        {
+            const NL_Node *node = c->nodes[i];
+            total += countRefs(node->hierachicalRefs) +
+                     countRefs(node->nonHierachicalRefs) +
+                     countRefs(node->unknownRefs);
+            NL_Reference **typeDef = getRefToTypeDef(c->nodes[i]);
+            total += typeDef && *typeDef ? 1 : 0;
+        }
+    }
+    NL_Reference *refs =
+        (NL_Reference *)calloc(total > 0 ? total : 1, sizeof(NL_Reference));
+    if (!refs)
+    {
+        return false;
+    }
+    size_t pos = 0;
+    for (size_t cnt = 0; cnt < NL_NODECLASS_COUNT; cnt++)
+    {
+        const NodeContainer *c = nodeset->nodes[cnt];
+        for (size_t i = 0; i < c->size; i++)
+        {
+            NL_Node *node = c->nodes[i];
+            size_t begin = pos;
+            node->hierachicalRefs = moveRefs(node->hierachicalRefs, refs, &pos);
+            node->compactRefs.hierachicalSize = pos - begin;
+            node->nonHierachicalRefs =
+                moveRefs(node->nonHierachicalRefs, refs, &pos);
+            node->compactRefs.nonHierachicalSize =
+                pos - begin - node->compactRefs.hierachicalSize;
+            node->compactRefs.refs = pos > begin ? &refs[begin] : NULL;
+            node->unknownRefs = moveRefs(node->unknownRefs, refs, &pos);
+            NL_Reference **typeDef = getRefToTypeDef(node);
+            if (typeDef && *typeDef)
+            {
+                refs[pos] = **typeDef;
+                refs[pos].next = NULL;
+                *typeDef = &refs[pos++];
+            }
+        }
+    }
+    // the pool is kept until the cleanup, the ids of sort placeholders and
+    // references which are not attached to a node still point into it
+    free(nodeset->compactRefs);
+    nodeset->compactRefs = refs;
+    return true;
+}
+
 void Nodeset_cleanup(Nodeset *nodeset)
 {
+    if (!nodeset)
+    {
+        return;
+    }
     CharArenaAllocator_delete(nodeset->charArena);
     AliasList_delete(nodeset->aliasList);
     for (size_t cnt = 0; cnt < NL_NODECLASS_COUNT; cnt++)
@@ -275,9 +810,20 @@ void Nodeset_cleanup(Nodeset *nodeset)
         NodeContainer_delete(nodeset->nodes[cnt]);
     }
     NodeContainer_delete(nodeset->nodesWithUnknownRefs);
-    NodeContainer_delete(nodeset->refTypesWithUnknownRefs);
+    NodeContainer_delete(nodeset->pendingRefTypes);
     NamespaceList_delete(nodeset->namespaces);
     Sort_cleanup(nodeset->sortCtx);
+    for (size_t cnt = 0; cnt < NL_NODECLASS_COUNT; cnt++)
+    {
+        ObjectPool_delete(nodeset->nodePools[cnt]);
+    }
+    ObjectPool_delete(nodeset->refPool);
+    Arena_delete(nodeset->valueArena);
+    free(nodeset->compactRefs);
+    NodeIdMap_delete(nodeset->nodeIds);
+    NodeContainer_delete(nodeset->docOrder);
+    NodeContainer_delete(nodeset->levelNodes);
+    free(nodeset->levelEnds);
     NL_BiDirectionalReference *ref = nodeset->hasEncodingRefs;
     while (ref)
     {
@@ -291,6 +837,15 @@ void Nodeset_cleanup(Nodeset *nodeset)
     free(nodeset);
 }
 
+static char *copyAttributeValue(Nodeset *nodeset, const char *value_start,
+                                const char *value_end)
+{
+    size_t size = (size_t)(value_end - value_start);
+    char *value = CharArenaAllocator_malloc(nodeset->charArena, size + 1);
+    memcpy(value, value_start, size);
+    return value;
+}
+
 static char *getAttributeValue(Nodeset *nodeset, const NodeAttribute *attr,
                                const char **attributes, int nb_attributes)
 {
@@ -300,105 +855,316 @@ static char *getAttributeValue(Nodeset *nodeset, const NodeAttribute *attr,
         const char *localname = attributes[i * fields + 0];
         if (strcmp((const char *)localname, attr->name))
             continue;
-        const char *value_start = attributes[i * fields + 3];
-        const char *value_end = attributes[i * fields + 4];
-        size_t size = (size_t)(value_end - value_start);
-        char *value = CharArenaAllocator_malloc(nodeset->charArena, size + 1);
-        memcpy(value, value_start, size);
-        return value;
+        return copyAttributeValue(nodeset, attributes[i * fields + 3],
+                                  attributes[i * fields + 4]);
     }
     // we return the defaultValue, if NULL or not, following code has to cope
     // with it
     return attr->defaultValue;
 }
 
+// slots of the attributes which are stored for the node elements
+typedef enum
+{
+    SLOT_NODEID,
+    SLOT_BROWSENAME,
+    SLOT_PARENTNODEID,
+    SLOT_DATATYPE,
+    SLOT_VALUERANK,
+    SLOT_ARRAYDIMENSIONS,
+    SLOT_HISTORIZING,
+    SLOT_MINIMUMSAMPLINGINTERVAL,
+    SLOT_EVENTNOTIFIER,
+    SLOT_ISABSTRACT,
+    SLOT_EXECUTABLE,
+    SLOT_USEREXECUTABLE,
+    SLOT_ACCESSLEVEL,
+    SLOT_USERACCESSLEVEL,
+    SLOT_SYMMETRIC,
+    SLOT_CONTAINSNOLOOPS,
+    SLOT_COUNT
+} AttributeSlot;
+
+#define SLOT(s) ((uint32_t)1 << (s))
+
+static const NodeAttribute *const slotAttributes[SLOT_COUNT] = {
+    &attrNodeId,
+    &attrBrowseName,
+    &attrParentNodeId,
+    &attrDataType,
+    &attrValueRank,
+    &attrArrayDimensions,
+    &attrHistorizing,
+    &attrMinimumSamplingInterval,
+    &attrEventNotifier,
+    &attrIsAbstract,
+    &attrExecutable,
+    &attrUserExecutable,
+    &attrAccessLevel,
+    &attrUserAccessLevel,
+    &attrSymmetric,
+    &attrContainsNoLoops};
+
+// slots which are decoded for the elements of a node class, indexed by
+// NL_NodeClass
+static const uint32_t nodeClassSlots[NL_NODECLASS_COUNT] = {
+    // NODECLASS_OBJECT
+    SLOT(SLOT_NODEID) | SLOT(SLOT_BROWSENAME) | SLOT(SLOT_PARENTNODEID) |
+        SLOT(SLOT_EVENTNOTIFIER),
+    // NODECLASS_OBJECTTYPE
+    SLOT(SLOT_NODEID) | SLOT(SLOT_BROWSENAME) | SLOT(SLOT_ISABSTRACT),
+    // NODECLASS_VARIABLE
+    SLOT(SLOT_NODEID) | SLOT(SLOT_BROWSENAME) | SLOT(SLOT_PARENTNODEID) |
+        SLOT(SLOT_DATATYPE) | SLOT(SLOT_VALUERANK) |
+        SLOT(SLOT_ARRAYDIMENSIONS) | SLOT(SLOT_HISTORIZING) |
+        SLOT(SLOT_MINIMUMSAMPLINGINTERVAL) | SLOT(SLOT_ACCESSLEVEL) |
+        SLOT(SLOT_USERACCESSLEVEL),
+    // NODECLASS_DATATYPE
+    SLOT(SLOT_NODEID) | SLOT(SLOT_BROWSENAME) | SLOT(SLOT_ISABSTRACT),
+    // NODECLASS_METHOD
+    SLOT(SLOT_NODEID) | SLOT(SLOT_BROWSENAME) | SLOT(SLOT_PARENTNODEID) |
+        SLOT(SLOT_EXECUTABLE) | SLOT(SLOT_USEREXECUTABLE),
+    // NODECLASS_REFERENCETYPE
+    SLOT(SLOT_NODEID) | SLOT(SLOT_BROWSENAME) | SLOT(SLOT_SYMMETRIC),
+    // NODECLASS_VARIABLETYPE
+    SLOT(SLOT_NODEID) | SLOT(SLOT_BROWSENAME) | SLOT(SLOT_DATATYPE) |
+        SLOT(SLOT_VALUERANK) | SLOT(SLOT_ARRAYDIMENSIONS) |
+        SLOT(SLOT_ISABSTRACT),
+    // NODECLASS_VIEW
+    SLOT(SLOT_NODEID) | SLOT(SLOT_BROWSENAME) | SLOT(SLOT_PARENTNODEID) |
+        SLOT(SLOT_CONTAINSNOLOOPS) | SLOT(SLOT_EVENTNOTIFIER)};
+
+static bool isSlot(const char *localname, AttributeSlot slot)
+{
+    return !strcmp(localname, slotAttributes[slot]->name);
+}
+
+// maps an attribute name to its slot, SLOT_COUNT if the attribute is not
+// stored
+static AttributeSlot getAttributeSlot(const char *localname)
+{
+    AttributeSlot slot = SLOT_COUNT;
+    switch (localname[0])
+    {
+    case 'N':
+        slot = SLOT_NODEID;
+        break;
+    case 'B':
+        slot = SLOT_BROWSENAME;
+        break;
+    case 'P':
+        slot = SLOT_PARENTNODEID;
+        break;
+    case 'D':
+        slot = SLOT_DATATYPE;
+        break;
+    case 'V':
+        slot = SLOT_VALUERANK;
+        break;
+    case 'A':
+        slot = localname[1] == 'r' ? SLOT_ARRAYDIMENSIONS : SLOT_ACCESSLEVEL;
+        break;
+    case 'H':
+        slot = SLOT_HISTORIZING;
+        break;
+    case 'M':
+        slot = SLOT_MINIMUMSAMPLINGINTERVAL;
+        break;
+    case 'E':
+        slot = localname[1] == 'v' ? SLOT_EVENTNOTIFIER : SLOT_EXECUTABLE;
+        break;
+    case 'I':
+        slot = SLOT_ISABSTRACT;
+        break;
+    case 'U':
+        slot = isSlot(localname, SLOT_USEREXECUTABLE) ? SLOT_USEREXECUTABLE
+                                                      : SLOT_USERACCESSLEVEL;
+        break;
+    case 'S':
+        slot = SLOT_SYMMETRIC;
+        break;
+    case 'C':
+        slot = SLOT_CONTAINSNOLOOPS;
+        break;
+    default:
+        return SLOT_COUNT;
+    }
+    return isSlot(localname, slot) ? slot : SLOT_COUNT;
+}
+
+// text of an attribute, points into the attributes passed by the parser or
+// to the default value
+typedef struct
+{
+    const char *start;
+    const char *end;
+} AttributeText;
+
+// walks the attributes of a node element once and fills the slots of the
+// node class, slots without an attribute get the default value
+static void decodeNodeAttributes(NL_NodeClass nodeClass, AttributeText *texts,
+                                 int nb_attributes, const char **attributes)
+{
+    const int fields = 5;
+    const uint32_t wanted = nodeClassSlots[nodeClass];
+    uint32_t found = 0;
+    for (int i = 0; i < nb_attributes && found != wanted; i++)
+    {
+        AttributeSlot slot = getAttributeSlot(attributes[i * fields + 0]);
+        if (slot == SLOT_COUNT || !(wanted & SLOT(slot)) ||
+            (found & SLOT(slot)))
+        {
+            continue;
+        }
+        texts[slot].start = attributes[i * fields + 3];
+        texts[slot].end = attributes[i * fields + 4];
+        found |= SLOT(slot);
+    }
+    uint32_t missing = wanted & ~found;
+    for (int slot = 0; missing; slot++, missing >>= 1)
+    {
+        if (missing & 1)
+        {
+            const char *defaultValue = slotAttributes[slot]->defaultValue;
+            texts[slot].start = defaultValue;
+            texts[slot].end =
+                defaultValue ? defaultValue + strlen(defaultValue) : NULL;
+        }
+    }
+}
+
+// only the attributes which stay strings are copied, default values are
+// shared by all nodes
+static char *slotString(Nodeset *nodeset, const AttributeText *texts,
+                        AttributeSlot slot)
+{
+    if (texts[slot].start == slotAttributes[slot]->defaultValue)
+    {
+        return slotAttributes[slot]->defaultValue;
+    }
+    return copyAttributeValue(nodeset, texts[slot].start, texts[slot].end);
+}
+
+// numeric attributes are converted from a terminated copy on the stack
+static void terminate(const AttributeText *text, char *buffer, size_t size)
+{
+    size_t len = (size_t)(text->end - text->start);
+    if (len >= size)
+    {
+        len = size - 1;
+    }
+    memcpy(buffer, text->start, len);
+    buffer[len] = '\0';
+}
+
+static int64_t slotInt(const AttributeText *texts, AttributeSlot slot)
+{
+    char buffer[32];
+    terminate(&texts[slot], buffer, sizeof(buffer));
+    return NumberParser_toInt64(buffer);
+}
+
+static double slotDouble(const AttributeText *texts, AttributeSlot slot)
+{
+    char buffer[64];
+    terminate(&texts[slot], buffer, sizeof(buffer));
+    return NumberParser_toDouble(buffer);
+}
+
+static uint8_t flagIfTrue(const AttributeText *texts, AttributeSlot slot,
+                          uint8_t flag)
+{
+    const AttributeText *text = &texts[slot];
+    return text->end - text->start == 4 && !memcmp(text->start, "true", 4)
+               ? flag
+               : 0;
+}
+
 static void extractAttributes(Nodeset *nodeset, const NamespaceList *namespaces,
                               NL_Node *node, int attributeSize,
                               const char **attributes)
 {
-    node->id = extractNodedId(
-        namespaces,
-        getAttributeValue(nodeset, &attrNodeId, attributes, attributeSize));
+    AttributeText texts[SLOT_COUNT];
+    decodeNodeAttributes(node->nodeClass, texts, attributeSize, attributes);
+    node->id =
+        extractNodedId(namespaces, slotString(nodeset, texts, SLOT_NODEID));
     node->browseName = extractBrowseName(
-        namespaces,
-        getAttributeValue(nodeset, &attrBrowseName, attributes, attributeSize));
+        namespaces, slotString(nodeset, texts, SLOT_BROWSENAME));
     switch (node->nodeClass)
     {
     case NODECLASS_OBJECTTYPE: {
-        ((NL_ObjectTypeNode *)node)->isAbstract = getAttributeValue(
-            nodeset, &attrIsAbstract, attributes, attributeSize);
+        NL_ObjectTypeNode *objectType = (NL_ObjectTypeNode *)node;
+        objectType->flags =
+            flagIfTrue(texts, SLOT_ISABSTRACT, NL_NODEFLAG_ISABSTRACT);
         break;
     }
     case NODECLASS_OBJECT: {
-        ((NL_ObjectNode *)node)->parentNodeId = extractNodedId(
-            namespaces, getAttributeValue(nodeset, &attrParentNodeId,
-                                          attributes, attributeSize));
-        ((NL_ObjectNode *)node)->eventNotifier = getAttributeValue(
-            nodeset, &attrEventNotifier, attributes, attributeSize);
+        NL_ObjectNode *object = (NL_ObjectNode *)node;
+        object->parentNodeId = extractNodedId(
+            namespaces, slotString(nodeset, texts, SLOT_PARENTNODEID));
+        object->eventNotifier = (uint8_t)slotInt(texts, SLOT_EVENTNOTIFIER);
         break;
     }
     case NODECLASS_VARIABLE: {
-
-        ((NL_VariableNode *)node)->parentNodeId = extractNodedId(
-            namespaces, getAttributeValue(nodeset, &attrParentNodeId,
-                                          attributes, attributeSize));
-        char *datatype = getAttributeValue(nodeset, &attrDataType, attributes,
-                                           attributeSize);
-        ((NL_VariableNode *)node)->datatype = alias2Id(nodeset, datatype);
-        ((NL_VariableNode *)node)->valueRank = getAttributeValue(
-            nodeset, &attrValueRank, attributes, attributeSize);
-        ((NL_VariableNode *)node)->minimumSamplingInterval = getAttributeValue(
-            nodeset, &attrMinimumSamplingInterval, attributes, attributeSize);
-        ((NL_VariableNode *)node)->arrayDimensions = getAttributeValue(
-            nodeset, &attrArrayDimensions, attributes, attributeSize);
-        ((NL_VariableNode *)node)->accessLevel = getAttributeValue(
-            nodeset, &attrAccessLevel, attributes, attributeSize);
-        ((NL_VariableNode *)node)->userAccessLevel = getAttributeValue(
-            nodeset, &attrUserAccessLevel, attributes, attributeSize);
-        ((NL_VariableNode *)node)->historizing = getAttributeValue(
-            nodeset, &attrHistorizing, attributes, attributeSize);
+        NL_VariableNode *variable = (NL_VariableNode *)node;
+        variable->parentNodeId = extractNodedId(
+            namespaces, slotString(nodeset, texts, SLOT_PARENTNODEID));
+        variable->datatype =
+            alias2Id(nodeset, slotString(nodeset, texts, SLOT_DATATYPE));
+        variable->arrayDimensions =
+            slotString(nodeset, texts, SLOT_ARRAYDIMENSIONS);
+        variable->valueRank = (int32_t)slotInt(texts, SLOT_VALUERANK);
+        variable->accessLevel = (uint8_t)slotInt(texts, SLOT_ACCESSLEVEL);
+        variable->userAccessLevel =
+            (uint8_t)slotInt(texts, SLOT_USERACCESSLEVEL);
+        variable->minimumSamplingInterval =
+            slotDouble(texts, SLOT_MINIMUMSAMPLINGINTERVAL);
+        variable->flags =
+            flagIfTrue(texts, SLOT_HISTORIZING, NL_NODEFLAG_HISTORIZING);
         break;
     }
     case NODECLASS_VARIABLETYPE: {
-
-        ((NL_VariableTypeNode *)node)->valueRank = getAttributeValue(
-            nodeset, &attrValueRank, attributes, attributeSize);
-        char *datatype = getAttributeValue(nodeset, &attrDataType, attributes,
-                                           attributeSize);
-        ((NL_VariableTypeNode *)node)->datatype = alias2Id(nodeset, datatype);
-        ((NL_VariableTypeNode *)node)->arrayDimensions = getAttributeValue(
-            nodeset, &attrArrayDimensions, attributes, attributeSize);
-        ((NL_VariableTypeNode *)node)->isAbstract = getAttributeValue(
-            nodeset, &attrIsAbstract, attributes, attributeSize);
+        NL_VariableTypeNode *variableType = (NL_VariableTypeNode *)node;
+        variableType->datatype =
+            alias2Id(nodeset, slotString(nodeset, texts, SLOT_DATATYPE));
+        variableType->arrayDimensions =
+            slotString(nodeset, texts, SLOT_ARRAYDIMENSIONS);
+        variableType->valueRank = (int32_t)slotInt(texts, SLOT_VALUERANK);
+        variableType->flags =
+            flagIfTrue(texts, SLOT_ISABSTRACT, NL_NODEFLAG_ISABSTRACT);
         break;
     }
-    case NODECLASS_DATATYPE:
-        ((NL_DataTypeNode *)node)->isAbstract = getAttributeValue(
-            nodeset, &attrIsAbstract, attributes, attributeSize);
+    case NODECLASS_DATATYPE: {
+        NL_DataTypeNode *dataType = (NL_DataTypeNode *)node;
+        dataType->flags =
+            flagIfTrue(texts, SLOT_ISABSTRACT, NL_NODEFLAG_ISABSTRACT);
         break;
-    case NODECLASS_METHOD:
-        ((NL_MethodNode *)node)->parentNodeId = extractNodedId(
-            namespaces, getAttributeValue(nodeset, &attrParentNodeId,
-                                          attributes, attributeSize));
-        ((NL_MethodNode *)node)->executable = getAttributeValue(
-            nodeset, &attrExecutable, attributes, attributeSize);
-        ((NL_MethodNode *)node)->userExecutable = getAttributeValue(
-            nodeset, &attrUserExecutable, attributes, attributeSize);
+    }
+    case NODECLASS_METHOD: {
+        NL_MethodNode *method = (NL_MethodNode *)node;
+        method->parentNodeId = extractNodedId(
+            namespaces, slotString(nodeset, texts, SLOT_PARENTNODEID));
+        method->flags = (uint8_t)(
+            flagIfTrue(texts, SLOT_EXECUTABLE, NL_NODEFLAG_EXECUTABLE) |
+            flagIfTrue(texts, SLOT_USEREXECUTABLE,
+                       NL_NODEFLAG_USEREXECUTABLE));
         break;
-    case NODECLASS_REFERENCETYPE:
-        ((NL_ReferenceTypeNode *)node)->symmetric = getAttributeValue(
-            nodeset, &attrSymmetric, attributes, attributeSize);
+    }
+    case NODECLASS_REFERENCETYPE: {
+        NL_ReferenceTypeNode *referenceType = (NL_ReferenceTypeNode *)node;
+        referenceType->flags =
+            flagIfTrue(texts, SLOT_SYMMETRIC, NL_NODEFLAG_SYMMETRIC);
         break;
-    case NODECLASS_VIEW:
-        ((NL_ViewNode *)node)->parentNodeId = extractNodedId(
-            namespaces, getAttributeValue(nodeset, &attrParentNodeId,
-                                          attributes, attributeSize));
-        ((NL_ViewNode *)node)->containsNoLoops = getAttributeValue(
-            nodeset, &attrContainsNoLoops, attributes, attributeSize);
-        ((NL_ViewNode *)node)->eventNotifier = getAttributeValue(
-            nodeset, &attrEventNotifier, attributes, attributeSize);
+    }
+    case NODECLASS_VIEW: {
+        NL_ViewNode *view = (NL_ViewNode *)node;
+        view->parentNodeId = extractNodedId(
+            namespaces, slotString(nodeset, texts, SLOT_PARENTNODEID));
+        view->eventNotifier = (uint8_t)slotInt(texts, SLOT_EVENTNOTIFIER);
+        view->flags = flagIfTrue(texts, SLOT_CONTAINSNOLOOPS,
+                                 NL_NODEFLAG_CONTAINSNOLOOPS);
         break;
-    default:;
+    }
     }
 }
 
@@ -413,7 +1179,11 @@ static void initNode(Nodeset *nodeset, const NamespaceList *namespaces,
 NL_Node *Nodeset_newNode(Nodeset *nodeset, NL_NodeClass nodeClass,
                          int nb_attributes, const char **attributes)
 {
-    NL_Node *node = Node_new(nodeClass);
+    NL_Node *node = (NL_Node *)ObjectPool_alloc(nodeset->nodePools[nodeClass]);
+    if (!node)
+    {
+        return NULL;
+    }
     initNode(nodeset, nodeset->namespaces, nodeClass, node, nb_attributes,
              attributes);
     return node;
@@ -422,7 +1192,11 @@ NL_Node *Nodeset_newNode(Nodeset *nodeset, NL_NodeClass nodeClass,
 NL_Reference *Nodeset_newReference(Nodeset *nodeset, NL_Node *node,
                                    int attributeSize, const char **attributes)
 {
-    NL_Reference *newRef = (NL_Reference *)calloc(1, sizeof(NL_Reference));
+    NL_Reference *newRef = Nodeset_allocReference(nodeset);
+    if (!newRef)
+    {
+        return NULL;
+    }
     if (!strcmp("true", getAttributeValue(nodeset, &attrIsForward, attributes,
                                           attributeSize)))
     {
@@ -437,31 +1211,26 @@ NL_Reference *Nodeset_newReference(Nodeset *nodeset, NL_Node *node,
 
     newRef->refType = alias2Id(nodeset, aliasIdString);
 
-    if (NODECLASS_VARIABLE == node->nodeClass &&
-        nodeset->refService->isHasTypeDefRef(nodeset->refService->context,
-                                             newRef))
+    uint8_t flags = classifyReference(nodeset, newRef);
+    if (NODECLASS_VARIABLE == node->nodeClass && (flags & REFTYPE_HASTYPEDEF))
     {
         ((NL_VariableNode *)node)->refToTypeDef = newRef;
         return newRef;
     }
 
-    if (NODECLASS_OBJECT == node->nodeClass &&
-        nodeset->refService->isHasTypeDefRef(nodeset->refService->context,
-                                             newRef))
+    if (NODECLASS_OBJECT == node->nodeClass && (flags & REFTYPE_HASTYPEDEF))
     {
         ((NL_ObjectNode *)node)->refToTypeDef = newRef;
         return newRef;
     }
 
-    if (nodeset->refService->isHierachicalRef(nodeset->refService->context,
-                                              newRef))
+    if (flags & REFTYPE_HIERACHICAL)
     {
         newRef->next = node->hierachicalRefs;
         node->hierachicalRefs = newRef;
         return newRef;
     }
-    if (nodeset->refService->isNonHierachicalRef(nodeset->refService->context,
-                                                 newRef))
+    if (flags & REFTYPE_NONHIERACHICAL)
     {
         newRef->next = node->nonHierachicalRefs;
         node->nonHierachicalRefs = newRef;
@@ -473,6 +1242,11 @@ NL_Reference *Nodeset_newReference(Nodeset *nodeset, NL_Node *node,
     return newRef;
 }
 
+NL_Reference *Nodeset_allocReference(Nodeset *nodeset)
+{
+    return (NL_Reference *)ObjectPool_alloc(nodeset->refPool);
+}
+
 Alias *Nodeset_newAlias(Nodeset *nodeset, int attributeSize,
                         const char **attributes)
 {
@@ -483,48 +1257,66 @@ Alias *Nodeset_newAlias(Nodeset *nodeset, int attributeSize,
 
 void Nodeset_newAliasFinish(Nodeset *nodeset, Alias *alias, char *idString)
 {
+    if (!alias)
+    {
+        return;
+    }
     alias->id = extractNodedId(nodeset->namespaces, idString);
 }
 
+void Nodeset_newFile(Nodeset *nodeset)
+{
+    // the aliases of a file are not visible in the files imported after it
+    AliasList_clear(nodeset->aliasList);
+}
+
 void Nodeset_newNamespaceFinish(Nodeset *nodeset, void *userContext,
                                 char *namespaceUri)
 {
     NamespaceList_newNamespace(nodeset->namespaces, userContext, namespaceUri);
 }
 
-void Nodeset_newNodeFinish(Nodeset *nodeset, NL_Node *node)
+bool Nodeset_newNodeFinish(Nodeset *nodeset, NL_Node *node)
 {
-    if (!node->unknownRefs)
+    // the index also rejects duplicates of nodes with unknown references
+    switch (NodeIdMap_insert(nodeset->nodeIds, node))
     {
-        if(!Sort_addNode(nodeset->sortCtx, node))
-        {
-            if (nodeset->logger)
-            {
-                nodeset->logger->log(nodeset->logger->context, NODESETLOADER_LOGLEVEL_ERROR,
-                            "node was not added to sorting algorithm, already exists");
-            }
-            Node_delete(node);
-        }
-        else
+    case NODEIDMAP_INSERTED:
+        break;
+    case NODEIDMAP_DUPLICATE:
+        if (nodeset->logger)
         {
-            if (node->nodeClass == NODECLASS_REFERENCETYPE)
-            {
-                nodeset->refService->addNewReferenceType(
-                    nodeset->refService->context, (NL_ReferenceTypeNode *)node);
-            }
+            nodeset->logger->log(nodeset->logger->context, NODESETLOADER_LOGLEVEL_ERROR,
+                        "node was not added to sorting algorithm, already exists");
         }
+        Node_clear(node);
+        return true;
+    case NODEIDMAP_OUT_OF_MEMORY:
+        Node_clear(node);
+        return false;
     }
-    else
+    // nodes are sorted as soon as the references of all nodes are known
+    NodeContainer_add(nodeset->docOrder, node);
+    UA_UInt16 ns = node->id.namespaceIndex;
+    nodeset->loadedNamespaces[ns / 8] |= (uint8_t)(1u << (ns % 8));
+    if (node->nodeClass == NODECLASS_REFERENCETYPE)
     {
-        if (node->nodeClass == NODECLASS_REFERENCETYPE)
+        const UA_NodeId *superType = getSuperType(node);
+        if (!superType || isKnownReferenceType(nodeset, superType))
         {
-            NodeContainer_add(nodeset->refTypesWithUnknownRefs, node);
+            addReferenceType(nodeset, node);
         }
         else
         {
-            NodeContainer_add(nodeset->nodesWithUnknownRefs, node);
+            // the supertype is defined later on
+            NodeContainer_add(nodeset->pendingRefTypes, node);
         }
     }
+    if (node->unknownRefs)
+    {
+        NodeContainer_add(nodeset->nodesWithUnknownRefs, node);
+    }
+    return true;
 }
 
 void Nodeset_newReferenceFinish(Nodeset *nodeset, NL_Reference *ref,
@@ -659,3 +1451,16 @@ size_t Nodeset_forEachNode(Nodeset *nodeset, NL_NodeClass nodeClass,
     }
     return c->size;
 }
+
+size_t Nodeset_forEachLevel(Nodeset *nodeset, void *context,
+                            NodesetLoader_forEachLevel_Func fn)
+{
+    size_t begin = 0;
+    for (size_t level = 0; level < nodeset->levelCnt; level++)
+    {
+        size_t end = nodeset->levelEnds[level];
+        fn(context, level, nodeset->levelNodes->nodes + begin, end - begin);
+        begin = end;
+    }
+    return nodeset->levelCnt;
+}
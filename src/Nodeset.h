@@ -13,6 +13,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 struct Nodeset;
 typedef struct Nodeset Nodeset;
@@ -25,9 +26,49 @@ struct NamespaceList;
 struct NodeContainer;
 struct AliasList;
 struct SortContext;
+struct ObjectPool;
+struct Arena;
+struct NodeIdMap;
+
+// number of reference types which are classified without asking the
+// reference service, a power of 2
+#define NODESET_REFTYPE_CACHE_SIZE 64
+
+// classification of a numeric reference type by the reference service
+struct RefTypeClass
+{
+    UA_UInt32 id;
+    UA_UInt16 namespaceIndex;
+    bool used;
+    uint8_t flags;
+};
+
 struct Nodeset
 {
     CharArenaAllocator *charArena;
+    // nodes and references are released in bulk with the nodeset
+    struct ObjectPool *nodePools[NL_NODECLASS_COUNT];
+    struct ObjectPool *refPool;
+    // values of variables with all of their data
+    struct Arena *valueArena;
+    // shared by the values which are decoded lazily
+    struct NL_ParserCtx *lazyValueCtx;
+    // references of all nodes after Nodeset_compactReferences
+    NL_Reference *compactRefs;
+    // all nodes by their id, filled while parsing
+    struct NodeIdMap *nodeIds;
+    // all nodes in the order of the nodeset file
+    struct NodeContainer *docOrder;
+    // one bit for each namespace index with at least one imported node
+    uint8_t loadedNamespaces[UINT16_MAX / 8 + 1];
+    // sorted nodes of all classes, grouped by their dependency level
+    struct NodeContainer *levelNodes;
+    // end of each level in levelNodes
+    size_t *levelEnds;
+    size_t levelCnt;
+    size_t levelCapacity;
+    // level of the sorting algorithm which was reported last
+    size_t lastSortLevel;
     struct AliasList *aliasList;
     struct NodeContainer *nodes[NL_NODECLASS_COUNT];
     struct NamespaceList *namespaces;
@@ -35,24 +76,33 @@ struct Nodeset
     NL_BiDirectionalReference *hasEncodingRefs;
     NodesetLoader_Logger* logger;
     struct NodeContainer *nodesWithUnknownRefs;
-    struct NodeContainer *refTypesWithUnknownRefs;
+    // reference types whose supertype wasn't known when they were parsed
+    struct NodeContainer *pendingRefTypes;
     NL_ReferenceService* refService;
+    // reference types which were already classified, cleared when a new
+    // reference type is added to the reference service
+    struct RefTypeClass refTypeCache[NODESET_REFTYPE_CACHE_SIZE];
 };
 
 Nodeset *Nodeset_new(NL_addNamespaceCallback nsCallback, NodesetLoader_Logger* logger, NL_ReferenceService* refService);
 void Nodeset_cleanup(Nodeset *nodeset);
-bool Nodeset_sort(Nodeset *nodeset);
+bool Nodeset_sort(Nodeset *nodeset, bool pruneUnloadedNamespaces);
 NL_Node *Nodeset_newNode(Nodeset *nodeset, NL_NodeClass nodeClass,
                        int attributeSize, const char **attributes);
-void Nodeset_newNodeFinish(Nodeset *nodeset, NL_Node *node);
+// false if memory ran out, duplicates are logged and dropped
+bool Nodeset_newNodeFinish(Nodeset *nodeset, NL_Node *node);
 NL_Reference *Nodeset_newReference(Nodeset *nodeset, NL_Node *node,
                                 int attributeSize, const char **attributes);
+NL_Reference *Nodeset_allocReference(Nodeset *nodeset);
+bool Nodeset_compactReferences(Nodeset *nodeset);
+NL_Node *Nodeset_getNode(const Nodeset *nodeset, const UA_NodeId *id);
 void Nodeset_newReferenceFinish(Nodeset *nodeset, NL_Reference *ref, NL_Node *node,
                                 char *targetId);
 struct Alias *Nodeset_newAlias(Nodeset *nodeset, int attributeSize,
                                const char **attribute);
 void Nodeset_newAliasFinish(Nodeset *nodeset, struct Alias *alias,
                             char *idString);
+void Nodeset_newFile(Nodeset *nodeset);
 void Nodeset_newNamespaceFinish(Nodeset *nodeset, void *userContext,
                                 char *namespaceUri);
 void Nodeset_addDataTypeDefinition(Nodeset *nodeset, NL_Node *node, int attributeSize,
@@ -72,4 +122,6 @@ const NL_BiDirectionalReference *
 Nodeset_getBiDirectionalRefs(const Nodeset *nodeset);
 size_t Nodeset_forEachNode(Nodeset *nodeset, NL_NodeClass nodeClass,
                            void *context, NodesetLoader_forEachNode_Func fn);
+size_t Nodeset_forEachLevel(Nodeset *nodeset, void *context,
+                            NodesetLoader_forEachLevel_Func fn);
 #endif
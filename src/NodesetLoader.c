@@ -5,35 +5,20 @@
  *    Copyright 2019 (c) Matthias Konnerth
  */
 
+#include "Arena.h"
+#include "CompressedInput.h"
+#include "ElementName.h"
 #include "InternalLogger.h"
 #include "InternalRefService.h"
+#include "MappedFile.h"
 #include "Nodeset.h"
 #include "Parser.h"
 #include "Value.h"
 #include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define OBJECT "UAObject"
-#define METHOD "UAMethod"
-#define OBJECTTYPE "UAObjectType"
-#define VARIABLE "UAVariable"
-#define VARIABLETYPE "UAVariableType"
-#define DATATYPE "UADataType"
-#define REFERENCETYPE "UAReferenceType"
-#define VIEW "UAView"
-#define DISPLAYNAME "DisplayName"
-#define REFERENCES "References"
-#define REFERENCE "Reference"
-#define DESCRIPTION "Description"
-#define ALIAS "Alias"
-#define NAMESPACEURIS "NamespaceUris"
-#define NAMESPACEURI "Uri"
-#define VALUE "Value"
-#define EXTENSIONS "Extensions"
-#define EXTENSION "Extension"
-#define INVERSENAME "InverseName"
-
 const char *NL_NODECLASS_NAME[NL_NODECLASS_COUNT] = {
     "Object", "ObjectType",    "Variable",    "DataType",
     "Method", "ReferenceType", "VariableType", "View"};
@@ -70,10 +55,22 @@ struct TParserCtx
     char *onCharacters;
     size_t onCharLength;
     NL_Value *val;
+    NL_ParserCtx valueCtx;
+    const NL_ValueInterface *valueIf;
+    // decoder of the current value if it is passed to the value interface
+    void *valueDecoder;
+    // values are kept as xml, set if the input is a buffer
+    bool lazyValues;
+    const char *input;
+    size_t inputSize;
+    Parser *parser;
+    long valueStart;
     void *extensionData;
     NodesetLoader_ExtensionInterface *extIf;
     NL_Reference *ref;
     Nodeset *nodeset;
+    // set if the import is aborted, e.g. because memory ran out
+    bool failed;
 };
 
 struct NodesetLoader
@@ -83,8 +80,144 @@ struct NodesetLoader
     bool internalLogger;
     NL_ReferenceService *refService;
     bool internalRefService;
+    bool pruneUnloadedNamespaces;
+    bool lazyValues;
+    const NL_ValueInterface *valueInterface;
 };
 
+// position of the content of the element which was just opened in the input,
+// the start callback is called at the end of the start tag. -1 if the
+// position is unknown or doesn't point to the end of a start tag.
+static long contentStart(const TParserCtx *pctx)
+{
+    if (!pctx->input)
+    {
+        return -1;
+    }
+    long pos = Parser_position(pctx->parser);
+    if (pos <= 0 || (size_t)pos >= pctx->inputSize)
+    {
+        return -1;
+    }
+    const char *c = pctx->input + pos;
+    if (*c == '>')
+    {
+        return pos + 1;
+    }
+    // an empty element, the content ends where it starts
+    if (*c == '/' && (size_t)pos + 1 < pctx->inputSize && c[1] == '>')
+    {
+        return pos + 2;
+    }
+    return -1;
+}
+
+static bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// position of the end tag of the value element which was just closed, the end
+// callback is called behind the end tag. -1 if the input in front of the
+// position is not an end tag of a value element.
+static long contentEnd(const TParserCtx *pctx)
+{
+    long pos = Parser_position(pctx->parser);
+    if (pos < pctx->valueStart || (size_t)pos > pctx->inputSize)
+    {
+        return -1;
+    }
+    // an empty element has no end tag
+    if (pos == pctx->valueStart)
+    {
+        return pos;
+    }
+    const char *c = pctx->input;
+    size_t start = (size_t)pctx->valueStart;
+    size_t end = (size_t)pos;
+    // </Value> or </prefix:Value>, blanks are allowed in front of the '>'
+    if (c[end - 1] != '>')
+    {
+        return -1;
+    }
+    end--;
+    while (end > start && isBlank(c[end - 1]))
+    {
+        end--;
+    }
+    const size_t nameLength = strlen("Value");
+    if (end - start < nameLength + 2 ||
+        memcmp(c + end - nameLength, "Value", nameLength))
+    {
+        return -1;
+    }
+    end -= nameLength;
+    if (c[end - 1] == ':')
+    {
+        end--;
+        while (end > start && c[end - 1] != '/' && c[end - 1] != '<' &&
+               !isBlank(c[end - 1]))
+        {
+            end--;
+        }
+    }
+    if (end - start < 2 || c[end - 1] != '/' || c[end - 2] != '<')
+    {
+        return -1;
+    }
+    return (long)end - 2;
+}
+
+// stops parsing, the import fails
+static void stopImport(TParserCtx *pctx, const char *reason)
+{
+    if (!pctx->failed)
+    {
+        pctx->nodeset->logger->log(pctx->nodeset->logger->context,
+                                   NODESETLOADER_LOGLEVEL_ERROR,
+                                   "NodesetLoader: %s, import aborted",
+                                   reason);
+    }
+    pctx->failed = true;
+    Parser_stop(pctx->parser);
+}
+
+static void abortImport(TParserCtx *pctx)
+{
+    stopImport(pctx, "out of memory");
+}
+
+// asks the value interface for a decoder of the value which starts
+static void *newValueDecoder(const TParserCtx *pctx)
+{
+    if (!pctx->valueIf || pctx->node->nodeClass != NODECLASS_VARIABLE)
+    {
+        return NULL;
+    }
+    return pctx->valueIf->newValue(pctx->valueIf->context,
+                                   (const NL_VariableNode *)pctx->node);
+}
+
+// keeps the content of the value element which was just closed
+static NL_Value *newLazyValue(TParserCtx *pctx)
+{
+    long end = contentEnd(pctx);
+    if (end < 0)
+    {
+        // the value was skipped, it can't be decoded anymore
+        stopImport(pctx, "end of a lazy value not found");
+        return NULL;
+    }
+    NL_Value *value = Value_newLazy(pctx->nodeset->lazyValueCtx,
+                                    pctx->input + pctx->valueStart,
+                                    (size_t)(end - pctx->valueStart));
+    if (!value)
+    {
+        abortImport(pctx);
+    }
+    return value;
+}
+
 static void enterUnknownState(TParserCtx *ctx)
 {
     ctx->prev_state = ctx->state;
@@ -92,6 +225,20 @@ static void enterUnknownState(TParserCtx *ctx)
     ctx->unknown_depth = 1;
 }
 
+static void startNode(TParserCtx *pctx, NL_NodeClass nodeClass,
+                      int nb_attributes, const char **attributes)
+{
+    pctx->nodeClass = nodeClass;
+    pctx->node = Nodeset_newNode(pctx->nodeset, pctx->nodeClass, nb_attributes,
+                                 attributes);
+    if (!pctx->node)
+    {
+        abortImport(pctx);
+        return;
+    }
+    pctx->state = PARSER_STATE_NODE;
+}
+
 static void OnStartElementNs(void *ctx, const char *localname,
                              const char *prefix, const char *URI,
                              int nb_namespaces, const char **namespaces,
@@ -99,90 +246,72 @@ static void OnStartElementNs(void *ctx, const char *localname,
                              const char **attributes)
 {
     TParserCtx *pctx = (TParserCtx *)ctx;
+    if (pctx->failed)
+    {
+        return;
+    }
     switch (pctx->state)
     {
     case PARSER_STATE_INIT:
-        if (!strcmp(localname, VARIABLE))
-        {
-            pctx->nodeClass = NODECLASS_VARIABLE;
-            pctx->node = Nodeset_newNode(pctx->nodeset, pctx->nodeClass,
-                                         nb_attributes, attributes);
-            pctx->state = PARSER_STATE_NODE;
-        }
-        else if (!strcmp(localname, OBJECT))
-        {
-            pctx->nodeClass = NODECLASS_OBJECT;
-            pctx->node = Nodeset_newNode(pctx->nodeset, pctx->nodeClass,
-                                         nb_attributes, attributes);
-            pctx->state = PARSER_STATE_NODE;
-        }
-        else if (!strcmp(localname, OBJECTTYPE))
-        {
-            pctx->nodeClass = NODECLASS_OBJECTTYPE;
-            pctx->node = Nodeset_newNode(pctx->nodeset, pctx->nodeClass,
-                                         nb_attributes, attributes);
-            pctx->state = PARSER_STATE_NODE;
-        }
-        else if (!strcmp(localname, DATATYPE))
-        {
-            pctx->nodeClass = NODECLASS_DATATYPE;
-            pctx->node = Nodeset_newNode(pctx->nodeset, pctx->nodeClass,
-                                         nb_attributes, attributes);
-            pctx->state = PARSER_STATE_NODE;
-        }
-        else if (!strcmp(localname, METHOD))
-        {
-            pctx->nodeClass = NODECLASS_METHOD;
-            pctx->node = Nodeset_newNode(pctx->nodeset, pctx->nodeClass,
-                                         nb_attributes, attributes);
-            pctx->state = PARSER_STATE_NODE;
-        }
-        else if (!strcmp(localname, REFERENCETYPE))
-        {
-            pctx->nodeClass = NODECLASS_REFERENCETYPE;
-            pctx->node = Nodeset_newNode(pctx->nodeset, pctx->nodeClass,
-                                         nb_attributes, attributes);
-            pctx->state = PARSER_STATE_NODE;
-        }
-        else if (!strcmp(localname, VARIABLETYPE))
-        {
-            pctx->nodeClass = NODECLASS_VARIABLETYPE;
-            pctx->node = Nodeset_newNode(pctx->nodeset, pctx->nodeClass,
-                                         nb_attributes, attributes);
-            pctx->state = PARSER_STATE_NODE;
-        }
-        else if (!strcmp(localname, VIEW))
-        {
-            pctx->nodeClass = NODECLASS_VIEW;
-            pctx->node = Nodeset_newNode(pctx->nodeset, pctx->nodeClass,
-                                         nb_attributes, attributes);
-            pctx->state = PARSER_STATE_NODE;
-        }
-        else if (!strcmp(localname, NAMESPACEURIS))
+        switch (ElementName_lookup(localname))
         {
+        case ELEMENT_UAVARIABLE:
+            startNode(pctx, NODECLASS_VARIABLE, nb_attributes, attributes);
+            break;
+        case ELEMENT_UAOBJECT:
+            startNode(pctx, NODECLASS_OBJECT, nb_attributes, attributes);
+            break;
+        case ELEMENT_UAOBJECTTYPE:
+            startNode(pctx, NODECLASS_OBJECTTYPE, nb_attributes, attributes);
+            break;
+        case ELEMENT_UADATATYPE:
+            startNode(pctx, NODECLASS_DATATYPE, nb_attributes, attributes);
+            break;
+        case ELEMENT_UAMETHOD:
+            startNode(pctx, NODECLASS_METHOD, nb_attributes, attributes);
+            break;
+        case ELEMENT_UAREFERENCETYPE:
+            startNode(pctx, NODECLASS_REFERENCETYPE, nb_attributes,
+                      attributes);
+            break;
+        case ELEMENT_UAVARIABLETYPE:
+            startNode(pctx, NODECLASS_VARIABLETYPE, nb_attributes,
+                      attributes);
+            break;
+        case ELEMENT_UAVIEW:
+            startNode(pctx, NODECLASS_VIEW, nb_attributes, attributes);
+            break;
+        case ELEMENT_NAMESPACEURIS:
             pctx->state = PARSER_STATE_NAMESPACEURIS;
-        }
-        else if (!strcmp(localname, ALIAS))
-        {
-            pctx->state = PARSER_STATE_ALIAS;
+            break;
+        case ELEMENT_ALIAS:
             pctx->node = NULL;
             pctx->alias =
                 Nodeset_newAlias(pctx->nodeset, nb_attributes, attributes);
             pctx->state = PARSER_STATE_ALIAS;
-        }
-        else if (!strcmp(localname, "UANodeSet") ||
-                 !strcmp(localname, "Aliases") ||
-                 !strcmp(localname, "Extensions"))
-        {
+            break;
+        case ELEMENT_UANODESET:
+        case ELEMENT_ALIASES:
+        case ELEMENT_EXTENSIONS:
             pctx->state = PARSER_STATE_INIT;
-        }
-        else
-        {
+            break;
+        case ELEMENT_UNKNOWN:
+        case ELEMENT_URI:
+        case ELEMENT_DISPLAYNAME:
+        case ELEMENT_DESCRIPTION:
+        case ELEMENT_REFERENCES:
+        case ELEMENT_REFERENCE:
+        case ELEMENT_VALUE:
+        case ELEMENT_EXTENSION:
+        case ELEMENT_INVERSENAME:
+        case ELEMENT_DEFINITION:
+        case ELEMENT_FIELD:
             enterUnknownState(pctx);
+            break;
         }
         break;
     case PARSER_STATE_NAMESPACEURIS:
-        if (!strcmp(localname, NAMESPACEURI))
+        if (ElementName_lookup(localname) == ELEMENT_URI)
         {
             pctx->state = PARSER_STATE_URI;
         }
@@ -195,50 +324,91 @@ static void OnStartElementNs(void *ctx, const char *localname,
         enterUnknownState(pctx);
         break;
     case PARSER_STATE_NODE:
-        if (!strcmp(localname, DISPLAYNAME))
+        switch (ElementName_lookup(localname))
         {
+        case ELEMENT_DISPLAYNAME:
             Nodeset_setDisplayName(pctx->nodeset, pctx->node, nb_attributes,
                                    attributes);
             pctx->state = PARSER_STATE_DISPLAYNAME;
-        }
-        else if (!strcmp(localname, REFERENCES))
-        {
+            break;
+        case ELEMENT_REFERENCES:
             pctx->state = PARSER_STATE_REFERENCES;
-        }
-        else if (!strcmp(localname, DESCRIPTION))
-        {
+            break;
+        case ELEMENT_DESCRIPTION:
             pctx->state = PARSER_STATE_DESCRIPTION;
             Nodeset_setDescription(pctx->nodeset, pctx->node, nb_attributes,
                                    attributes);
-        }
-        else if (!strcmp(localname, VALUE))
-        {
-            pctx->val = Value_new(pctx->node);
+            break;
+        case ELEMENT_VALUE:
+            // lazy values are parsed without building their data
+            pctx->val = NULL;
+            pctx->valueDecoder = newValueDecoder(pctx);
+            pctx->valueStart = pctx->lazyValues && !pctx->valueDecoder
+                                   ? contentStart(pctx)
+                                   : -1;
+            if (pctx->lazyValues && !pctx->valueDecoder &&
+                pctx->valueStart < 0)
+            {
+                // the values of the rest of the input are decoded as well
+                pctx->nodeset->logger->log(
+                    pctx->nodeset->logger->context,
+                    NODESETLOADER_LOGLEVEL_WARNING,
+                    "NodesetLoader: position of a value in the input unknown, "
+                    "values are decoded while parsing");
+                pctx->lazyValues = false;
+            }
+            if (pctx->valueStart < 0)
+            {
+                pctx->val =
+                    Value_new(pctx->nodeset->valueArena, &pctx->valueCtx);
+                if (!pctx->val)
+                {
+                    abortImport(pctx);
+                    break;
+                }
+            }
+            if (pctx->val && pctx->valueDecoder)
+            {
+                pctx->val->decoder = pctx->valueDecoder;
+            }
             pctx->state = PARSER_STATE_VALUE;
-        }
-        else if (!strcmp(localname, EXTENSIONS))
-        {
+            break;
+        case ELEMENT_EXTENSIONS:
             pctx->state = PARSER_STATE_EXTENSIONS;
-        }
-        else if (!strcmp(localname, "Definition"))
-        {
-            Nodeset_addDataTypeDefinition(pctx->nodeset, pctx->node, nb_attributes,
-                                     attributes);
+            break;
+        case ELEMENT_DEFINITION:
+            Nodeset_addDataTypeDefinition(pctx->nodeset, pctx->node,
+                                          nb_attributes, attributes);
             pctx->state = PARSER_STATE_DATATYPE_DEFINITION;
-        }
-        else if (!strcmp(localname, INVERSENAME))
-        {
+            break;
+        case ELEMENT_INVERSENAME:
             pctx->state = PARSER_STATE_INVERSENAME;
             Nodeset_setInverseName(pctx->nodeset, pctx->node, nb_attributes,
                                    attributes);
-        }
-        else
-        {
+            break;
+        case ELEMENT_UNKNOWN:
+        case ELEMENT_UANODESET:
+        case ELEMENT_NAMESPACEURIS:
+        case ELEMENT_URI:
+        case ELEMENT_ALIASES:
+        case ELEMENT_ALIAS:
+        case ELEMENT_UAOBJECT:
+        case ELEMENT_UAOBJECTTYPE:
+        case ELEMENT_UAVARIABLE:
+        case ELEMENT_UAVARIABLETYPE:
+        case ELEMENT_UADATATYPE:
+        case ELEMENT_UAREFERENCETYPE:
+        case ELEMENT_UAMETHOD:
+        case ELEMENT_UAVIEW:
+        case ELEMENT_REFERENCE:
+        case ELEMENT_EXTENSION:
+        case ELEMENT_FIELD:
             enterUnknownState(pctx);
+            break;
         }
         break;
     case PARSER_STATE_DATATYPE_DEFINITION:
-        if (!strcmp(localname, "Field"))
+        if (ElementName_lookup(localname) == ELEMENT_FIELD)
         {
             Nodeset_addDataTypeField(pctx->nodeset, pctx->node, nb_attributes,
                                      attributes);
@@ -254,19 +424,39 @@ static void OnStartElementNs(void *ctx, const char *localname,
         break;
 
     case PARSER_STATE_VALUE:
+        if (pctx->valueDecoder)
+        {
+            pctx->valueIf->start(pctx->valueDecoder, localname);
+            pctx->unknown_depth++;
+            break;
+        }
+        if (!pctx->val)
+        {
+            pctx->unknown_depth++;
+            break;
+        }
         // copy the name
         {
             size_t len = strlen(localname);
             char *localNameCopy =
                 CharArenaAllocator_malloc(pctx->nodeset->charArena, len + 1);
+            if (!localNameCopy)
+            {
+                abortImport(pctx);
+                break;
+            }
             memcpy(localNameCopy, localname, len);
-            Value_start(pctx->val, localNameCopy);
+            if (!Value_start(pctx->val, localNameCopy))
+            {
+                abortImport(pctx);
+                break;
+            }
             pctx->unknown_depth++;
         }
         break;
 
     case PARSER_STATE_EXTENSIONS:
-        if (!strcmp(localname, EXTENSION))
+        if (ElementName_lookup(localname) == ELEMENT_EXTENSION)
         {
             if (pctx->extIf)
             {
@@ -287,11 +477,16 @@ static void OnStartElementNs(void *ctx, const char *localname,
         break;
 
     case PARSER_STATE_REFERENCES:
-        if (!strcmp(localname, REFERENCE))
+        if (ElementName_lookup(localname) == ELEMENT_REFERENCE)
         {
-            pctx->state = PARSER_STATE_REFERENCE;
             pctx->ref = Nodeset_newReference(pctx->nodeset, pctx->node,
                                              nb_attributes, attributes);
+            if (!pctx->ref)
+            {
+                abortImport(pctx);
+                break;
+            }
+            pctx->state = PARSER_STATE_REFERENCE;
         }
         else
         {
@@ -325,6 +520,10 @@ static void OnEndElementNs(void *ctx, const char *localname, const char *prefix,
                            const char *URI)
 {
     TParserCtx *pctx = (TParserCtx *)ctx;
+    if (pctx->failed)
+    {
+        return;
+    }
     switch (pctx->state)
     {
     case PARSER_STATE_INIT:
@@ -344,7 +543,11 @@ static void OnEndElementNs(void *ctx, const char *localname, const char *prefix,
         pctx->state = PARSER_STATE_INIT;
         break;
     case PARSER_STATE_NODE:
-        Nodeset_newNodeFinish(pctx->nodeset, pctx->node);
+        if (!Nodeset_newNodeFinish(pctx->nodeset, pctx->node))
+        {
+            abortImport(pctx);
+            return;
+        }
         pctx->state = PARSER_STATE_INIT;
         break;
     case PARSER_STATE_DISPLAYNAME:
@@ -363,8 +566,22 @@ static void OnEndElementNs(void *ctx, const char *localname, const char *prefix,
     }
     break;
     case PARSER_STATE_VALUE:
-        if (!strcmp(localname, VALUE) && pctx->unknown_depth == 0)
+        if (pctx->unknown_depth == 0 &&
+            ElementName_lookup(localname) == ELEMENT_VALUE)
         {
+            if (pctx->valueDecoder)
+            {
+                pctx->valueIf->finish(pctx->valueDecoder);
+                pctx->valueDecoder = NULL;
+            }
+            if (pctx->val)
+            {
+                Value_finish(pctx->val);
+            }
+            else if (pctx->node->nodeClass == NODECLASS_VARIABLE)
+            {
+                pctx->val = newLazyValue(pctx);
+            }
             /* TODO: Enable VariableType to hold a valeu */
             if(pctx->node->nodeClass == NODECLASS_VARIABLE)
                 ((NL_VariableNode *)pctx->node)->value = pctx->val;
@@ -372,12 +589,20 @@ static void OnEndElementNs(void *ctx, const char *localname, const char *prefix,
         }
         else
         {
-            Value_end(pctx->val, localname, pctx->onCharacters);
+            if (pctx->valueDecoder)
+            {
+                pctx->valueIf->end(pctx->valueDecoder, localname,
+                                   pctx->onCharacters);
+            }
+            else if (pctx->val)
+            {
+                Value_end(pctx->val, localname, pctx->onCharacters);
+            }
             pctx->unknown_depth--;
         }
         break;
     case PARSER_STATE_EXTENSION:
-        if (!strcmp(localname, EXTENSION))
+        if (ElementName_lookup(localname) == ELEMENT_EXTENSION)
         {
             if (pctx->extIf)
             {
@@ -428,6 +653,10 @@ static void OnEndElementNs(void *ctx, const char *localname, const char *prefix,
 static void OnCharacters(void *ctx, const char *ch, int len)
 {
     TParserCtx *pctx = (TParserCtx *)ctx;
+    if (pctx->failed || (pctx->state == PARSER_STATE_VALUE && !pctx->val))
+    {
+        return;
+    }
     if (pctx->onCharacters == NULL)
     {
         char *newValue = CharArenaAllocator_malloc(pctx->nodeset->charArena,
@@ -443,8 +672,8 @@ static void OnCharacters(void *ctx, const char *ch, int len)
     pctx->onCharLength += (size_t)len;
 }
 
-bool NodesetLoader_importFile(NodesetLoader *loader,
-                              const NL_FileContext *fileHandler)
+static bool prepareImport(NodesetLoader *loader,
+                          const NL_FileContext *fileHandler)
 {
     if (fileHandler == NULL)
     {
@@ -460,30 +689,26 @@ bool NodesetLoader_importFile(NodesetLoader *loader,
                             "NodesetLoader: fileHandler->addNamespace missing");
         return false;
     }
-    bool retStatus = true;
     if (!loader->nodeset)
     {
         loader->nodeset = Nodeset_new(fileHandler->addNamespace, loader->logger,
                                       loader->refService);
+        if (!loader->nodeset)
+        {
+            return false;
+        }
     }
+    Nodeset_newFile(loader->nodeset);
+    return true;
+}
 
-    TParserCtx *ctx = NULL;
-    FILE *f = fopen(fileHandler->file, "r");
-
-    if (!f)
-    {
-        loader->logger->log(loader->logger->context,
-                            NODESETLOADER_LOGLEVEL_ERROR,
-                            "NodesetLoader: file open error");
-        retStatus = false;
-        goto cleanup;
-    }
-
-    ctx = (TParserCtx *)calloc(1, sizeof(TParserCtx));
+static TParserCtx *newParserCtx(NodesetLoader *loader,
+                                const NL_FileContext *fileHandler)
+{
+    TParserCtx *ctx = (TParserCtx *)calloc(1, sizeof(TParserCtx));
     if (!ctx)
     {
-        retStatus = false;
-        goto cleanup;
+        return NULL;
     }
     ctx->nodeset = loader->nodeset;
     ctx->state = PARSER_STATE_INIT;
@@ -493,28 +718,301 @@ bool NodesetLoader_importFile(NodesetLoader *loader,
     ctx->onCharLength = 0;
     ctx->userContext = fileHandler->userContext;
     ctx->extIf = fileHandler->extensionHandling;
+    ctx->valueIf = loader->valueInterface;
+    return ctx;
+}
 
-    Parser *parser = Parser_new(ctx);
-    if (Parser_run(parser, f, OnStartElementNs, OnEndElementNs, OnCharacters))
+// decompresses the input on the fly and pushes it into the parser, the
+// decompressed document is never held in memory as a whole
+static bool importFromInput(NodesetLoader *loader,
+                            const NL_FileContext *fileHandler,
+                            CompressedInput *input)
+{
+    CompressedInput_Format format = CompressedInput_format(input);
+    if (!CompressedInput_isSupported(format))
     {
         loader->logger->log(loader->logger->context,
-                            NODESETLOADER_LOGLEVEL_ERROR, "xml parsing error");
+                            NODESETLOADER_LOGLEVEL_ERROR,
+                            "NodesetLoader: nodeset is %s compressed, but "
+                            "support for it is not enabled",
+                            CompressedInput_formatName(format));
+        return false;
+    }
+    TParserCtx *ctx = newParserCtx(loader, fileHandler);
+    if (!ctx)
+    {
+        return false;
+    }
+    bool retStatus = true;
+    Parser *parser = Parser_new(ctx);
+    if (!parser)
+    {
+        free(ctx);
+        return false;
+    }
+    ctx->parser = parser;
+    if (Parser_runStream(parser, CompressedInput_read, input, OnStartElementNs,
+                         OnEndElementNs, OnCharacters))
+    {
+        const char *inputError = CompressedInput_error(input);
+        if (inputError)
+        {
+            loader->logger->log(loader->logger->context,
+                                NODESETLOADER_LOGLEVEL_ERROR,
+                                "NodesetLoader: %s input: %s",
+                                CompressedInput_formatName(format), inputError);
+        }
+        else if (!ctx->failed)
+        {
+            loader->logger->log(loader->logger->context,
+                                NODESETLOADER_LOGLEVEL_ERROR,
+                                "xml parsing error");
+        }
         retStatus = false;
     }
     Parser_delete(parser);
+    free(ctx);
+    return retStatus;
+}
+
+static bool importFromBuffer(NodesetLoader *loader,
+                             const NL_FileContext *fileHandler,
+                             const char *buffer, size_t size)
+{
+    // compressed input and documents which exceed the size limit of the
+    // in place parser are pushed chunk by chunk into the parser
+    if (CompressedInput_detect(buffer, size) != COMPRESSION_NONE ||
+        size > INT_MAX)
+    {
+        CompressedInput *input = CompressedInput_newFromMemory(buffer, size);
+        if (!input)
+        {
+            return false;
+        }
+        bool retStatus = importFromInput(loader, fileHandler, input);
+        CompressedInput_delete(input);
+        return retStatus;
+    }
 
-cleanup:
+    TParserCtx *ctx = newParserCtx(loader, fileHandler);
+    if (!ctx)
+    {
+        return false;
+    }
+    bool retStatus = true;
+    Parser *parser = Parser_new(ctx);
+    if (!parser)
+    {
+        free(ctx);
+        return false;
+    }
+    ctx->lazyValues = loader->lazyValues;
+    ctx->input = buffer;
+    ctx->inputSize = size;
+    ctx->parser = parser;
+    if (Parser_runBuffer(parser, buffer, size, OnStartElementNs,
+                         OnEndElementNs, OnCharacters))
+    {
+        if (!ctx->failed)
+        {
+            loader->logger->log(loader->logger->context,
+                                NODESETLOADER_LOGLEVEL_ERROR,
+                                "xml parsing error");
+        }
+        retStatus = false;
+    }
+    Parser_delete(parser);
     free(ctx);
-    if (f)
+    return retStatus;
+}
+
+static bool importFromStream(NodesetLoader *loader,
+                             const NL_FileContext *fileHandler, FILE *f)
+{
+    CompressedInput *input = CompressedInput_newFromFile(f);
+    if (!input)
+    {
+        return false;
+    }
+    bool retStatus = importFromInput(loader, fileHandler, input);
+    CompressedInput_delete(input);
+    return retStatus;
+}
+
+bool NodesetLoader_importFile(NodesetLoader *loader,
+                              const NL_FileContext *fileHandler)
+{
+    if (!prepareImport(loader, fileHandler))
     {
-        fclose(f);
+        return false;
+    }
+
+    // regular files are parsed in one pass from a mapped view, anything else
+    // (pipes, devices) is pushed chunk by chunk into the parser
+    // compressed files (gzip, zstd) are detected by their magic bytes and
+    // decompressed on the fly
+    if (MappedFile_isRegularFile(fileHandler->file))
+    {
+        MappedFile *mapped = MappedFile_open(fileHandler->file);
+        if (mapped)
+        {
+            bool retStatus =
+                importFromBuffer(loader, fileHandler, MappedFile_data(mapped),
+                                 MappedFile_size(mapped));
+            MappedFile_close(mapped);
+            return retStatus;
+        }
+    }
+
+    FILE *f = fopen(fileHandler->file, "rb");
+    if (!f)
+    {
+        loader->logger->log(loader->logger->context,
+                            NODESETLOADER_LOGLEVEL_ERROR,
+                            "NodesetLoader: file open error");
+        return false;
     }
+    bool retStatus = importFromStream(loader, fileHandler, f);
+    fclose(f);
     return retStatus;
 }
 
+bool NodesetLoader_importBuffer(NodesetLoader *loader,
+                                const NL_FileContext *fileContext,
+                                const char *buffer, size_t size)
+{
+    if (!prepareImport(loader, fileContext))
+    {
+        return false;
+    }
+    if (!buffer || size == 0)
+    {
+        loader->logger->log(loader->logger->context,
+                            NODESETLOADER_LOGLEVEL_ERROR,
+                            "NodesetLoader: empty buffer - abort");
+        return false;
+    }
+    return importFromBuffer(loader, fileContext, buffer, size);
+}
+
+// decoding of a value which was kept as xml, the data is allocated from the
+// arena of the value
+typedef struct
+{
+    NL_Value *value;
+    Arena *arena;
+    char *characters;
+    size_t characterLength;
+    Parser *parser;
+} ValueDecoder;
+
+static char *decoderCopy(ValueDecoder *decoder, const char *str, size_t len)
+{
+    char *copy = (char *)Arena_alloc(decoder->arena, len + 1);
+    if (copy)
+    {
+        memcpy(copy, str, len);
+    }
+    return copy;
+}
+
+static void OnValueStart(void *ctx, const char *localname, const char *prefix,
+                         const char *URI, int nb_namespaces,
+                         const char **namespaces, int nb_attributes,
+                         int nb_defaulted, const char **attributes)
+{
+    ValueDecoder *decoder = (ValueDecoder *)ctx;
+    char *name = decoderCopy(decoder, localname, strlen(localname));
+    if (!name || !Value_start(decoder->value, name))
+    {
+        // the decoding fails
+        Parser_stop(decoder->parser);
+        return;
+    }
+    decoder->characters = NULL;
+    decoder->characterLength = 0;
+}
+
+static void OnValueEnd(void *ctx, const char *localname, const char *prefix,
+                       const char *URI)
+{
+    ValueDecoder *decoder = (ValueDecoder *)ctx;
+    Value_end(decoder->value, localname, decoder->characters);
+    decoder->characters = NULL;
+    decoder->characterLength = 0;
+}
+
+static void OnValueCharacters(void *ctx, const char *ch, int len)
+{
+    ValueDecoder *decoder = (ValueDecoder *)ctx;
+    // the text of an element is usually passed in one piece, otherwise the
+    // pieces are joined in a new copy
+    size_t length = decoder->characterLength + (size_t)len;
+    char *chars = (char *)Arena_alloc(decoder->arena, length + 1);
+    if (!chars)
+    {
+        Parser_stop(decoder->parser);
+        return;
+    }
+    if (decoder->characters)
+    {
+        memcpy(chars, decoder->characters, decoder->characterLength);
+    }
+    memcpy(chars + decoder->characterLength, ch, (size_t)len);
+    decoder->characters = chars;
+    decoder->characterLength = length;
+}
+
+bool NL_Value_decode(NL_Value *value)
+{
+    if (!value)
+    {
+        return true;
+    }
+    if (!Value_beginDecode(value))
+    {
+        Value_finish(value);
+        return true;
+    }
+    ValueDecoder decoder;
+    decoder.value = value;
+    decoder.arena = value->ctx->arena;
+    decoder.characters = NULL;
+    decoder.characterLength = 0;
+    Parser *parser = Parser_new(&decoder);
+    if (!parser)
+    {
+        // the value stays undecoded and can be decoded by another call
+        return false;
+    }
+    decoder.parser = parser;
+    int ret = Parser_runBuffer(parser, value->xml, value->xmlSize,
+                               OnValueStart, OnValueEnd, OnValueCharacters);
+    Parser_delete(parser);
+    Value_finish(value);
+    return ret == 0;
+}
+
 bool NodesetLoader_sort(NodesetLoader *loader)
 {
-    return Nodeset_sort(loader->nodeset);
+    return Nodeset_sort(loader->nodeset, loader->pruneUnloadedNamespaces);
+}
+
+void NodesetLoader_setPruneUnloadedNamespaces(NodesetLoader *loader,
+                                              bool prune)
+{
+    loader->pruneUnloadedNamespaces = prune;
+}
+
+void NodesetLoader_setLazyValues(NodesetLoader *loader, bool lazy)
+{
+    loader->lazyValues = lazy;
+}
+
+void NodesetLoader_setValueInterface(NodesetLoader *loader,
+                                     const NL_ValueInterface *valueInterface)
+{
+    loader->valueInterface = valueInterface;
 }
 
 NodesetLoader *NodesetLoader_new(NodesetLoader_Logger *logger,
@@ -566,9 +1064,62 @@ NodesetLoader_getBidirectionalRefs(const NodesetLoader *loader)
     return Nodeset_getBiDirectionalRefs(loader->nodeset);
 }
 
+NL_Reference *NodesetLoader_newReference(NodesetLoader *loader)
+{
+    if (!loader->nodeset)
+    {
+        return NULL;
+    }
+    return Nodeset_allocReference(loader->nodeset);
+}
+
+NL_Node *NodesetLoader_getNode(const NodesetLoader *loader,
+                               const UA_NodeId *id)
+{
+    if (!loader->nodeset)
+    {
+        return NULL;
+    }
+    return Nodeset_getNode(loader->nodeset, id);
+}
+
+bool NodesetLoader_compactReferences(NodesetLoader *loader)
+{
+    if (!loader->nodeset)
+    {
+        return false;
+    }
+    return Nodeset_compactReferences(loader->nodeset);
+}
+
+const NL_Reference *NodesetLoader_getHierachicalRefs(const NL_Node *node,
+                                                     size_t *size)
+{
+    *size = node->compactRefs.hierachicalSize;
+    return *size ? node->compactRefs.refs : NULL;
+}
+
+const NL_Reference *NodesetLoader_getNonHierachicalRefs(const NL_Node *node,
+                                                        size_t *size)
+{
+    *size = node->compactRefs.nonHierachicalSize;
+    return *size ? node->compactRefs.refs + node->compactRefs.hierachicalSize
+                 : NULL;
+}
+
 size_t NodesetLoader_forEachNode(NodesetLoader *loader, NL_NodeClass nodeClass,
                                void *context,
                                NodesetLoader_forEachNode_Func fn)
 {
     return Nodeset_forEachNode(loader->nodeset, nodeClass, context, fn);
 }
+
+size_t NodesetLoader_forEachLevel(NodesetLoader *loader, void *context,
+                                  NodesetLoader_forEachLevel_Func fn)
+{
+    if (!loader->nodeset)
+    {
+        return 0;
+    }
+    return Nodeset_forEachLevel(loader->nodeset, context, fn);
+}
@@ -0,0 +1,69 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "Ns0Tables.h"
+
+static bool isNs0Numeric(const UA_NodeId *id)
+{
+    return id->namespaceIndex == 0 &&
+           id->identifierType == UA_NODEIDTYPE_NUMERIC;
+}
+
+// the tables are sorted by id
+const Ns0Tables_ReferenceType *
+Ns0Tables_findReferenceType(const UA_NodeId *id)
+{
+    if (!isNs0Numeric(id))
+    {
+        return NULL;
+    }
+    size_t low = 0;
+    size_t high = Ns0Tables_referenceTypesSize;
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        const Ns0Tables_ReferenceType *type = &Ns0Tables_referenceTypes[mid];
+        if (type->id == id->identifier.numeric)
+        {
+            return type;
+        }
+        if (type->id < id->identifier.numeric)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return NULL;
+}
+
+const Ns0Tables_DataType *Ns0Tables_findDataType(const UA_NodeId *id)
+{
+    if (!isNs0Numeric(id))
+    {
+        return NULL;
+    }
+    size_t low = 0;
+    size_t high = Ns0Tables_dataTypesSize;
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        const Ns0Tables_DataType *type = &Ns0Tables_dataTypes[mid];
+        if (type->id == id->identifier.numeric)
+        {
+            return type;
+        }
+        if (type->id < id->identifier.numeric)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,49 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NS0TABLES_H
+#define NS0TABLES_H
+#include "NodesetLoader/NodesetLoader.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Metadata of the reference types and data types of namespace 0. The tables
+// are generated from Opc.Ua.NodeSet2.xml by cmake/GenerateNs0Tables.cmake
+// and sorted by id, an id of 0 stands for none.
+
+// classification of a reference type by its supertypes
+#define NS0TABLES_HIERACHICAL 0x01
+#define NS0TABLES_NONHIERACHICAL 0x02
+#define NS0TABLES_HASTYPEDEFINITION 0x04
+
+struct Ns0Tables_ReferenceType
+{
+    uint32_t id;
+    uint32_t superType;
+    uint8_t flags;
+};
+typedef struct Ns0Tables_ReferenceType Ns0Tables_ReferenceType;
+
+struct Ns0Tables_DataType
+{
+    uint32_t id;
+    uint32_t superType;
+    uint32_t binaryEncodingId;
+    uint32_t xmlEncodingId;
+    uint32_t jsonEncodingId;
+};
+typedef struct Ns0Tables_DataType Ns0Tables_DataType;
+
+extern const Ns0Tables_ReferenceType Ns0Tables_referenceTypes[];
+extern const size_t Ns0Tables_referenceTypesSize;
+extern const Ns0Tables_DataType Ns0Tables_dataTypes[];
+extern const size_t Ns0Tables_dataTypesSize;
+
+// NULL if the id is not a reference type of namespace 0
+const Ns0Tables_ReferenceType *
+Ns0Tables_findReferenceType(const UA_NodeId *id);
+// NULL if the id is not a data type of namespace 0
+const Ns0Tables_DataType *Ns0Tables_findDataType(const UA_NodeId *id);
+
+#endif
@@ -0,0 +1,288 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "NumberParser.h"
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define NUMBERPARSER_SWAR
+#endif
+
+// 10^19 is the largest power of ten below 2^64
+#define MAX_EXACT_DIGITS 19
+// integers up to 2^53 and powers of ten up to 10^22 are exact doubles, the
+// product or quotient of both is correctly rounded
+#define DOUBLE_MAX_EXACT_MANTISSA ((uint64_t)1 << 53)
+#define DOUBLE_MAX_EXACT_EXPONENT 22
+#define FLOAT_MAX_EXACT_MANTISSA ((uint64_t)1 << 24)
+#define FLOAT_MAX_EXACT_EXPONENT 10
+
+static const double powersOfTen[DOUBLE_MAX_EXACT_EXPONENT + 1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+static const float floatPowersOfTen[FLOAT_MAX_EXACT_EXPONENT + 1] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+#ifdef NUMBERPARSER_SWAR
+// the 8 bytes are all ascii digits
+static bool isEightDigits(uint64_t chunk)
+{
+    return ((chunk & 0xF0F0F0F0F0F0F0F0u) |
+            (((chunk + 0x0606060606060606u) & 0xF0F0F0F0F0F0F0F0u) >> 4)) ==
+           0x3333333333333333u;
+}
+
+// value of 8 ascii digits, the first digit is in the lowest byte
+static uint64_t eightDigits(uint64_t chunk)
+{
+    chunk -= 0x3030303030303030u;
+    // pairs of digits, then groups of 4 digits
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & 0x000000FF000000FFu) * (100 + (1000000ull << 32))) +
+             (((chunk >> 16) & 0x000000FF000000FFu) *
+              (1 + (10000ull << 32)))) >>
+            32;
+    return chunk;
+}
+#endif
+
+// accumulates the digits at *pos into value, at most maxDigits of them.
+// Returns the number of digits which were consumed.
+static size_t parseDigits(const char **pos, const char *end, uint64_t *value,
+                          size_t maxDigits)
+{
+    const char *p = *pos;
+    uint64_t v = *value;
+    size_t count = 0;
+#ifdef NUMBERPARSER_SWAR
+    while (count + 8 <= maxDigits && end - p >= 8)
+    {
+        uint64_t chunk;
+        memcpy(&chunk, p, sizeof(chunk));
+        if (!isEightDigits(chunk))
+        {
+            break;
+        }
+        v = v * 100000000u + eightDigits(chunk);
+        p += 8;
+        count += 8;
+    }
+#else
+    (void)end;
+#endif
+    while (count < maxDigits && isDigit(*p))
+    {
+        v = v * 10 + (uint64_t)(*p - '0');
+        p++;
+        count++;
+    }
+    *pos = p;
+    *value = v;
+    return count;
+}
+
+static const char *skipSpace(const char *text)
+{
+    while (isspace((unsigned char)*text))
+    {
+        text++;
+    }
+    return text;
+}
+
+// magnitude of the integer at the start of text, false if it doesn't fit
+// into 64 bit
+static bool parseMagnitude(const char **text, bool *negative,
+                           uint64_t *magnitude)
+{
+    const char *p = skipSpace(*text);
+    *negative = *p == '-';
+    if (*p == '-' || *p == '+')
+    {
+        p++;
+    }
+    // leading zeros don't count as digits of the value
+    while (*p == '0' && isDigit(p[1]))
+    {
+        p++;
+    }
+    const char *end = p + strlen(p);
+    uint64_t value = 0;
+    parseDigits(&p, end, &value, MAX_EXACT_DIGITS);
+    bool inRange = true;
+    while (isDigit(*p))
+    {
+        const uint64_t digit = (uint64_t)(*p - '0');
+        if (value > (UINT64_MAX - digit) / 10)
+        {
+            inRange = false;
+        }
+        value = value * 10 + digit;
+        p++;
+    }
+    *text = p;
+    *magnitude = value;
+    return inRange;
+}
+
+int64_t NumberParser_toInt64(const char *text)
+{
+    bool negative = false;
+    uint64_t magnitude = 0;
+    bool inRange = parseMagnitude(&text, &negative, &magnitude);
+    if (negative)
+    {
+        if (!inRange || magnitude > (uint64_t)INT64_MAX + 1)
+        {
+            return INT64_MIN;
+        }
+        return magnitude == (uint64_t)INT64_MAX + 1 ? INT64_MIN
+                                                     : -(int64_t)magnitude;
+    }
+    if (!inRange || magnitude > (uint64_t)INT64_MAX)
+    {
+        return INT64_MAX;
+    }
+    return (int64_t)magnitude;
+}
+
+uint64_t NumberParser_toUInt64(const char *text)
+{
+    bool negative = false;
+    uint64_t magnitude = 0;
+    if (!parseMagnitude(&text, &negative, &magnitude))
+    {
+        return UINT64_MAX;
+    }
+    return negative ? 0u - magnitude : magnitude;
+}
+
+// decimal number of the form [sign]digits[.digits][e[sign]digits] which is
+// followed by the end of the text or whitespace, false if there are more
+// significant digits than fit into the mantissa
+static bool parseDecimal(const char *text, bool *negative, uint64_t *mantissa,
+                         int *exponent)
+{
+    const char *p = skipSpace(text);
+    *negative = *p == '-';
+    if (*p == '-' || *p == '+')
+    {
+        p++;
+    }
+    bool hasDigits = false;
+    while (*p == '0')
+    {
+        p++;
+        hasDigits = true;
+    }
+    const char *end = p + strlen(p);
+    uint64_t value = 0;
+    size_t digits = parseDigits(&p, end, &value, MAX_EXACT_DIGITS);
+    hasDigits = hasDigits || digits > 0;
+    if (isDigit(*p))
+    {
+        return false;
+    }
+    int exp = 0;
+    if (*p == '.')
+    {
+        p++;
+        const char *fraction = p;
+        if (value == 0)
+        {
+            // leading zeros of the fraction only shift the exponent
+            while (*p == '0')
+            {
+                p++;
+            }
+        }
+        digits += parseDigits(&p, end, &value, MAX_EXACT_DIGITS - digits);
+        if (isDigit(*p))
+        {
+            return false;
+        }
+        exp = -(int)(p - fraction);
+        hasDigits = hasDigits || p > fraction;
+    }
+    if (!hasDigits)
+    {
+        return false;
+    }
+    if (*p == 'e' || *p == 'E')
+    {
+        p++;
+        bool negativeExp = *p == '-';
+        if (*p == '-' || *p == '+')
+        {
+            p++;
+        }
+        if (!isDigit(*p))
+        {
+            return false;
+        }
+        int e = 0;
+        while (isDigit(*p) && e < 10000)
+        {
+            e = e * 10 + (*p - '0');
+            p++;
+        }
+        if (isDigit(*p))
+        {
+            return false;
+        }
+        exp += negativeExp ? -e : e;
+    }
+    if (*p != '\0' && !isspace((unsigned char)*p))
+    {
+        return false;
+    }
+    *mantissa = value;
+    *exponent = exp;
+    return true;
+}
+
+double NumberParser_toDouble(const char *text)
+{
+    bool negative = false;
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    if (parseDecimal(text, &negative, &mantissa, &exponent) &&
+        mantissa <= DOUBLE_MAX_EXACT_MANTISSA &&
+        exponent >= -DOUBLE_MAX_EXACT_EXPONENT &&
+        exponent <= DOUBLE_MAX_EXACT_EXPONENT)
+    {
+        double value = (double)mantissa;
+        value = exponent < 0 ? value / powersOfTen[-exponent]
+                             : value * powersOfTen[exponent];
+        return negative ? -value : value;
+    }
+    return strtod(text, NULL);
+}
+
+float NumberParser_toFloat(const char *text)
+{
+    bool negative = false;
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    if (parseDecimal(text, &negative, &mantissa, &exponent) &&
+        mantissa <= FLOAT_MAX_EXACT_MANTISSA &&
+        exponent >= -FLOAT_MAX_EXACT_EXPONENT &&
+        exponent <= FLOAT_MAX_EXACT_EXPONENT)
+    {
+        float value = (float)mantissa;
+        value = exponent < 0 ? value / floatPowersOfTen[-exponent]
+                             : value * floatPowersOfTen[exponent];
+        return negative ? -value : value;
+    }
+    return strtof(text, NULL);
+}
@@ -0,0 +1,22 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NUMBERPARSER_H
+#define NUMBERPARSER_H
+#include <stdint.h>
+
+// conversion of the text of numeric values, the number at the start of the
+// text is converted like strtoll, strtoull, strtod and strtof do it. Runs of
+// 8 digits are converted at once and decimal numbers which can be
+// represented exactly are converted without strtod.
+
+// out of range values are clamped to the limits of int64_t
+int64_t NumberParser_toInt64(const char *text);
+// negative values wrap around like with strtoull, out of range values are
+// clamped to UINT64_MAX
+uint64_t NumberParser_toUInt64(const char *text);
+double NumberParser_toDouble(const char *text);
+float NumberParser_toFloat(const char *text);
+
+#endif
@@ -0,0 +1,102 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "ObjectPool.h"
+#include <stdlib.h>
+
+// objects are placed at multiples of the strictest alignment of the types
+// stored in nodes
+typedef union
+{
+    void *p;
+    double d;
+    long long ll;
+} MaxAlign;
+
+struct Slab
+{
+    struct Slab *next;
+    char *mem;
+};
+
+struct ObjectPool
+{
+    size_t objectSize;
+    size_t objectsPerSlab;
+    // objects which are already handed out from the current slab
+    size_t used;
+    size_t slabCount;
+    struct Slab *current;
+};
+
+ObjectPool *ObjectPool_new(size_t objectSize, size_t objectsPerSlab)
+{
+    ObjectPool *pool = (ObjectPool *)calloc(1, sizeof(ObjectPool));
+    if (!pool)
+    {
+        return NULL;
+    }
+    const size_t align = sizeof(MaxAlign);
+    pool->objectSize = (objectSize + align - 1) / align * align;
+    pool->objectsPerSlab = objectsPerSlab > 0 ? objectsPerSlab : 1;
+    pool->used = pool->objectsPerSlab;
+    return pool;
+}
+
+static struct Slab *Slab_new(const ObjectPool *pool)
+{
+    struct Slab *slab = (struct Slab *)malloc(sizeof(struct Slab));
+    if (!slab)
+    {
+        return NULL;
+    }
+    slab->mem = (char *)calloc(pool->objectsPerSlab, pool->objectSize);
+    if (!slab->mem)
+    {
+        free(slab);
+        return NULL;
+    }
+    slab->next = pool->current;
+    return slab;
+}
+
+void *ObjectPool_alloc(ObjectPool *pool)
+{
+    if (pool->used == pool->objectsPerSlab)
+    {
+        struct Slab *slab = Slab_new(pool);
+        if (!slab)
+        {
+            return NULL;
+        }
+        pool->current = slab;
+        pool->used = 0;
+        pool->slabCount++;
+    }
+    void *object = pool->current->mem + pool->used * pool->objectSize;
+    pool->used++;
+    return object;
+}
+
+size_t ObjectPool_slabCount(const ObjectPool *pool)
+{
+    return pool->slabCount;
+}
+
+void ObjectPool_delete(ObjectPool *pool)
+{
+    if (!pool)
+    {
+        return;
+    }
+    struct Slab *slab = pool->current;
+    while (slab)
+    {
+        struct Slab *next = slab->next;
+        free(slab->mem);
+        free(slab);
+        slab = next;
+    }
+    free(pool);
+}
@@ -0,0 +1,20 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+#include <stddef.h>
+
+// allocates objects of one size from slabs, single objects cannot be freed,
+// all of them are released at once when the pool is deleted
+struct ObjectPool;
+typedef struct ObjectPool ObjectPool;
+
+ObjectPool *ObjectPool_new(size_t objectSize, size_t objectsPerSlab);
+// returns zeroed memory for one object, NULL if no new slab can be allocated
+void *ObjectPool_alloc(ObjectPool *pool);
+size_t ObjectPool_slabCount(const ObjectPool *pool);
+void ObjectPool_delete(ObjectPool *pool);
+
+#endif
@@ -6,57 +6,216 @@
  */
 
 #include "Parser.h"
-#include <assert.h>
 #include <libxml/SAX.h>
+#include <libxml/parserInternals.h>
+#include <limits.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
 struct Parser
 {
     void *context;
+    // parser of the buffer which is currently parsed
+    xmlParserCtxtPtr bufferCtxt;
+    // parser of the document which is currently parsed, buffer or stream
+    xmlParserCtxtPtr ctxt;
+    bool stopped;
 };
 
 Parser *Parser_new(void *context)
 {
     Parser *parser = (Parser *)calloc(1, sizeof(Parser));
-    assert(parser);
+    if (!parser)
+    {
+        return NULL;
+    }
     parser->context = context;
     return parser;
 }
 
-int Parser_run(Parser *parser, FILE *file, Parser_callbackStart start,
-               Parser_callbackEnd end, Parser_callbackChar onChars)
+static void initHandler(xmlSAXHandler *hdl, Parser_callbackStart start,
+                        Parser_callbackEnd end, Parser_callbackChar onChars)
+{
+    memset(hdl, 0, sizeof(xmlSAXHandler));
+    hdl->initialized = XML_SAX2_MAGIC;
+    // nodesets are encoded with UTF-8
+    // this code does no transformation on the encoded text or interprets it
+    // so it should be safe to cast xmlChar* to char*
+    hdl->startElementNs = (startElementNsSAX2Func)start;
+    hdl->endElementNs = (endElementNsSAX2Func)end;
+    hdl->characters = (charactersSAXFunc)onChars;
+}
+
+// the part of a buffer which is not yet handed over to the parser
+typedef struct
+{
+    const char *pos;
+    size_t size;
+} MemoryInput;
+
+#if LIBXML_VERSION >= 21300
+// the parser reads the document in place, libxml2 only keeps a reference to
+// the buffer instead of copying it like xmlCreateMemoryParserCtxt does
+static xmlParserCtxtPtr newMemoryCtxt(MemoryInput *memory)
+{
+    xmlParserCtxtPtr ctxt = xmlNewParserCtxt();
+    if (!ctxt)
+    {
+        return NULL;
+    }
+    xmlParserInputBufferPtr inputBuffer = xmlParserInputBufferCreateStatic(
+        memory->pos, (int)memory->size, XML_CHAR_ENCODING_NONE);
+    if (!inputBuffer)
+    {
+        xmlFreeParserCtxt(ctxt);
+        return NULL;
+    }
+    xmlParserInputPtr input =
+        xmlNewIOInputStream(ctxt, inputBuffer, XML_CHAR_ENCODING_NONE);
+    if (!input)
+    {
+        xmlFreeParserInputBuffer(inputBuffer);
+        xmlFreeParserCtxt(ctxt);
+        return NULL;
+    }
+    if (inputPush(ctxt, input) < 0)
+    {
+        xmlFreeInputStream(input);
+        xmlFreeParserCtxt(ctxt);
+        return NULL;
+    }
+    return ctxt;
+}
+#else
+static int readMemory(void *context, char *buffer, int len)
+{
+    MemoryInput *memory = (MemoryInput *)context;
+    size_t n = memory->size < (size_t)len ? memory->size : (size_t)len;
+    memcpy(buffer, memory->pos, n);
+    memory->pos += n;
+    memory->size -= n;
+    return (int)n;
+}
+
+// static input buffers are not usable for parsing before libxml2 2.13, the
+// parser pulls the document from the buffer instead, only the part which is
+// currently parsed is held in the input buffer of libxml2
+static xmlParserCtxtPtr newMemoryCtxt(MemoryInput *memory)
+{
+    return xmlCreateIOParserCtxt(NULL, NULL, readMemory, NULL, memory,
+                                 XML_CHAR_ENCODING_NONE);
+}
+#endif
+
+int Parser_runBuffer(Parser *parser, const char *buffer, size_t size,
+                     Parser_callbackStart start, Parser_callbackEnd end,
+                     Parser_callbackChar onChars)
+{
+    // the size of a libxml2 input buffer is limited to int
+    if (!buffer || size == 0 || size > INT_MAX)
+    {
+        return 1;
+    }
+
+    xmlSAXHandler hdl;
+    initHandler(&hdl, start, end, onChars);
+    xmlInitParser();
+    // the whole document is handed over at once, so the parser runs in one
+    // pass instead of being fed in small chunks through the push interface
+    MemoryInput memory = {buffer, size};
+    xmlParserCtxtPtr ctxt = newMemoryCtxt(&memory);
+    if (!ctxt)
+    {
+        xmlCleanupParser();
+        return 1;
+    }
+    xmlSAXHandlerPtr defaultSax = ctxt->sax;
+    ctxt->sax = &hdl;
+    ctxt->userData = parser->context;
+    parser->bufferCtxt = ctxt;
+    parser->ctxt = ctxt;
+    xmlParseDocument(ctxt);
+    parser->bufferCtxt = NULL;
+    parser->ctxt = NULL;
+    int ret = ctxt->wellFormed && !parser->stopped ? 0 : 1;
+    ctxt->sax = defaultSax;
+    xmlFreeParserCtxt(ctxt);
+    xmlCleanupParser();
+    return ret;
+}
+
+int Parser_runStream(Parser *parser, Parser_callbackRead read,
+                     void *readContext, Parser_callbackStart start,
+                     Parser_callbackEnd end, Parser_callbackChar onChars)
 {
-    char chars[1024];
-    int res = (int)fread(chars, 1, 4, file);
+    char chars[16 * 1024];
+    int res = read(readContext, chars, (int)sizeof(chars));
     if (res <= 0)
     {
         return 1;
     }
 
     xmlSAXHandler hdl;
-    memset(&hdl, 0, sizeof(xmlSAXHandler));
-    hdl.initialized = XML_SAX2_MAGIC;
-    // nodesets are encoded with UTF-8
-    // this code does no transformation on the encoded text or interprets it
-    // so it should be safe to cast xmlChar* to char*
-    hdl.startElementNs = (startElementNsSAX2Func)start;
-    hdl.endElementNs = (endElementNsSAX2Func)end;
-    hdl.characters = (charactersSAXFunc)onChars;
-    xmlInitParser(); // Fix memory leak: https://gitlab.gnome.org/GNOME/libxml2/-/issues/9
+    initHandler(&hdl, start, end, onChars);
+    xmlInitParser();
     xmlParserCtxtPtr ctxt =
         xmlCreatePushParserCtxt(&hdl, parser->context, chars, res, NULL);
-    while ((res = (int)fread(chars, 1, sizeof(chars), file)) > 0)
+    if (!ctxt)
+    {
+        xmlCleanupParser();
+        return 1;
+    }
+    parser->ctxt = ctxt;
+    int ret = 0;
+    while ((res = read(readContext, chars, (int)sizeof(chars))) > 0)
     {
         if (xmlParseChunk(ctxt, chars, res, 0))
         {
-            xmlParserError(ctxt, "xmlParseChunk");
-            return 1;
+            ret = 1;
+            break;
         }
     }
-    xmlParseChunk(ctxt, chars, 0, 1);
+    if (res < 0)
+    {
+        ret = 1;
+    }
+    if (!ret && xmlParseChunk(ctxt, chars, 0, 1))
+    {
+        ret = 1;
+    }
+    if (parser->stopped)
+    {
+        ret = 1;
+    }
+    parser->ctxt = NULL;
     xmlFreeParserCtxt(ctxt);
     xmlCleanupParser();
-    return 0;
+    return ret;
 }
+
+long Parser_position(const Parser *parser)
+{
+    const xmlParserCtxtPtr ctxt = parser->bufferCtxt;
+    // the positions of entities and of converted input don't match the buffer
+    if (!ctxt || ctxt->inputNr != 1 || !ctxt->input->buf ||
+        ctxt->input->buf->encoder)
+    {
+        return -1;
+    }
+    // the input buffer of libxml2 holds the part of the document behind the
+    // consumed bytes
+    return (long)ctxt->input->consumed +
+           (long)(ctxt->input->cur - ctxt->input->base);
+}
+
+void Parser_stop(Parser *parser)
+{
+    parser->stopped = true;
+    if (parser->ctxt)
+    {
+        xmlStopParser(parser->ctxt);
+    }
+}
+
 void Parser_delete(Parser *parser) { free(parser); }
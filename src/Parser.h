@@ -7,6 +7,7 @@
 
 #ifndef PARSER_H
 #define PARSER_H
+#include <stddef.h>
 #include <stdio.h>
 
 struct Parser;
@@ -23,8 +24,30 @@ typedef void (*Parser_callbackEnd)(void *ctx, const char *localname,
 
 typedef void (*Parser_callbackChar)(void *ctx, const char *ch, int len);
 
+// fills buffer with up to len bytes, returns the number of bytes read, 0 at
+// the end of the input and a negative value on errors
+typedef int (*Parser_callbackRead)(void *readContext, char *buffer, int len);
+
+// NULL if memory ran out
 Parser *Parser_new(void *context);
-int Parser_run(Parser *parser, FILE *file, Parser_callbackStart start,
-               Parser_callbackEnd end, Parser_callbackChar onChars);
+// parses a complete document from memory in one pass, the buffer is read in
+// place and has to stay valid until the function returns, documents larger
+// than INT_MAX bytes are rejected and have to be parsed with Parser_runStream
+int Parser_runBuffer(Parser *parser, const char *buffer, size_t size,
+                     Parser_callbackStart start, Parser_callbackEnd end,
+                     Parser_callbackChar onChars);
+// parses a document which is pulled chunk by chunk from a read callback, used
+// for input which is transformed on the fly (e.g. decompressed)
+int Parser_runStream(Parser *parser, Parser_callbackRead read,
+                     void *readContext, Parser_callbackStart start,
+                     Parser_callbackEnd end, Parser_callbackChar onChars);
+// position of the parser in the buffer of Parser_runBuffer, only available
+// from its callbacks, -1 otherwise or if the input is converted to UTF-8. The
+// start callback of an element is called at the '>' or "/>" which closes the
+// start tag, the end callback behind the end tag.
+long Parser_position(const Parser *parser);
+// called from the callbacks to abort parsing, the run function returns an
+// error and no further callbacks are called
+void Parser_stop(Parser *parser);
 void Parser_delete(Parser *parser);
 #endif
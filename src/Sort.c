@@ -6,8 +6,8 @@
  */
 
 #include "Sort.h"
+#include "ObjectPool.h"
 
-#include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,379 +16,701 @@
 
 static const UA_UInt32 NL_HASCOMPONENT_ID = 47;
 
-struct S_Edge
-{
-    struct S_Node *dest;
-    struct S_Edge *next;
-};
-
-typedef struct S_Edge S_Edge;
-
+// nodes are referenced by dense handles (the index in SortContext::nodes),
+// nodes which are only the target of a reference have no data
 struct S_Node
 {
     const UA_NodeId *id;
-    struct S_Node *left, *right;
-    int balance;
-    struct S_Node *qlink;
-    struct S_Edge *edges;
-    size_t edgeCount;
     NL_Node *data;
+    UA_UInt32 hash;
 };
 
 typedef struct S_Node S_Node;
 
-struct SortContext
+struct S_Edge
 {
-    S_Node *head;
-    S_Node *zeros;
-    S_Node *root1;
-    size_t keyCnt;
+    size_t from;
+    size_t to;
+    // the reference which caused the relation and the node it belongs to
+    NL_Reference *ref;
+    size_t owner;
+    // the reference was moved to the non hierachical references to break a
+    // cycle
+    bool demoted;
 };
 
-static S_Node *new_node(const UA_NodeId *id)
-{
-    S_Node *k = (S_Node *)calloc(1, sizeof(S_Node));
-    if(!k)
-        return NULL;
+typedef struct S_Edge S_Edge;
 
-    k->id = id;
-    k->left = k->right = NULL;
-    k->balance = 0;
+struct SortContext
+{
+    S_Node *nodes;
+    size_t nodeCnt;
+    size_t nodeCapacity;
+    // open addressing from the node id to handle + 1, 0 marks a free slot
+    size_t *index;
+    size_t indexCapacity;
+    S_Edge *edges;
+    size_t edgeCnt;
+    size_t edgeCapacity;
+    // references to the parent node which are added to instance nodes
+    ObjectPool *refPool;
+    Sort_TargetFilter filter;
+    const void *filterContext;
+    // a node couldn't be added completely, the graph misses edges
+    bool outOfMemory;
+};
 
-    k->edgeCount = 0;
-    k->qlink = NULL;
-    k->edges = NULL;
-    k->data = NULL;
-    return k;
+static void *growArray(void *array, size_t *capacity, size_t elementSize)
+{
+    size_t newCapacity = *capacity ? *capacity * 2 : 1024;
+    void *newArray = realloc(array, newCapacity * elementSize);
+    if (newArray)
+    {
+        *capacity = newCapacity;
+    }
+    return newArray;
 }
 
-static S_Node *
-search_node(S_Node *rootNode, const UA_NodeId *nodeId) {
-    if(!rootNode)
-        return NULL;
-
-    S_Node *p, *q, *r, *s, *t;
-
-    if(rootNode->right == NULL)
-        return (rootNode->right = new_node(nodeId));
-
-    t = rootNode;
-    s = p = rootNode->right;
-
-    while (true) {
-        UA_Order a = UA_NodeId_order(nodeId, p->id);
-        if (a == UA_ORDER_EQ)
-            return p;
-
-        if (a == UA_ORDER_LESS)
-            q = p->left;
-        else
-            q = p->right;
-
-        if (q == NULL) {
-            q = new_node(nodeId);
-            if (a == UA_ORDER_LESS)
-                p->left = q;
-            else
-                p->right = q;
-
-            assert(!UA_NodeId_equal(nodeId, s->id));
-            if(UA_NodeId_order(nodeId, s->id) == UA_ORDER_LESS) {
-                r = p = s->left;
-                a = UA_ORDER_LESS;
-            } else {
-                r = p = s->right;
-                a = UA_ORDER_MORE;
-            }
-
-            while (p != q) {
-                if (p) {
-                    assert(!UA_NodeId_equal(nodeId, p->id));
-                    if (UA_NodeId_order(nodeId, p->id) == UA_ORDER_LESS) {
-                        p->balance = -1;
-                        p = p->left;
-                    } else {
-                        p->balance = 1;
-                        p = p->right;
-                    }
-                }
-            }
-
-            if (s->balance == 0 || s->balance == -a) {
-                s->balance += a;
-                return q;
-            }
-
-            if (r) {
-                if (r->balance == a) {
-                    p = r;
-                    if (a == UA_ORDER_LESS) {
-                        s->left = r->right;
-                        r->right = s;
-                    } else {
-                        s->right = r->left;
-                        r->left = s;
-                    }
-                    s->balance = r->balance = 0;
-                } else {
-                    if (a == UA_ORDER_LESS) {
-                        if (r->right) {
-                            p = r->right;
-                            r->right = p->left;
-                            p->left = r;
-                            s->left = p->right;
-                            p->right = s;
-                        }
-                    } else {
-                        if (r->left) {
-                            p = r->left;
-                            r->left = p->right;
-                            p->right = r;
-                            s->right = p->left;
-                            p->left = s;
-                        }
-                    }
-
-                    s->balance = 0;
-                    r->balance = 0;
-                    if (p) {
-                        if (p->balance == a)
-                            s->balance = -a;
-                        else if (p->balance == -a)
-                            r->balance = a;
-                        p->balance = 0;
-                    }
-                }
-            }
+static bool rehash(SortContext *ctx)
+{
+    size_t capacity = ctx->indexCapacity ? ctx->indexCapacity * 2 : 2048;
+    size_t *index = (size_t *)calloc(capacity, sizeof(size_t));
+    if (!index)
+    {
+        return false;
+    }
+    size_t mask = capacity - 1;
+    for (size_t handle = 0; handle < ctx->nodeCnt; handle++)
+    {
+        size_t pos = ctx->nodes[handle].hash & mask;
+        while (index[pos])
+        {
+            pos = (pos + 1) & mask;
+        }
+        index[pos] = handle + 1;
+    }
+    free(ctx->index);
+    ctx->index = index;
+    ctx->indexCapacity = capacity;
+    return true;
+}
 
-            if (s == t->right)
-                t->right = p;
-            else
-                t->left = p;
-            return q;
+// looks up the handle of a node id, unknown ids get a new handle
+static bool getHandle(SortContext *ctx, const UA_NodeId *id, size_t *handle)
+{
+    if ((ctx->nodeCnt + 1) * 2 > ctx->indexCapacity && !rehash(ctx))
+    {
+        return false;
+    }
+    UA_UInt32 hash = UA_NodeId_hash(id);
+    size_t mask = ctx->indexCapacity - 1;
+    size_t pos = hash & mask;
+    while (ctx->index[pos])
+    {
+        const S_Node *n = &ctx->nodes[ctx->index[pos] - 1];
+        if (n->hash == hash && UA_NodeId_equal(n->id, id))
+        {
+            *handle = ctx->index[pos] - 1;
+            return true;
+        }
+        pos = (pos + 1) & mask;
+    }
+    if (ctx->nodeCnt == ctx->nodeCapacity)
+    {
+        S_Node *nodes = (S_Node *)growArray(ctx->nodes, &ctx->nodeCapacity,
+                                            sizeof(S_Node));
+        if (!nodes)
+        {
+            return false;
         }
+        ctx->nodes = nodes;
+    }
+    S_Node *n = &ctx->nodes[ctx->nodeCnt];
+    n->id = id;
+    n->data = NULL;
+    n->hash = hash;
+    ctx->index[pos] = ctx->nodeCnt + 1;
+    *handle = ctx->nodeCnt++;
+    return true;
+}
 
-        if (q->balance) {
-            t = p;
-            s = q;
+static bool record_relation(SortContext *ctx, size_t from, size_t to,
+                            NL_Reference *ref, size_t owner)
+{
+    if (from == to)
+    {
+        return true;
+    }
+    if (ctx->edgeCnt == ctx->edgeCapacity)
+    {
+        S_Edge *edges = (S_Edge *)growArray(ctx->edges, &ctx->edgeCapacity,
+                                            sizeof(S_Edge));
+        if (!edges)
+        {
+            return false;
         }
+        ctx->edges = edges;
+    }
+    S_Edge *e = &ctx->edges[ctx->edgeCnt++];
+    e->from = from;
+    e->to = to;
+    e->ref = ref;
+    e->owner = owner;
+    e->demoted = false;
+    return true;
+}
 
-        p = q;
+SortContext *Sort_init(void)
+{
+    SortContext *ctx = (SortContext *)calloc(1, sizeof(SortContext));
+    if (!ctx)
+    {
+        return NULL;
+    }
+    ctx->refPool = ObjectPool_new(sizeof(NL_Reference), 1000);
+    if (!ctx->refPool)
+    {
+        free(ctx);
+        return NULL;
     }
+    return ctx;
 }
 
-static void
-record_relation(S_Node *from, S_Node *to) {
-    if(UA_NodeId_equal(from->id, to->id))
+void Sort_cleanup(SortContext *ctx)
+{
+    if (!ctx)
+    {
         return;
+    }
+    free(ctx->nodes);
+    free(ctx->index);
+    free(ctx->edges);
+    ObjectPool_delete(ctx->refPool);
+    free(ctx);
+}
 
-    struct S_Edge *e = (S_Edge *)calloc(1, sizeof(S_Edge));
-    if(!e)
-        return;
+void Sort_setTargetFilter(SortContext *ctx, Sort_TargetFilter filter,
+                          const void *context)
+{
+    ctx->filter = filter;
+    ctx->filterContext = context;
+}
 
-    to->edgeCount++;
-    e->dest = to;
-    e->next = from->edges;
-    from->edges = e;
+static bool isSortedTarget(const SortContext *ctx, const UA_NodeId *target)
+{
+    return !ctx->filter || ctx->filter(ctx->filterContext, target);
 }
 
-static bool count_items(SortContext *ctx, S_Node *unused)
+// records the edges of the hierachical references of the node with handle j
+static bool addRelations(SortContext *ctx, NL_Node *data, size_t j)
 {
-    ctx->keyCnt++;
-    return false;
+    NL_Reference *hierachicalRef = data->hierachicalRefs;
+    while (hierachicalRef)
+    {
+        if (!isSortedTarget(ctx, &hierachicalRef->target))
+        {
+            hierachicalRef = hierachicalRef->next;
+            continue;
+        }
+        size_t k = 0;
+        if (!getHandle(ctx, &hierachicalRef->target, &k))
+        {
+            return false;
+        }
+        bool recorded = hierachicalRef->isForward
+                            ? record_relation(ctx, j, k, hierachicalRef, j)
+                            : record_relation(ctx, k, j, hierachicalRef, j);
+        if (!recorded)
+        {
+            return false;
+        }
+        hierachicalRef = hierachicalRef->next;
+    }
+    // add reference generated by ParentNodeId, if dont have already a hierachical ref
+    const UA_NodeId *parentId = Sort_missingParentId(data);
+    if (parentId && !isSortedTarget(ctx, parentId))
+    {
+        return Sort_addParentReference(ctx->refPool, data, NULL);
+    }
+    else if (parentId)
+    {
+        size_t k = 0;
+        if (!getHandle(ctx, parentId, &k) ||
+            !Sort_addParentReference(ctx->refPool, data, ctx->nodes[k].data))
+        {
+            return false;
+        }
+        // the parent has to be added before the node like for any other
+        // hierachical reference
+        NL_Reference *parentRef = data->hierachicalRefs;
+        return parentRef->isForward
+                   ? record_relation(ctx, j, k, parentRef, j)
+                   : record_relation(ctx, k, j, parentRef, j);
+    }
+    return true;
 }
 
-static bool scan_zeros(SortContext *ctx, S_Node *k)
+bool Sort_addNode(SortContext *ctx, NL_Node *data)
 {
-    if (k->edgeCount == 0 && k->id)
+    size_t j = 0;
+    // add node, no matter if there are references on it
+    if (!getHandle(ctx, &data->id, &j))
     {
-        if (ctx->head == NULL)
-            ctx->head = k;
-        else
-            ctx->zeros->qlink = k;
+        ctx->outOfMemory = true;
+        return false;
+    }
+    // entry already exists
+    if (ctx->nodes[j].data != NULL)
+    {
+        return false;
+    }
+    ctx->nodes[j].data = data;
+    // the id of a placeholder may point to the reference of another node
+    ctx->nodes[j].id = &data->id;
+    if (!addRelations(ctx, data, j))
+    {
+        // the graph misses edges of the node, it can't be sorted
+        ctx->outOfMemory = true;
+        return false;
+    }
+    return true;
+}
 
-        ctx->zeros = k;
+const UA_NodeId *Sort_missingParentId(const NL_Node *node)
+{
+    if (node->hierachicalRefs || !NodesetLoader_isInstanceNode(node))
+    {
+        return NULL;
+    }
+    const NL_InstanceNode *instanceNode = (const NL_InstanceNode *)node;
+    if (UA_NodeId_equal(&instanceNode->parentNodeId, &UA_NODEID_NULL))
+    {
+        return NULL;
     }
+    return &instanceNode->parentNodeId;
+}
 
-    return false;
+bool Sort_addParentReference(ObjectPool *refPool, NL_Node *node,
+                             const NL_Node *parent)
+{
+    //to we already have a reference for the node parentNode?
+    //parent references
+    if (parent) {
+        NL_Reference *r = parent->hierachicalRefs;
+        while (r) {
+            if (UA_NodeId_equal(&r->target, &node->id))
+            {
+                NL_Reference *newRef =
+                    (NL_Reference *)ObjectPool_alloc(refPool);
+                if (!newRef)
+                {
+                    return false;
+                }
+                newRef->isForward = !r->isForward;
+                UA_NodeId_copy(&parent->id, &newRef->target);
+                UA_NodeId_copy(&r->refType, &newRef->refType);
+                newRef->next = node->hierachicalRefs;
+                node->hierachicalRefs = newRef;
+                return true;
+            }
+            r = r->next;
+        }
+    }
+    NL_Reference *newRef = (NL_Reference *)ObjectPool_alloc(refPool);
+    if (!newRef)
+    {
+        return false;
+    }
+    newRef->isForward = false;
+    UA_NodeId_copy(&((const NL_InstanceNode *)node)->parentNodeId,
+                   &newRef->target);
+    newRef->refType = UA_NODEID_NUMERIC(0, NL_HASCOMPONENT_ID);
+    newRef->next = node->hierachicalRefs;
+    node->hierachicalRefs = newRef;
+    return true;
 }
 
-static bool recurse_tree(SortContext *ctx, S_Node *rootNode,
-                         bool (*action)(SortContext *ctx, S_Node *))
+// state of Kahn's algorithm, the edges are in compressed sparse row format:
+// the outgoing edges of node i are edges[rows[offsets[i]]] ..
+// edges[rows[offsets[i + 1] - 1]]
+typedef struct
+{
+    size_t *inDegree;
+    size_t *offsets;
+    size_t *rows;
+    size_t *queue;
+    size_t head;
+    size_t tail;
+    size_t level;
+    size_t levelEnd;
+} SortState;
+
+static bool initState(const SortContext *ctx, SortState *s)
 {
-    if (rootNode->left == NULL && rootNode->right == NULL)
-        return (*action)(ctx, rootNode);
-    else
+    size_t n = ctx->nodeCnt;
+    memset(s, 0, sizeof(SortState));
+    s->inDegree = (size_t *)calloc(n + 1, sizeof(size_t));
+    s->offsets = (size_t *)calloc(n + 1, sizeof(size_t));
+    s->rows = (size_t *)malloc((ctx->edgeCnt + 1) * sizeof(size_t));
+    s->queue = (size_t *)malloc((n + 1) * sizeof(size_t));
+    if (!s->inDegree || !s->offsets || !s->rows || !s->queue)
     {
-        if (rootNode->left != NULL)
-            if (recurse_tree(ctx, rootNode->left, action))
-                return true;
-        if ((*action)(ctx, rootNode))
-            return true;
-        if (rootNode->right != NULL)
-            if (recurse_tree(ctx, rootNode->right, action))
-                return true;
+        return false;
+    }
+    for (size_t i = 0; i < ctx->edgeCnt; i++)
+    {
+        s->offsets[ctx->edges[i].from + 1]++;
+        s->inDegree[ctx->edges[i].to]++;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        s->offsets[i + 1] += s->offsets[i];
+    }
+    // offsets[i] is advanced to the end of the row i while filling
+    for (size_t i = 0; i < ctx->edgeCnt; i++)
+    {
+        s->rows[s->offsets[ctx->edges[i].from]++] = i;
     }
+    for (size_t i = n; i > 0; i--)
+    {
+        s->offsets[i] = s->offsets[i - 1];
+    }
+    s->offsets[0] = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (s->inDegree[i] == 0)
+        {
+            s->queue[s->tail++] = i;
+        }
+    }
+    s->levelEnd = s->tail;
+    return true;
+}
 
-    return false;
+static void cleanupState(SortState *s)
+{
+    free(s->inDegree);
+    free(s->offsets);
+    free(s->rows);
+    free(s->queue);
 }
 
-static void walk_tree(SortContext *ctx, S_Node *rootNode,
-                      bool (*action)(SortContext *ctx, S_Node *))
+static void releaseEdge(SortState *s, size_t to)
 {
-    if (rootNode->right)
-        recurse_tree(ctx, rootNode->right, action);
+    if (--s->inDegree[to] == 0)
+    {
+        s->queue[s->tail++] = to;
+    }
 }
 
-SortContext *Sort_init(void)
+// The queue is processed in wavefronts: a node is enqueued when its last
+// predecessor is dequeued, so all nodes enqueued while processing one level
+// belong to the next level.
+// false if the callback failed
+static bool drainQueue(const SortContext *ctx, SortState *s,
+                       struct Nodeset *nodeset,
+                       Sort_SortedNodeCallback callback)
 {
-    SortContext *ctx = (SortContext *)calloc(1, sizeof(SortContext));
-    ctx->root1 = new_node(NULL);
-    return ctx;
+    while (s->head < s->tail)
+    {
+        if (s->head == s->levelEnd)
+        {
+            s->level++;
+            s->levelEnd = s->tail;
+        }
+        size_t handle = s->queue[s->head++];
+        if (ctx->nodes[handle].data != NULL &&
+            !callback(nodeset, ctx->nodes[handle].data, s->level))
+        {
+            return false;
+        }
+        for (size_t i = s->offsets[handle]; i < s->offsets[handle + 1]; i++)
+        {
+            const S_Edge *e = &ctx->edges[s->rows[i]];
+            if (!e->demoted)
+            {
+                releaseEdge(s, e->to);
+            }
+        }
+    }
+    return true;
 }
 
-static void cleanupEdges(S_Edge *e)
+static void appendNodeId(char **buf, size_t *len, const UA_NodeId *id)
 {
-    S_Edge *tmp = e;
-    while (tmp)
+    UA_String idStr = {0};
+    UA_NodeId_print(id, &idStr);
+    char *tmp = (char *)realloc(*buf, *len + idStr.length + 3);
+    if (tmp)
     {
-        S_Edge *next = tmp->next;
-        free(tmp);
-        tmp = next;
+        if (*len > 0)
+        {
+            memcpy(tmp + *len, ", ", 2);
+            *len += 2;
+        }
+        if (idStr.length > 0)
+        {
+            memcpy(tmp + *len, idStr.data, idStr.length);
+        }
+        *len += idStr.length;
+        tmp[*len] = '\0';
+        *buf = tmp;
     }
+    UA_String_clear(&idStr);
 }
 
-static void cleanupSubtree(S_Node *n)
+static void logCycle(const SortContext *ctx, NodesetLoader_Logger *logger,
+                     const size_t *members, size_t memberCnt,
+                     const S_Edge *demoted)
 {
-    if (!n)
+    if (!logger)
     {
         return;
     }
-    cleanupSubtree(n->left);
-    cleanupSubtree(n->right);
-    cleanupEdges(n->edges);
-    free(n);
+    char *ids = NULL;
+    size_t len = 0;
+    for (size_t i = 0; i < memberCnt; i++)
+    {
+        appendNodeId(&ids, &len, ctx->nodes[members[i]].id);
+    }
+    char *ref = NULL;
+    size_t refLen = 0;
+    appendNodeId(&ref, &refLen, ctx->nodes[demoted->owner].id);
+    appendNodeId(&ref, &refLen, &demoted->ref->target);
+    logger->log(logger->context, NODESETLOADER_LOGLEVEL_WARNING,
+                "hierachical references form a cycle: %s; the reference "
+                "(source, target: %s) is added after the nodes",
+                ids ? ids : "", ref ? ref : "");
+    free(ids);
+    free(ref);
 }
 
-void Sort_cleanup(SortContext *ctx)
+// references which don't define the parent of their node are demoted first
+static int demotionRank(const SortContext *ctx, const S_Edge *e)
 {
-    if (ctx->root1)
+    if (e->ref->isForward)
     {
-        cleanupSubtree(ctx->root1);
+        return 2;
     }
-    free(ctx);
+    const NL_Node *owner = ctx->nodes[e->owner].data;
+    for (const NL_Reference *r = owner->hierachicalRefs; r; r = r->next)
+    {
+        if (r != e->ref && !r->isForward)
+        {
+            return 1;
+        }
+    }
+    if (NodesetLoader_isInstanceNode(owner) &&
+        !UA_NodeId_equal(&((const NL_InstanceNode *)owner)->parentNodeId,
+                         &UA_NODEID_NULL))
+    {
+        return 1;
+    }
+    return 0;
 }
 
-bool Sort_addNode(SortContext *ctx, NL_Node *data) {
-    S_Node *j = NULL;
-    // add node, no matter if there are references on it
-    j = search_node(ctx->root1, &data->id);
-    // entry already exists
-    if(j->data!=NULL)
+static void demoteReference(NL_Node *owner, NL_Reference *ref)
+{
+    NL_Reference **r = &owner->hierachicalRefs;
+    while (*r && *r != ref)
     {
-        return false;
+        r = &(*r)->next;
     }
-    j->data = data;
-    NL_Reference *hierachicalRef = data->hierachicalRefs;
-    bool hierachicalRefRecorded = false;
-    if (hierachicalRef) {
-        while (hierachicalRef) {
-            S_Node *k = search_node(ctx->root1, &hierachicalRef->target);
-            if (!hierachicalRef->isForward) {
-                record_relation(k, j);
-            } else {
-                record_relation(j, k);
+    if (*r)
+    {
+        *r = ref->next;
+        ref->next = owner->nonHierachicalRefs;
+        owner->nonHierachicalRefs = ref;
+    }
+}
+
+// breaks the cycles of a strongly connected component: the relation with the
+// highest rank (the last one added on ties) is removed and all references
+// causing it are demoted to non hierachical references
+static bool breakComponent(SortContext *ctx, SortState *s,
+                           const size_t *members, size_t memberCnt,
+                           const size_t *component, size_t componentId,
+                           NodesetLoader_Logger *logger)
+{
+    size_t best = ctx->edgeCnt;
+    int bestRank = -1;
+    for (size_t m = 0; m < memberCnt; m++)
+    {
+        size_t v = members[m];
+        for (size_t i = s->offsets[v]; i < s->offsets[v + 1]; i++)
+        {
+            const S_Edge *e = &ctx->edges[s->rows[i]];
+            if (e->demoted || component[e->to] != componentId)
+            {
+                continue;
+            }
+            int rank = demotionRank(ctx, e);
+            if (rank > bestRank || (rank == bestRank && s->rows[i] > best))
+            {
+                best = s->rows[i];
+                bestRank = rank;
             }
-            hierachicalRef = hierachicalRef->next;
-            hierachicalRefRecorded = true;
         }
     }
-    // add reference generated by ParentNodeId, if dont have already a hierachical ref
-    if (!hierachicalRefRecorded && NodesetLoader_isInstanceNode(data)) {
-        NL_InstanceNode *instanceNode = (NL_InstanceNode *)data;
-        if(UA_NodeId_equal(&instanceNode->parentNodeId, &UA_NODEID_NULL))
+    if (best == ctx->edgeCnt)
+    {
+        return false;
+    }
+    logCycle(ctx, logger, members, memberCnt, &ctx->edges[best]);
+    size_t from = ctx->edges[best].from;
+    size_t to = ctx->edges[best].to;
+    for (size_t i = s->offsets[from]; i < s->offsets[from + 1]; i++)
+    {
+        S_Edge *e = &ctx->edges[s->rows[i]];
+        if (e->to == to && !e->demoted)
         {
-            return true;
+            e->demoted = true;
+            demoteReference(ctx->nodes[e->owner].data, e->ref);
+            releaseEdge(s, to);
         }
+    }
+    return true;
+}
 
-        S_Node *k = search_node(ctx->root1, &instanceNode->parentNodeId);
-        
-        //to we already have a reference for the node parentNode?
-        //parent references
-        bool refTypeFound = false;
-        if (k->data) {
-            NL_Reference *r = k->data->hierachicalRefs;
-            while (r) {
-                if (UA_NodeId_equal(&r->target, &data->id)) 
+// iterative Tarjan on the nodes which are not sorted yet, every strongly
+// connected component with more than one node contains a cycle
+static bool breakCycles(SortContext *ctx, SortState *s,
+                        NodesetLoader_Logger *logger)
+{
+    size_t n = ctx->nodeCnt;
+    const size_t unvisited = (size_t)-1;
+    size_t *index = (size_t *)malloc((n + 1) * sizeof(size_t));
+    size_t *lowlink = (size_t *)malloc((n + 1) * sizeof(size_t));
+    size_t *component = (size_t *)malloc((n + 1) * sizeof(size_t));
+    size_t *nextEdge = (size_t *)malloc((n + 1) * sizeof(size_t));
+    size_t *stack = (size_t *)malloc((n + 1) * sizeof(size_t));
+    size_t *callStack = (size_t *)malloc((n + 1) * sizeof(size_t));
+    bool ok = index && lowlink && component && nextEdge && stack && callStack;
+    bool broken = false;
+    if (ok)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            index[i] = unvisited;
+            component[i] = unvisited;
+        }
+        size_t counter = 0;
+        size_t componentCnt = 0;
+        size_t sp = 0;
+        for (size_t root = 0; root < n; root++)
+        {
+            if (s->inDegree[root] == 0 || index[root] != unvisited)
+            {
+                continue;
+            }
+            size_t csp = 0;
+            index[root] = lowlink[root] = counter++;
+            nextEdge[root] = s->offsets[root];
+            stack[sp++] = root;
+            callStack[csp++] = root;
+            while (csp > 0)
+            {
+                size_t v = callStack[csp - 1];
+                if (nextEdge[v] < s->offsets[v + 1])
+                {
+                    const S_Edge *e = &ctx->edges[s->rows[nextEdge[v]++]];
+                    size_t w = e->to;
+                    if (e->demoted || s->inDegree[w] == 0)
+                    {
+                        continue;
+                    }
+                    if (index[w] == unvisited)
+                    {
+                        index[w] = lowlink[w] = counter++;
+                        nextEdge[w] = s->offsets[w];
+                        stack[sp++] = w;
+                        callStack[csp++] = w;
+                    }
+                    else if (component[w] == unvisited &&
+                             index[w] < lowlink[v])
+                    {
+                        // w is still on the stack
+                        lowlink[v] = index[w];
+                    }
+                    continue;
+                }
+                csp--;
+                if (csp > 0 && lowlink[v] < lowlink[callStack[csp - 1]])
+                {
+                    lowlink[callStack[csp - 1]] = lowlink[v];
+                }
+                if (lowlink[v] != index[v])
+                {
+                    continue;
+                }
+                size_t begin = sp;
+                do
+                {
+                    begin--;
+                    component[stack[begin]] = componentCnt;
+                } while (stack[begin] != v);
+                if (sp - begin > 1 &&
+                    breakComponent(ctx, s, stack + begin, sp - begin,
+                                   component, componentCnt, logger))
                 {
-                    NL_Reference *newRef = (NL_Reference *)calloc(1, sizeof(NL_Reference));
-                    newRef->isForward = !r->isForward;
-                    UA_NodeId_copy(&k->data->id, &newRef->target);
-                    UA_NodeId_copy(&r->refType, &newRef->refType);
-                    newRef->next = data->hierachicalRefs;
-                    data->hierachicalRefs = newRef;
-                    refTypeFound = true;
-                    break;
+                    broken = true;
                 }
-                r = r->next;
+                sp = begin;
+                componentCnt++;
             }
         }
-        if(!refTypeFound)
-        {
-            NL_Reference *newRef =
-            (NL_Reference *)calloc(1, sizeof(NL_Reference));
-            newRef->isForward = false;
-            UA_NodeId_copy(&instanceNode->parentNodeId, &newRef->target);
-            newRef->refType = UA_NODEID_NUMERIC(0, NL_HASCOMPONENT_ID);
-            newRef->next = data->hierachicalRefs;
-            data->hierachicalRefs = newRef;
-        }
     }
-    return true;
+    free(index);
+    free(lowlink);
+    free(component);
+    free(nextEdge);
+    free(stack);
+    free(callStack);
+    return ok && broken;
 }
 
 bool Sort_start(SortContext *ctx, struct Nodeset *nodeset,
                 Sort_SortedNodeCallback callback, NodesetLoader_Logger *logger)
 {
-    walk_tree(ctx, ctx->root1, count_items);
-
-    while (ctx->keyCnt > 0)
+    if (ctx->outOfMemory)
     {
-        walk_tree(ctx, ctx->root1, scan_zeros);
-
-        while (ctx->head)
+        if (logger)
         {
-            S_Edge *e = ctx->head->edges;
-
-            if (ctx->head->data != NULL)
-            {
-                callback(nodeset, ctx->head->data);
-            }
-
-            ctx->head->id = NULL;
-            ctx->keyCnt--;
-
-            while (e)
+            logger->log(logger->context, NODESETLOADER_LOGLEVEL_ERROR,
+                        "nodes couldn't be added to the sort, out of memory");
+        }
+        return false;
+    }
+    SortState s;
+    bool ok = initState(ctx, &s);
+    bool drained = ok && drainQueue(ctx, &s, nodeset, callback);
+    if (ok)
+    {
+        // nodes which are left are part of a cycle or depend on one
+        while (drained && s.tail < ctx->nodeCnt)
+        {
+            if (!breakCycles(ctx, &s, logger))
             {
-                e->dest->edgeCount--;
-                if (e->dest->edgeCount == 0)
+                if (logger)
                 {
-                    ctx->zeros->qlink = e->dest;
-                    ctx->zeros = e->dest;
+                    logger->log(logger->context, NODESETLOADER_LOGLEVEL_ERROR,
+                                "graph contains a loop, abort");
                 }
-                e = e->next;
+                ok = false;
+                break;
             }
-            ctx->head = ctx->head->qlink;
+            drained = drainQueue(ctx, &s, nodeset, callback);
         }
-        if (ctx->keyCnt > 0)
+        if (!drained)
         {
             if (logger)
             {
                 logger->log(logger->context, NODESETLOADER_LOGLEVEL_ERROR,
-                            "graph contains a loop, abort");
+                            "sorted nodes couldn't be added, out of memory");
             }
-            return false;
+            ok = false;
         }
     }
-    return true;
+    cleanupState(&s);
+    return ok;
 }
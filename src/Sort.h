@@ -19,11 +19,32 @@ struct NL_Node;
 struct Nodeset;
 struct SortContext;
 struct NodesetLoader_Logger;
+struct ObjectPool;
 typedef struct SortContext SortContext;
 SortContext* Sort_init(void);
 void Sort_cleanup(SortContext * ctx);
+// false for duplicates and if memory ran out, Sort_start fails in the latter
+// case
 bool Sort_addNode(SortContext* ctx, struct NL_Node *node);
-typedef void (*Sort_SortedNodeCallback)(struct Nodeset *nodeset, struct NL_Node *node);
+// returns false for reference targets which are satisfied without sorting,
+// e.g. nodes which exist before the import, they get no entry in the graph
+typedef bool (*Sort_TargetFilter)(const void *context, const UA_NodeId *target);
+// has to be set before the first node is added
+void Sort_setTargetFilter(SortContext *ctx, Sort_TargetFilter filter,
+                          const void *context);
+// parent of an instance node which has no hierachical references, the sorting
+// algorithm adds a reference to it, NULL if no reference is needed
+const UA_NodeId *Sort_missingParentId(const struct NL_Node *node);
+// adds the reference to the parent, the reference type is taken from the
+// reference of the parent to the node if parent is known, false if memory
+// ran out
+bool Sort_addParentReference(struct ObjectPool *refPool, struct NL_Node *node,
+                             const struct NL_Node *parent);
+// level is the dependency depth of the node, the nodes of one level don't
+// depend on each other and are reported after all nodes of lower levels,
+// returning false aborts the sort, e.g. if memory ran out
+typedef bool (*Sort_SortedNodeCallback)(struct Nodeset *nodeset,
+                                        struct NL_Node *node, size_t level);
 bool Sort_start(SortContext* ctx, struct Nodeset *nodeset, Sort_SortedNodeCallback callback, struct NodesetLoader_Logger* logger);
 
 #ifdef __cplusplus
@@ -6,45 +6,103 @@
  */
 
 #include "Value.h"
-#include <stdlib.h>
 #include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
 
-NL_Value *Value_new(const NL_Node *node)
+#define MEMBERS_INITIAL_CAPACITY 4
+
+NL_Value *Value_new(Arena *arena, NL_ParserCtx *ctx)
 {
-    NL_Value *newValue = (NL_Value *)calloc(1, sizeof(NL_Value));
-    newValue->ctx = (NL_ParserCtx *)calloc(1, sizeof(NL_ParserCtx));
-    newValue->ctx->state = PARSERSTATE_INIT;
+    NL_Value *newValue = (NL_Value *)Arena_alloc(arena, sizeof(NL_Value));
+    if (!newValue)
+    {
+        return NULL;
+    }
+    ctx->state = PARSERSTATE_INIT;
+    ctx->currentData = NULL;
+    ctx->arena = arena;
+    newValue->ctx = ctx;
+    return newValue;
+}
+
+NL_Value *Value_newLazy(NL_ParserCtx *ctx, const char *xml, size_t size)
+{
+    NL_Value *newValue = (NL_Value *)Arena_alloc(ctx->arena, sizeof(NL_Value));
+    char *copy = (char *)Arena_alloc(ctx->arena, size + 1);
+    if (!newValue || !copy)
+    {
+        return NULL;
+    }
+    memcpy(copy, xml, size);
+    newValue->xml = copy;
+    newValue->xmlSize = size;
+    newValue->ctx = ctx;
     return newValue;
 }
 
-static NL_Data *newData(const char *name, NL_DataType type)
+static NL_Data *newData(Arena *arena, const char *name, NL_DataType type)
 {
-    NL_Data *newData = (NL_Data *)calloc(1, sizeof(NL_Data));
+    NL_Data *newData = (NL_Data *)Arena_alloc(arena, sizeof(NL_Data));
+    if (!newData)
+    {
+        return NULL;
+    }
     newData->type = type;
     newData->name = name;
     return newData;
 }
 
-static NL_Data *addNewMember(NL_Data *parent, const char *name)
+// the capacity of the members array is not stored, it is the next power of 2
+// of the number of members, so the array is grown when its size reaches one
+static bool isFull(size_t membersSize)
 {
+    return membersSize == 0 || (membersSize >= MEMBERS_INITIAL_CAPACITY &&
+                                (membersSize & (membersSize - 1)) == 0);
+}
+
+static NL_Data *addNewMember(Arena *arena, NL_Data *parent, const char *name)
+{
+    NL_ComplexData *complex = &parent->val.complexData;
     parent->type = DATATYPE_COMPLEX;
-    parent->val.complexData.members = (NL_Data **)realloc(
-        parent->val.complexData.members,
-        (parent->val.complexData.membersSize + 1) * sizeof(NL_Data *));
+    if (isFull(complex->membersSize))
+    {
+        size_t capacity = complex->membersSize > 0
+                              ? complex->membersSize * 2
+                              : MEMBERS_INITIAL_CAPACITY;
+        // the old array stays in the arena, this wastes at most as much
+        // memory as the final array needs
+        NL_Data **members =
+            (NL_Data **)Arena_alloc(arena, capacity * sizeof(NL_Data *));
+        if (!members)
+        {
+            return NULL;
+        }
+        if (complex->membersSize > 0)
+        {
+            memcpy(members, complex->members,
+                   complex->membersSize * sizeof(NL_Data *));
+        }
+        complex->members = members;
+    }
 
-    NL_Data *newData = (NL_Data *)calloc(1, sizeof(NL_Data));
-    parent->val.complexData.members[parent->val.complexData.membersSize] =
-        newData;
+    NL_Data *newData = (NL_Data *)Arena_alloc(arena, sizeof(NL_Data));
+    if (!newData)
+    {
+        return NULL;
+    }
+    complex->members[complex->membersSize] = newData;
 
-    parent->val.complexData.membersSize++;
+    complex->membersSize++;
     newData->type = DATATYPE_PRIMITIVE;
     newData->name = name;
     newData->parent = parent;
     return newData;
 }
 
-void Value_start(NL_Value *val, const char *name)
+bool Value_start(NL_Value *val, const char *name)
 {
+    NL_Data *data = NULL;
     switch (val->ctx->state)
     {
     case PARSERSTATE_INIT:
@@ -52,19 +110,20 @@ void Value_start(NL_Value *val, const char *name)
         {
             val->ctx->state = PARSERSTATE_LISTOF;
             val->isArray = true;
-            val->data = newData(name, DATATYPE_COMPLEX);
-            val->ctx->currentData = val->data;
+            data = newData(val->ctx->arena, name, DATATYPE_COMPLEX);
+            val->data = data;
         }
         else if (!strcmp(name, "ExtensionObject"))
         {
             val->ctx->state = PARSERSTATE_EXTENSIONOBJECT;
             val->isExtensionObject = true;
+            return true;
         }
         else
         {
             val->type = name;
-            val->data = newData(name, DATATYPE_PRIMITIVE);
-            val->ctx->currentData = val->data;
+            data = newData(val->ctx->arena, name, DATATYPE_PRIMITIVE);
+            val->data = data;
             val->ctx->state = PARSERSTATE_DATA;
         }
         break;
@@ -74,61 +133,60 @@ void Value_start(NL_Value *val, const char *name)
         {
             val->ctx->state = PARSERSTATE_EXTENSIONOBJECT;
             val->isExtensionObject = true;
-            break;
+            return true;
         }
         val->ctx->state = PARSERSTATE_DATA;
-        {
-            val->type = name;
-            NL_Data *newData = addNewMember(val->ctx->currentData, name);
-            val->ctx->currentData = newData;
-        }
-
+        val->type = name;
+        data = addNewMember(val->ctx->arena, val->ctx->currentData, name);
         break;
 
     case PARSERSTATE_EXTENSIONOBJECT:
         if (!strcmp(name, "TypeId"))
         {
             val->ctx->state = PARSERSTATE_EXTENSIONOBJECT_TYPEID;
-            break;
         }
-        if (!strcmp(name, "Body"))
+        else if (!strcmp(name, "Body"))
         {
             val->ctx->state = PARSERSTATE_EXTENSIONOBJECT_BODY;
         }
-        break;
+        return true;
     case PARSERSTATE_EXTENSIONOBJECT_BODY:
         val->ctx->state = PARSERSTATE_DATA;
         if (!val->ctx->currentData)
         {
-            val->data = newData(name, DATATYPE_COMPLEX);
-            val->ctx->currentData = val->data;
+            data = newData(val->ctx->arena, name, DATATYPE_COMPLEX);
+            val->data = data;
         }
         else
         {
-            NL_Data *newData = addNewMember(val->ctx->currentData, name);
-            val->ctx->currentData = newData;
+            data = addNewMember(val->ctx->arena, val->ctx->currentData, name);
         }
         break;
 
     case PARSERSTATE_EXTENSIONOBJECT_TYPEID:
-        break;
+        return true;
 
     case PARSERSTATE_DATA:
         if (!val->ctx->currentData)
         {
-            val->data = newData(name, DATATYPE_PRIMITIVE);
-            val->ctx->currentData = val->data;
+            data = newData(val->ctx->arena, name, DATATYPE_PRIMITIVE);
+            val->data = data;
         }
         else
         {
-            NL_Data *newData = addNewMember(val->ctx->currentData, name);
-            val->ctx->currentData = newData;
+            data = addNewMember(val->ctx->arena, val->ctx->currentData, name);
         }
-
         break;
     case PARSERSTATE_FINISHED:
-        break;
+        return true;
+    }
+    // the remaining states add a data element
+    if (!data)
+    {
+        return false;
     }
+    val->ctx->currentData = data;
+    return true;
 }
 
 static const char* isOnlyWhitespace(const char* value)
@@ -211,42 +269,19 @@ void Value_end(NL_Value *val, const char *name, const char *value)
         break;
     }
 }
-static void Data_clear(NL_Data *data);
-
-static void PrimitiveData_clear(NL_Data *data)
-{
-    // free(data);
-}
 
-static void ComplexData_clear(NL_Data *data)
+bool Value_beginDecode(NL_Value *val)
 {
-    for (size_t cnt = 0; cnt < data->val.complexData.membersSize; cnt++)
-    {
-        Data_clear(data->val.complexData.members[cnt]);
-    }
-    free(data->val.complexData.members);
-}
-
-static void Data_clear(NL_Data *data)
-{
-    if(!data)
-    {
-        return;
-    }
-    if (data->type == DATATYPE_PRIMITIVE)
-    {
-        PrimitiveData_clear(data);
-    }
-    else
+    if (!val->ctx || val->data || !isOnlyWhitespace(val->xml))
     {
-        ComplexData_clear(data);
+        return false;
     }
-    free(data);
+    val->ctx->state = PARSERSTATE_INIT;
+    val->ctx->currentData = NULL;
+    return true;
 }
 
-void Value_delete(NL_Value *val)
+void Value_finish(NL_Value *val)
 {
-    Data_clear(val->data);
-    free(val->ctx);
-    free(val);
+    val->ctx = NULL;
 }
@@ -6,6 +6,7 @@
  */
 
 #include "NodesetLoader/NodesetLoader.h"
+#include "Arena.h"
 #include <stdbool.h>
 #include <stddef.h>
 
@@ -21,14 +22,27 @@ enum ParserState
 };
 typedef enum ParserState ParserState;
 
+// state of the value which is currently parsed, owned by the parser and
+// reused for all values
 struct NL_ParserCtx
 {
     ParserState state;
     NL_Data *currentData;
+    Arena *arena;
 };
 typedef struct NL_ParserCtx NL_ParserCtx;
 
-NL_Value *Value_new(const NL_Node *node);
-void Value_start(NL_Value *val, const char *name);
+// the value and its data live in the arena, they are released when the arena
+// is deleted
+NL_Value *Value_new(Arena *arena, NL_ParserCtx *ctx);
+// false if memory ran out, the value is incomplete then
+bool Value_start(NL_Value *val, const char *name);
 void Value_end(NL_Value *val, const char *name, const char *value);
-void Value_delete(NL_Value *val);
+// keeps a copy of the content of the value element in the arena of ctx, the
+// context stays attached until the value is decoded
+NL_Value *Value_newLazy(NL_ParserCtx *ctx, const char *xml, size_t size);
+// prepares a lazy value for the calls of Value_start and Value_end, false if
+// there is nothing to decode
+bool Value_beginDecode(NL_Value *val);
+// detaches the parser context when the value element is closed
+void Value_finish(NL_Value *val);
@@ -8,62 +8,46 @@
 #include "Node.h"
 #include "DataTypeNode.h"
 #include <stdlib.h>
-#include "Value.h"
 
-NL_Node *Node_new(NL_NodeClass nodeClass)
+size_t Node_size(NL_NodeClass nodeClass)
 {
-    void *node = NULL;
     switch (nodeClass)
     {
     case NODECLASS_VARIABLE:
-        node = calloc(1, sizeof(NL_VariableNode));
-        break;
+        return sizeof(NL_VariableNode);
     case NODECLASS_OBJECT:
-        node = calloc(1, sizeof(NL_ObjectNode));
-        break;
+        return sizeof(NL_ObjectNode);
     case NODECLASS_OBJECTTYPE:
-        node = calloc(1, sizeof(NL_ObjectTypeNode));
-        break;
+        return sizeof(NL_ObjectTypeNode);
     case NODECLASS_REFERENCETYPE:
-        node = calloc(1, sizeof(NL_ReferenceTypeNode));
-        break;
+        return sizeof(NL_ReferenceTypeNode);
     case NODECLASS_VARIABLETYPE:
-        node = calloc(1, sizeof(NL_VariableTypeNode));
-        break;
+        return sizeof(NL_VariableTypeNode);
     case NODECLASS_DATATYPE:
-        node = calloc(1, sizeof(NL_DataTypeNode));
-        break;
+        return sizeof(NL_DataTypeNode);
     case NODECLASS_METHOD:
-        node = calloc(1, sizeof(NL_MethodNode));
-        break;
+        return sizeof(NL_MethodNode);
     case NODECLASS_VIEW:
-        node = calloc(1, sizeof(NL_ViewNode));
-        break;
+        return sizeof(NL_ViewNode);
     }
-    if(!node)
-    {
-        return NULL;
-    }
-    return (NL_Node*)node;
+    return sizeof(NL_Node);
 }
 
-static void deleteRef(NL_Reference *ref)
+static void clearRefs(NL_Reference *ref)
 {
     while (ref)
     {
-        NL_Reference *tmp = ref->next;
         UA_NodeId_clear(&ref->target);
         UA_NodeId_clear(&ref->refType);
-        free(ref);
-        ref = tmp;
+        ref = ref->next;
     }
 }
 
-void Node_delete(NL_Node *node)
+void Node_clear(NL_Node *node)
 {
     UA_NodeId_clear(&node->id);
-    deleteRef(node->hierachicalRefs);
-    deleteRef(node->nonHierachicalRefs);
+    clearRefs(node->hierachicalRefs);
+    clearRefs(node->nonHierachicalRefs);
     if (node->nodeClass == NODECLASS_DATATYPE)
     {
         DataTypeNode_clear((NL_DataTypeNode *)node);
@@ -71,18 +55,11 @@ void Node_delete(NL_Node *node)
     if(node->nodeClass == NODECLASS_VARIABLE)
     {
         NL_VariableNode* varNode = (NL_VariableNode*)node;
-        free(varNode->refToTypeDef);
         UA_NodeId_clear(&varNode->parentNodeId);
-        if(varNode->value)
-        {
-            Value_delete(varNode->value);
-        }
     }
     if(node->nodeClass==NODECLASS_OBJECT)
     {
         NL_ObjectNode *objNode = (NL_ObjectNode *)node;
         UA_NodeId_clear(&objNode->parentNodeId);
-        free(objNode->refToTypeDef);
     }
-    free(node);
 }
@@ -9,7 +9,9 @@
 #define NODE_H
 #include "NodesetLoader/NodesetLoader.h"
 
-NL_Node *Node_new(NL_NodeClass nodeClass);
-void Node_delete(NL_Node *node);
+size_t Node_size(NL_NodeClass nodeClass);
+// releases everything the node owns, the memory of the node and its
+// references belongs to the pools of the nodeset
+void Node_clear(NL_Node *node);
 
 #endif
@@ -31,30 +31,36 @@ NodeContainer *NodeContainer_new(size_t initialSize, bool owner)
     return container;
 }
 
-void NodeContainer_add(NodeContainer *container, NL_Node *node)
+bool NodeContainer_add(NodeContainer *container, NL_Node *node)
 {
     if (container->size == container->capacity)
     {
-        container->nodes = (NL_Node **)realloc(
+        NL_Node **nodes = (NL_Node **)realloc(
             container->nodes,
             (container->size + container->incrementSize) * sizeof(void *));
-        if(!container->nodes)
+        if(!nodes)
         {
-            return;
+            return false;
         }
+        container->nodes = nodes;
         container->capacity += container->incrementSize;
     }
     container->nodes[container->size] = node;
     container->size++;
+    return true;
 }
 
 void NodeContainer_delete(NodeContainer *container)
 {
+    if (!container)
+    {
+        return;
+    }
     if (container->owner)
     {
         for (size_t i = 0; i < container->size; i++)
         {
-            Node_delete(container->nodes[i]);
+            Node_clear(container->nodes[i]);
         }
     }
     free(container->nodes);
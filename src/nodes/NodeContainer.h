@@ -21,6 +21,7 @@ typedef struct NodeContainer NodeContainer;
 
 NodeContainer *NodeContainer_new(size_t initialSize, bool owner);
 void NodeContainer_delete(NodeContainer *container);
-void NodeContainer_add(NodeContainer *container, NL_Node *node);
+// false if memory ran out, the node is not added then
+bool NodeContainer_add(NodeContainer *container, NL_Node *node);
 
 #endif
@@ -1,11 +1,24 @@
 #include "../src/Value.h"
 #include "check.h"
 
+static Arena *arena;
+static NL_ParserCtx ctx;
+
+static void setup(void)
+{
+    arena = Arena_new(1024);
+}
+
+static void teardown(void)
+{
+    Arena_delete(arena);
+}
+
 START_TEST(simpleVal)
 {
     //<Value><Double> 3.1415 < / Double > </Value>
 
-    NL_Value *val = Value_new(NULL);
+    NL_Value *val = Value_new(arena, &ctx);
     Value_start(val, "Double");
     Value_end(val, "Double", "3.1415");
     ck_assert(val);
@@ -13,7 +26,7 @@ START_TEST(simpleVal)
     ck_assert(!strcmp(val->data->val.primitiveData.value, "3.1415"));
     ck_assert(!strcmp(val->data->name, "Double"));
     ck_assert(!strcmp(val->type, "Double"));
-    Value_delete(val);
+    Value_finish(val);
 }
 END_TEST
 
@@ -39,7 +52,7 @@ START_TEST(ExtensionObject)
     </Value>
 */
 
-    NL_Value *val = Value_new(NULL);
+    NL_Value *val = Value_new(arena, &ctx);
     Value_start(val, "ExtensionObject");
     Value_start(val, "TypeId");
     Value_start(val, "Identifier");
@@ -62,7 +75,7 @@ START_TEST(ExtensionObject)
     ck_assert(val->data->val.complexData.membersSize == 2);
     ck_assert(!strcmp(val->data->val.complexData.members[0]->name, "Name"));
     ck_assert(!strcmp(val->data->val.complexData.members[1]->name, "DataType"));
-    Value_delete(val);
+    Value_finish(val);
 }
 END_TEST
 
@@ -78,7 +91,7 @@ START_TEST(ListOfUInt32)
         </Value>
     */
 
-    NL_Value *val = Value_new(NULL);
+    NL_Value *val = Value_new(arena, &ctx);
     Value_start(val, "ListOfUInt32");
     Value_start(val, "UInt32");
     Value_end(val, "UInt32", "120");
@@ -94,7 +107,7 @@ START_TEST(ListOfUInt32)
         val->data->val.complexData.members[0]->val.primitiveData.value, "120"));
     ck_assert(!strcmp(
         val->data->val.complexData.members[1]->val.primitiveData.value, "130"));
-    Value_delete(val);
+    Value_finish(val);
 }
 END_TEST
 
@@ -136,7 +149,7 @@ xmlns="http://opcfoundation.org/UA/2008/02/Types.xsd"> <ExtensionObject>
       </ListOfExtensionObject>
 */
 
-    NL_Value *val = Value_new(NULL);
+    NL_Value *val = Value_new(arena, &ctx);
     Value_start(val, "ListOfExtensionObject");
     // obj1
     Value_start(val, "ExtensionObject");
@@ -175,7 +188,7 @@ xmlns="http://opcfoundation.org/UA/2008/02/Types.xsd"> <ExtensionObject>
     ck_assert(val->data->val.complexData.membersSize == 2);
     ck_assert(!strcmp(val->data->val.complexData.members[0]->name, "Argument"));
     ck_assert(!strcmp(val->data->val.complexData.members[1]->name, "Argument"));
-    Value_delete(val);
+    Value_finish(val);
 }
 END_TEST
 
@@ -190,7 +203,7 @@ START_TEST(LocalizedText)
     </Value>
     */
 
-    NL_Value *val = Value_new(NULL);
+    NL_Value *val = Value_new(arena, &ctx);
     Value_start(val, "LocalizedText");
     Value_start(val, "Locale");
     Value_end(val, "Locale", "en");
@@ -206,7 +219,7 @@ START_TEST(LocalizedText)
     ck_assert(
         !strcmp(val->data->val.complexData.members[1]->val.primitiveData.value,
                 "someText@42"));
-    Value_delete(val);
+    Value_finish(val);
 }
 END_TEST
 
@@ -248,7 +261,7 @@ START_TEST(EnumValueType)
     </uax:ExtensionObject>
 </uax:ListOfExtensionObject>
 */
-    NL_Value *val = Value_new(NULL);
+    NL_Value *val = Value_new(arena, &ctx);
     Value_start(val, "ListOfExtensionObject");
     // obj1
     Value_start(val, "ExtensionObject");
@@ -304,7 +317,29 @@ START_TEST(EnumValueType)
     ck_assert(!strcmp(val->data->val.complexData.members[1]
                   ->val.complexData.members[1]
                   ->val.complexData.members[0]->name, "Text"));
-    Value_delete(val);
+    Value_finish(val);
+}
+END_TEST
+
+START_TEST(LargeList)
+{
+    NL_Value *val = Value_new(arena, &ctx);
+    Value_start(val, "ListOfUInt32");
+    for (int i = 0; i < 10000; i++)
+    {
+        Value_start(val, "UInt32");
+        Value_end(val, "UInt32", i % 2 ? "1" : "0");
+    }
+    Value_end(val, "ListOfUInt32", NULL);
+    Value_finish(val);
+    ck_assert(val->ctx == NULL);
+    ck_assert(val->data->val.complexData.membersSize == 10000);
+    for (size_t i = 0; i < 10000; i++)
+    {
+        const NL_Data *member = val->data->val.complexData.members[i];
+        ck_assert(member->parent == val->data);
+        ck_assert(!strcmp(member->val.primitiveData.value, i % 2 ? "1" : "0"));
+    }
 }
 END_TEST
 
@@ -318,6 +353,8 @@ int main(void)
     tcase_add_test(tc, ListOfExtensionObject);
     tcase_add_test(tc, LocalizedText);
     tcase_add_test(tc, EnumValueType);
+    tcase_add_test(tc, LargeList);
+    tcase_add_checked_fixture(tc, setup, teardown);
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
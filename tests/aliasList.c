@@ -0,0 +1,110 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "AliasList.h"
+#include "check.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ALIASES 1000
+
+START_TEST(manyAliases)
+{
+    AliasList *list = AliasList_new();
+    char(*names)[16] = (char(*)[16])calloc(ALIASES, sizeof(*names));
+    for (UA_UInt32 i = 0; i < ALIASES; i++)
+    {
+        snprintf(names[i], sizeof(names[i]), "Alias%u", i);
+        Alias *alias = AliasList_newAlias(list, names[i]);
+        ck_assert_ptr_nonnull(alias);
+        alias->id = UA_NODEID_NUMERIC(0, i);
+    }
+    for (UA_UInt32 i = 0; i < ALIASES; i++)
+    {
+        char name[16];
+        snprintf(name, sizeof(name), "Alias%u", i);
+        const UA_NodeId *id = AliasList_getNodeId(list, name);
+        ck_assert_ptr_nonnull(id);
+        ck_assert_uint_eq(id->identifier.numeric, i);
+    }
+    ck_assert_ptr_null(AliasList_getNodeId(list, "Alias"));
+    ck_assert_ptr_null(AliasList_getNodeId(list, NULL));
+    AliasList_delete(list);
+    free(names);
+}
+END_TEST
+
+START_TEST(duplicates)
+{
+    AliasList *list = AliasList_new();
+    char name[] = "HasComponent";
+    char again[] = "HasComponent";
+    AliasList_newAlias(list, name)->id = UA_NODEID_NUMERIC(0, 47);
+    AliasList_newAlias(list, again)->id = UA_NODEID_NUMERIC(0, 46);
+    ck_assert_uint_eq(AliasList_getNodeId(list, name)->identifier.numeric, 47);
+    ck_assert_ptr_null(AliasList_newAlias(list, NULL));
+    AliasList_delete(list);
+}
+END_TEST
+
+// string targets own their identifier, they are released by clear and delete,
+// the target of a duplicate when it is replaced
+START_TEST(stringTargets)
+{
+    AliasList *list = AliasList_new();
+    char name[] = "HasPart";
+    char again[] = "HasPart";
+    char other[] = "IsPartOf";
+    ck_assert_uint_eq(UA_NodeId_parse(&AliasList_newAlias(list, name)->id,
+                                      UA_STRING("ns=1;s=HasPart")),
+                      UA_STATUSCODE_GOOD);
+    for (int i = 0; i < 2; i++)
+    {
+        ck_assert_uint_eq(
+            UA_NodeId_parse(&AliasList_newAlias(list, again)->id,
+                            UA_STRING("ns=1;s=Duplicate")),
+            UA_STATUSCODE_GOOD);
+    }
+    AliasList_clear(list);
+    ck_assert_uint_eq(UA_NodeId_parse(&AliasList_newAlias(list, other)->id,
+                                      UA_STRING("ns=1;s=IsPartOf")),
+                      UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(
+        AliasList_getNodeId(list, other)->identifierType, UA_NODEIDTYPE_STRING);
+    // the leak checker reports targets which are not released
+    AliasList_delete(list);
+}
+END_TEST
+
+START_TEST(clear)
+{
+    AliasList *list = AliasList_new();
+    char name[] = "HasComponent";
+    AliasList_newAlias(list, name)->id = UA_NODEID_NUMERIC(0, 47);
+    AliasList_clear(list);
+    ck_assert_ptr_null(AliasList_getNodeId(list, name));
+    AliasList_newAlias(list, name)->id = UA_NODEID_NUMERIC(0, 46);
+    ck_assert_uint_eq(AliasList_getNodeId(list, name)->identifier.numeric, 46);
+    AliasList_delete(list);
+}
+END_TEST
+
+int main(void)
+{
+    Suite *s = suite_create("AliasList tests");
+    TCase *tc = tcase_create("test cases");
+    tcase_add_test(tc, manyAliases);
+    tcase_add_test(tc, duplicates);
+    tcase_add_test(tc, stringTargets);
+    tcase_add_test(tc, clear);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,74 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "Arena.h"
+#include "check.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+START_TEST(zeroedMemory)
+{
+    Arena *arena = Arena_new(64);
+    for (size_t size = 1; size < 40; size++)
+    {
+        char *mem = (char *)Arena_alloc(arena, size);
+        ck_assert(mem != NULL);
+        for (size_t i = 0; i < size; i++)
+        {
+            ck_assert(mem[i] == 0);
+        }
+        memset(mem, 0xff, size);
+    }
+    Arena_delete(arena);
+}
+END_TEST
+
+START_TEST(alignment)
+{
+    Arena *arena = Arena_new(1024);
+    char *a = (char *)Arena_alloc(arena, 3);
+    char *b = (char *)Arena_alloc(arena, 5);
+    ck_assert(a != b);
+    ck_assert((uintptr_t)a % sizeof(double) == 0);
+    ck_assert((uintptr_t)b % sizeof(double) == 0);
+    Arena_delete(arena);
+}
+END_TEST
+
+START_TEST(blocks)
+{
+    Arena *arena = Arena_new(1024);
+    ck_assert_uint_eq(Arena_blockCount(arena), 0);
+    char *small = (char *)Arena_alloc(arena, 16);
+    ck_assert_uint_eq(Arena_blockCount(arena), 1);
+    // a large allocation gets a block of its own
+    char *large = (char *)Arena_alloc(arena, 4096);
+    ck_assert(large != NULL);
+    memset(large, 0xff, 4096);
+    ck_assert_uint_eq(Arena_blockCount(arena), 2);
+    // and the current block is still used afterwards
+    char *next = (char *)Arena_alloc(arena, 16);
+    ck_assert(next == small + 16);
+    ck_assert_uint_eq(Arena_blockCount(arena), 2);
+    Arena_delete(arena);
+}
+END_TEST
+
+int main(void)
+{
+    Suite *s = suite_create("Arena tests");
+    TCase *tc = tcase_create("test cases");
+    tcase_add_test(tc, zeroedMemory);
+    tcase_add_test(tc, alignment);
+    tcase_add_test(tc, blocks);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,168 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "Base64.h"
+#include "check.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// encodes data with a line break after every lineLength characters, 0 for
+// no line breaks
+static char *encode(const unsigned char *data, size_t size, size_t lineLength,
+                    const char *lineBreak, bool padding)
+{
+    char *text = (char *)malloc(size / 3 * 4 + 4 +
+                                (size / 3 * 4 + 4) * strlen(lineBreak) + 1);
+    size_t pos = 0;
+    size_t chars = 0;
+    for (size_t i = 0; i < size; i += 3)
+    {
+        uint32_t group = (uint32_t)data[i] << 16;
+        size_t n = size - i < 3 ? size - i : 3;
+        if (n > 1)
+        {
+            group |= (uint32_t)data[i + 1] << 8;
+        }
+        if (n > 2)
+        {
+            group |= data[i + 2];
+        }
+        for (size_t c = 0; c < 4; c++)
+        {
+            if (lineLength && chars > 0 && chars % lineLength == 0)
+            {
+                memcpy(text + pos, lineBreak, strlen(lineBreak));
+                pos += strlen(lineBreak);
+            }
+            if (c <= n)
+            {
+                text[pos++] = alphabet[(group >> (18 - 6 * c)) & 0x3f];
+                chars++;
+            }
+            else if (padding)
+            {
+                text[pos++] = '=';
+                chars++;
+            }
+        }
+    }
+    text[pos] = '\0';
+    return text;
+}
+
+static void checkRoundTrip(size_t size, size_t lineLength,
+                           const char *lineBreak, bool padding)
+{
+    unsigned char *data = (unsigned char *)malloc(size + 1);
+    for (size_t i = 0; i < size; i++)
+    {
+        data[i] = (unsigned char)(rand() & 0xff);
+    }
+    char *text = encode(data, size, lineLength, lineBreak, padding);
+    size_t decodedSize = 0;
+    unsigned char *decoded = Base64_decode(text, strlen(text), &decodedSize);
+    if (size < 2 && !padding)
+    {
+        // a single byte is encoded with 2 characters, nothing is too short
+        ck_assert(size == 1 ? decoded != NULL : decoded == NULL);
+    }
+    else if (size == 0)
+    {
+        ck_assert_ptr_null(decoded);
+    }
+    else
+    {
+        ck_assert_ptr_nonnull(decoded);
+    }
+    if (decoded)
+    {
+        ck_assert_uint_eq(decodedSize, size);
+        ck_assert(!memcmp(decoded, data, size));
+    }
+    free(decoded);
+    free(text);
+    free(data);
+}
+
+START_TEST(roundTrip)
+{
+    srand(1);
+    for (size_t size = 0; size < 300; size++)
+    {
+        checkRoundTrip(size, 0, "", true);
+        checkRoundTrip(size, 0, "", false);
+        checkRoundTrip(size, 76, "\n", true);
+        checkRoundTrip(size, 64, "\r\n", true);
+        checkRoundTrip(size, 5, " ", false);
+    }
+    checkRoundTrip(1000000, 0, "", true);
+    checkRoundTrip(1000000, 76, "\r\n", true);
+}
+END_TEST
+
+START_TEST(knownValues)
+{
+    size_t size = 0;
+    unsigned char *data = Base64_decode("aGVsbG8=", 8, &size);
+    ck_assert_uint_eq(size, 5);
+    ck_assert(!memcmp(data, "hello", 5));
+    free(data);
+    data = Base64_decode("  aGVs\n\tbG8gd29y\r\nbGQ= \n", 24, &size);
+    ck_assert_uint_eq(size, 11);
+    ck_assert(!memcmp(data, "hello world", 11));
+    free(data);
+    // only padding
+    data = Base64_decode("==", 2, &size);
+    ck_assert_ptr_nonnull(data);
+    ck_assert_uint_eq(size, 0);
+    free(data);
+}
+END_TEST
+
+START_TEST(invalidText)
+{
+    size_t size = 1;
+    ck_assert_ptr_null(Base64_decode("", 0, &size));
+    ck_assert_uint_eq(size, 0);
+    ck_assert_ptr_null(Base64_decode("  a\n", 4, &size));
+    ck_assert_ptr_null(Base64_decode("aGVs*G8=", 8, &size));
+    // invalid characters are also found inside of long blocks
+    char text[100];
+    memset(text, 'A', sizeof(text));
+    for (size_t i = 0; i < sizeof(text); i++)
+    {
+        text[i] = '-';
+        ck_assert_ptr_null(Base64_decode(text, sizeof(text), &size));
+        text[i] = (char)0xC3;
+        ck_assert_ptr_null(Base64_decode(text, sizeof(text), &size));
+        text[i] = 'A';
+    }
+    unsigned char *data = Base64_decode(text, sizeof(text), &size);
+    ck_assert_uint_eq(size, 75);
+    free(data);
+}
+END_TEST
+
+int main(void)
+{
+    Suite *s = suite_create("Base64 tests");
+    TCase *tc = tcase_create("test cases");
+    tcase_add_test(tc, roundTrip);
+    tcase_add_test(tc, knownValues);
+    tcase_add_test(tc, invalidText);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
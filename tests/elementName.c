@@ -0,0 +1,69 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "check.h"
+#include "ElementName.h"
+#include <stdlib.h>
+
+START_TEST(knownElements)
+{
+    ck_assert(ElementName_lookup("UANodeSet") == ELEMENT_UANODESET);
+    ck_assert(ElementName_lookup("NamespaceUris") == ELEMENT_NAMESPACEURIS);
+    ck_assert(ElementName_lookup("Uri") == ELEMENT_URI);
+    ck_assert(ElementName_lookup("Aliases") == ELEMENT_ALIASES);
+    ck_assert(ElementName_lookup("Alias") == ELEMENT_ALIAS);
+    ck_assert(ElementName_lookup("UAObject") == ELEMENT_UAOBJECT);
+    ck_assert(ElementName_lookup("UAObjectType") == ELEMENT_UAOBJECTTYPE);
+    ck_assert(ElementName_lookup("UAVariable") == ELEMENT_UAVARIABLE);
+    ck_assert(ElementName_lookup("UAVariableType") == ELEMENT_UAVARIABLETYPE);
+    ck_assert(ElementName_lookup("UADataType") == ELEMENT_UADATATYPE);
+    ck_assert(ElementName_lookup("UAReferenceType") ==
+              ELEMENT_UAREFERENCETYPE);
+    ck_assert(ElementName_lookup("UAMethod") == ELEMENT_UAMETHOD);
+    ck_assert(ElementName_lookup("UAView") == ELEMENT_UAVIEW);
+    ck_assert(ElementName_lookup("DisplayName") == ELEMENT_DISPLAYNAME);
+    ck_assert(ElementName_lookup("Description") == ELEMENT_DESCRIPTION);
+    ck_assert(ElementName_lookup("References") == ELEMENT_REFERENCES);
+    ck_assert(ElementName_lookup("Reference") == ELEMENT_REFERENCE);
+    ck_assert(ElementName_lookup("Value") == ELEMENT_VALUE);
+    ck_assert(ElementName_lookup("Extensions") == ELEMENT_EXTENSIONS);
+    ck_assert(ElementName_lookup("Extension") == ELEMENT_EXTENSION);
+    ck_assert(ElementName_lookup("InverseName") == ELEMENT_INVERSENAME);
+    ck_assert(ElementName_lookup("Definition") == ELEMENT_DEFINITION);
+    ck_assert(ElementName_lookup("Field") == ELEMENT_FIELD);
+}
+END_TEST
+
+START_TEST(unknownElements)
+{
+    ck_assert(ElementName_lookup("") == ELEMENT_UNKNOWN);
+    ck_assert(ElementName_lookup("U") == ELEMENT_UNKNOWN);
+    ck_assert(ElementName_lookup("Ur") == ELEMENT_UNKNOWN);
+    ck_assert(ElementName_lookup("Int32") == ELEMENT_UNKNOWN);
+    ck_assert(ElementName_lookup("ListOfInt32") == ELEMENT_UNKNOWN);
+    ck_assert(ElementName_lookup("Documentation") == ELEMENT_UNKNOWN);
+    ck_assert(ElementName_lookup("RolePermissions") == ELEMENT_UNKNOWN);
+    ck_assert(ElementName_lookup("Models") == ELEMENT_UNKNOWN);
+    ck_assert(ElementName_lookup("uaobject") == ELEMENT_UNKNOWN);
+    ck_assert(ElementName_lookup("UAObjects") == ELEMENT_UNKNOWN);
+    ck_assert(ElementName_lookup("UAObjec") == ELEMENT_UNKNOWN);
+}
+END_TEST
+
+int main(void)
+{
+    Suite *s = suite_create("ElementName tests");
+    TCase *tc = tcase_create("test cases");
+    tcase_add_test(tc, knownElements);
+    tcase_add_test(tc, unknownElements);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,135 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "InternalRefService.h"
+#include "NodesetLoader/NodesetLoader.h"
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define REF_TYPES 200
+
+static void initRefType(NL_ReferenceTypeNode *node, NL_Reference *subtypeOf,
+                        UA_NodeId id, UA_NodeId parent)
+{
+    memset(node, 0, sizeof(NL_ReferenceTypeNode));
+    memset(subtypeOf, 0, sizeof(NL_Reference));
+    node->nodeClass = NODECLASS_REFERENCETYPE;
+    node->id = id;
+    subtypeOf->isForward = false;
+    subtypeOf->refType = UA_NODEID_NUMERIC(0, 45);
+    subtypeOf->target = parent;
+    node->hierachicalRefs = subtypeOf;
+}
+
+static bool isHierachical(NL_ReferenceService *service, UA_NodeId refType)
+{
+    NL_Reference ref;
+    memset(&ref, 0, sizeof(NL_Reference));
+    ref.refType = refType;
+    return service->isHierachicalRef(service->context, &ref);
+}
+
+static bool isNonHierachical(NL_ReferenceService *service, UA_NodeId refType)
+{
+    NL_Reference ref;
+    memset(&ref, 0, sizeof(NL_Reference));
+    ref.refType = refType;
+    return service->isNonHierachicalRef(service->context, &ref);
+}
+
+START_TEST(ns0Types)
+{
+    NL_ReferenceService *service = InternalRefService_new();
+    ck_assert(isHierachical(service, UA_NODEID_NUMERIC(0, 47)));
+    ck_assert(isHierachical(service, UA_NODEID_NUMERIC(0, 35)));
+    ck_assert(!isHierachical(service, UA_NODEID_NUMERIC(0, 40)));
+    ck_assert(isNonHierachical(service, UA_NODEID_NUMERIC(0, 40)));
+    ck_assert(!isHierachical(service, UA_NODEID_NUMERIC(0, 1000000)));
+    ck_assert(!isHierachical(service, UA_NODEID_STRING(0, "Organizes")));
+
+    // subtypes of namespace 0 which are defined by a nodeset
+    NL_ReferenceTypeNode node;
+    NL_Reference subtypeOf;
+    initRefType(&node, &subtypeOf, UA_NODEID_NUMERIC(0, 56),
+                UA_NODEID_NUMERIC(0, 44));
+    service->addNewReferenceType(service->context, &node);
+    ck_assert(isHierachical(service, UA_NODEID_NUMERIC(0, 56)));
+    initRefType(&node, &subtypeOf, UA_NODEID_NUMERIC(0, 1000000),
+                UA_NODEID_NUMERIC(0, 56));
+    service->addNewReferenceType(service->context, &node);
+    ck_assert(isHierachical(service, UA_NODEID_NUMERIC(0, 1000000)));
+    InternalRefService_delete(service);
+}
+END_TEST
+
+// a chain of subtypes, each one derived from the one before
+START_TEST(manyCustomTypes)
+{
+    NL_ReferenceService *service = InternalRefService_new();
+    NL_ReferenceTypeNode *nodes = (NL_ReferenceTypeNode *)calloc(
+        REF_TYPES, sizeof(NL_ReferenceTypeNode));
+    NL_Reference *refs =
+        (NL_Reference *)calloc(REF_TYPES, sizeof(NL_Reference));
+    for (UA_UInt32 i = 0; i < REF_TYPES; i++)
+    {
+        UA_NodeId parent =
+            i == 0 ? UA_NODEID_NUMERIC(0, 47) : UA_NODEID_NUMERIC(1, i - 1);
+        initRefType(&nodes[i], &refs[i], UA_NODEID_NUMERIC(1, i), parent);
+        service->addNewReferenceType(service->context, &nodes[i]);
+    }
+    for (UA_UInt32 i = 0; i < REF_TYPES; i++)
+    {
+        ck_assert(isHierachical(service, UA_NODEID_NUMERIC(1, i)));
+        ck_assert(!isNonHierachical(service, UA_NODEID_NUMERIC(1, i)));
+    }
+    ck_assert(!isHierachical(service, UA_NODEID_NUMERIC(1, REF_TYPES)));
+
+    NL_ReferenceTypeNode nonHierachical;
+    NL_Reference subtypeOf;
+    initRefType(&nonHierachical, &subtypeOf, UA_NODEID_STRING(1, "Custom"),
+                UA_NODEID_NUMERIC(0, 32));
+    service->addNewReferenceType(service->context, &nonHierachical);
+    ck_assert(!isHierachical(service, UA_NODEID_STRING(1, "Custom")));
+    ck_assert(isNonHierachical(service, UA_NODEID_STRING(1, "Custom")));
+    ck_assert(!isNonHierachical(service, UA_NODEID_STRING(1, "Unknown")));
+    InternalRefService_delete(service);
+    free(nodes);
+    free(refs);
+}
+END_TEST
+
+// the reference types are known by the service they were added to
+START_TEST(independentServices)
+{
+    NL_ReferenceService *a = InternalRefService_new();
+    NL_ReferenceService *b = InternalRefService_new();
+    NL_ReferenceTypeNode node;
+    NL_Reference subtypeOf;
+    initRefType(&node, &subtypeOf, UA_NODEID_NUMERIC(0, 30000),
+                UA_NODEID_NUMERIC(0, 44));
+    a->addNewReferenceType(a->context, &node);
+    ck_assert(isHierachical(a, UA_NODEID_NUMERIC(0, 30000)));
+    ck_assert(!isHierachical(b, UA_NODEID_NUMERIC(0, 30000)));
+    InternalRefService_delete(a);
+    InternalRefService_delete(b);
+}
+END_TEST
+
+int main(void)
+{
+    Suite *s = suite_create("InternalRefService tests");
+    TCase *tc = tcase_create("test cases");
+    tcase_add_test(tc, ns0Types);
+    tcase_add_test(tc, manyCustomTypes);
+    tcase_add_test(tc, independentServices);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,77 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "NodeIdMap.h"
+#include "check.h"
+#include <stdlib.h>
+
+#define NODES 1000
+
+START_TEST(numericIds)
+{
+    NodeIdMap *map = NodeIdMap_new(4);
+    NL_ObjectNode *nodes = (NL_ObjectNode *)calloc(NODES, sizeof(NL_ObjectNode));
+    for (UA_UInt32 i = 0; i < NODES; i++)
+    {
+        nodes[i].id = UA_NODEID_NUMERIC(1, i);
+        ck_assert_int_eq(NodeIdMap_insert(map, (NL_Node *)&nodes[i]),
+                         NODEIDMAP_INSERTED);
+    }
+    ck_assert_uint_eq(NodeIdMap_size(map), NODES);
+    for (UA_UInt32 i = 0; i < NODES; i++)
+    {
+        UA_NodeId id = UA_NODEID_NUMERIC(1, i);
+        ck_assert(NodeIdMap_get(map, &id) == (NL_Node *)&nodes[i]);
+    }
+    size_t position = 0;
+    UA_NodeId last = UA_NODEID_NUMERIC(1, NODES - 1);
+    ck_assert(NodeIdMap_getPosition(map, &last, &position));
+    ck_assert_uint_eq(position, NODES - 1);
+    UA_NodeId otherNs = UA_NODEID_NUMERIC(2, 1);
+    ck_assert_ptr_null(NodeIdMap_get(map, &otherNs));
+    ck_assert(!NodeIdMap_getPosition(map, &otherNs, &position));
+    UA_NodeId unknown = UA_NODEID_NUMERIC(1, NODES);
+    ck_assert_ptr_null(NodeIdMap_get(map, &unknown));
+    NodeIdMap_delete(map);
+    free(nodes);
+}
+END_TEST
+
+START_TEST(duplicates)
+{
+    NodeIdMap *map = NodeIdMap_new(0);
+    NL_ObjectNode a;
+    NL_ObjectNode b;
+    memset(&a, 0, sizeof(a));
+    memset(&b, 0, sizeof(b));
+    a.id = UA_NODEID_STRING(1, "node");
+    b.id = UA_NODEID_STRING(1, "node");
+    ck_assert_int_eq(NodeIdMap_insert(map, (NL_Node *)&a), NODEIDMAP_INSERTED);
+    ck_assert_int_eq(NodeIdMap_insert(map, (NL_Node *)&b),
+                     NODEIDMAP_DUPLICATE);
+    ck_assert_uint_eq(NodeIdMap_size(map), 1);
+    UA_NodeId id = UA_NODEID_STRING(1, "node");
+    ck_assert(NodeIdMap_get(map, &id) == (NL_Node *)&a);
+    UA_NodeId numeric = UA_NODEID_NUMERIC(1, 0);
+    ck_assert_ptr_null(NodeIdMap_get(map, &numeric));
+    NodeIdMap_delete(map);
+}
+END_TEST
+
+int main(void)
+{
+    Suite *s = suite_create("NodeIdMap tests");
+    TCase *tc = tcase_create("test cases");
+    tcase_add_test(tc, numericIds);
+    tcase_add_test(tc, duplicates);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
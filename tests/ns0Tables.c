@@ -0,0 +1,97 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "Ns0Tables.h"
+#include "check.h"
+#include <stdlib.h>
+
+static uint8_t refTypeFlags(UA_UInt32 id)
+{
+    UA_NodeId nodeId = UA_NODEID_NUMERIC(0, id);
+    const Ns0Tables_ReferenceType *type = Ns0Tables_findReferenceType(&nodeId);
+    ck_assert_ptr_nonnull(type);
+    return type->flags;
+}
+
+START_TEST(sortedById)
+{
+    for (size_t i = 1; i < Ns0Tables_referenceTypesSize; i++)
+    {
+        ck_assert(Ns0Tables_referenceTypes[i - 1].id <
+                  Ns0Tables_referenceTypes[i].id);
+    }
+    for (size_t i = 1; i < Ns0Tables_dataTypesSize; i++)
+    {
+        ck_assert(Ns0Tables_dataTypes[i - 1].id < Ns0Tables_dataTypes[i].id);
+    }
+}
+END_TEST
+
+START_TEST(referenceTypes)
+{
+    // HierarchicalReferences, HasComponent, HasOrderedComponent
+    ck_assert_uint_eq(refTypeFlags(33), NS0TABLES_HIERACHICAL);
+    ck_assert_uint_eq(refTypeFlags(47), NS0TABLES_HIERACHICAL);
+    ck_assert_uint_eq(refTypeFlags(49), NS0TABLES_HIERACHICAL);
+    // HasEncoding, HasTypeDefinition
+    ck_assert_uint_eq(refTypeFlags(38), NS0TABLES_NONHIERACHICAL);
+    ck_assert_uint_eq(refTypeFlags(40),
+                      NS0TABLES_NONHIERACHICAL | NS0TABLES_HASTYPEDEFINITION);
+    // References
+    ck_assert_uint_eq(refTypeFlags(31), 0);
+
+    UA_NodeId id = UA_NODEID_NUMERIC(0, 45);
+    ck_assert_uint_eq(Ns0Tables_findReferenceType(&id)->superType, 34);
+    // a data type
+    id = UA_NODEID_NUMERIC(0, 884);
+    ck_assert_ptr_null(Ns0Tables_findReferenceType(&id));
+    id = UA_NODEID_NUMERIC(1, 47);
+    ck_assert_ptr_null(Ns0Tables_findReferenceType(&id));
+    id = UA_NODEID_STRING(0, "HasComponent");
+    ck_assert_ptr_null(Ns0Tables_findReferenceType(&id));
+}
+END_TEST
+
+START_TEST(dataTypes)
+{
+    // Range -> Structure -> BaseDataType
+    UA_NodeId id = UA_NODEID_NUMERIC(0, 884);
+    const Ns0Tables_DataType *range = Ns0Tables_findDataType(&id);
+    ck_assert_ptr_nonnull(range);
+    ck_assert_uint_eq(range->superType, 22);
+    ck_assert_uint_eq(range->binaryEncodingId, 886);
+    ck_assert_uint_eq(range->xmlEncodingId, 885);
+    id = UA_NODEID_NUMERIC(0, range->superType);
+    const Ns0Tables_DataType *structure = Ns0Tables_findDataType(&id);
+    ck_assert_ptr_nonnull(structure);
+    ck_assert_uint_eq(structure->superType, 24);
+    ck_assert_uint_eq(structure->binaryEncodingId, 0);
+    id = UA_NODEID_NUMERIC(0, structure->superType);
+    ck_assert_uint_eq(Ns0Tables_findDataType(&id)->superType, 0);
+
+    id = UA_NODEID_NUMERIC(0, 47);
+    ck_assert_ptr_null(Ns0Tables_findDataType(&id));
+    id = UA_NODEID_NUMERIC(0, 0);
+    ck_assert_ptr_null(Ns0Tables_findDataType(&id));
+    id = UA_NODEID_NUMERIC(0, UINT32_MAX);
+    ck_assert_ptr_null(Ns0Tables_findDataType(&id));
+}
+END_TEST
+
+int main(void)
+{
+    Suite *s = suite_create("Ns0Tables tests");
+    TCase *tc = tcase_create("test cases");
+    tcase_add_test(tc, sortedById);
+    tcase_add_test(tc, referenceTypes);
+    tcase_add_test(tc, dataTypes);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
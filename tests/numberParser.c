@@ -0,0 +1,174 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "NumberParser.h"
+#include "check.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// deterministic pseudo random numbers
+static uint64_t nextRandom(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static const char *const integers[] = {
+    "0", "-0", "+7", "  42", "\t-42", "12abc", "abc", "", "-", "007",
+    "12345678", "123456789", "1234567890123456", "12345678901234567",
+    "9223372036854775807", "9223372036854775808", "-9223372036854775808",
+    "-9223372036854775809", "18446744073709551615", "18446744073709551616",
+    "99999999999999999999999", "-18446744073709551615", "00000000000000000001",
+    "2147483648", "4294967295", "1.5", "1e3"};
+
+START_TEST(int64)
+{
+    for (size_t i = 0; i < sizeof(integers) / sizeof(integers[0]); i++)
+    {
+        ck_assert_msg(NumberParser_toInt64(integers[i]) ==
+                          strtoll(integers[i], NULL, 10),
+                      "%s", integers[i]);
+    }
+    uint64_t state = 88172645463325252u;
+    char text[32];
+    for (int i = 0; i < 100000; i++)
+    {
+        int64_t value = (int64_t)nextRandom(&state);
+        // all lengths of digit runs
+        value >>= nextRandom(&state) % 64;
+        snprintf(text, sizeof(text), "%lld", (long long)value);
+        ck_assert_msg(NumberParser_toInt64(text) == value, "%s", text);
+    }
+}
+END_TEST
+
+START_TEST(uint64)
+{
+    for (size_t i = 0; i < sizeof(integers) / sizeof(integers[0]); i++)
+    {
+        ck_assert_msg(NumberParser_toUInt64(integers[i]) ==
+                          strtoull(integers[i], NULL, 10),
+                      "%s", integers[i]);
+    }
+    uint64_t state = 88172645463325252u;
+    char text[32];
+    for (int i = 0; i < 100000; i++)
+    {
+        uint64_t value = nextRandom(&state) >> (nextRandom(&state) % 64);
+        snprintf(text, sizeof(text), "%llu", (unsigned long long)value);
+        ck_assert_msg(NumberParser_toUInt64(text) == value, "%s", text);
+    }
+}
+END_TEST
+
+static const char *const decimals[] = {
+    "0", "-0", "0.0", "1", "-1.5", "3.1415", "  2.5", "1e3", "1E-3",
+    "1.5e+10", "0.1", "0.000123", "123456789012345678", "9007199254740993",
+    "1e22", "1e23", "1e-22", "1e-23", "4.9e-324", "1.7976931348623157e308",
+    "1e400", "1.", ".5", ".", "1e", "1e+", "12abc", "abc", "inf", "-nan",
+    "0x10", "3.4028234663852886e38", "1.17549435e-38",
+    "0.30000000000000004", "123.456e-5", "000000000000000000000012.5",
+    "1.2345678901234567890123"};
+
+static bool sameDouble(double a, double b)
+{
+    return memcmp(&a, &b, sizeof(a)) == 0 || (a != a && b != b);
+}
+
+static bool sameFloat(float a, float b)
+{
+    return memcmp(&a, &b, sizeof(a)) == 0 || (a != a && b != b);
+}
+
+START_TEST(doubles)
+{
+    for (size_t i = 0; i < sizeof(decimals) / sizeof(decimals[0]); i++)
+    {
+        ck_assert_msg(sameDouble(NumberParser_toDouble(decimals[i]),
+                                 strtod(decimals[i], NULL)),
+                      "%s", decimals[i]);
+    }
+    uint64_t state = 88172645463325252u;
+    char text[64];
+    for (int i = 0; i < 100000; i++)
+    {
+        // short decimals take the exact path, the shortest round trip
+        // representation of random doubles mostly doesn't
+        if (i % 2)
+        {
+            snprintf(text, sizeof(text), "%lld.%llde%d",
+                     (long long)(nextRandom(&state) % 100000000) - 50000000,
+                     (long long)(nextRandom(&state) % 1000),
+                     (int)(nextRandom(&state) % 40) - 20);
+        }
+        else
+        {
+            uint64_t bits = nextRandom(&state);
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            snprintf(text, sizeof(text), "%.17g", value);
+        }
+        ck_assert_msg(sameDouble(NumberParser_toDouble(text),
+                                 strtod(text, NULL)),
+                      "%s", text);
+    }
+}
+END_TEST
+
+START_TEST(floats)
+{
+    for (size_t i = 0; i < sizeof(decimals) / sizeof(decimals[0]); i++)
+    {
+        ck_assert_msg(sameFloat(NumberParser_toFloat(decimals[i]),
+                                strtof(decimals[i], NULL)),
+                      "%s", decimals[i]);
+    }
+    uint64_t state = 88172645463325252u;
+    char text[64];
+    for (int i = 0; i < 100000; i++)
+    {
+        if (i % 2)
+        {
+            snprintf(text, sizeof(text), "%lld.%llde%d",
+                     (long long)(nextRandom(&state) % 100000) - 50000,
+                     (long long)(nextRandom(&state) % 100),
+                     (int)(nextRandom(&state) % 20) - 10);
+        }
+        else
+        {
+            uint32_t bits = (uint32_t)nextRandom(&state);
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            snprintf(text, sizeof(text), "%.9g", (double)value);
+        }
+        ck_assert_msg(sameFloat(NumberParser_toFloat(text),
+                                strtof(text, NULL)),
+                      "%s", text);
+    }
+}
+END_TEST
+
+int main(void)
+{
+    Suite *s = suite_create("NumberParser tests");
+    TCase *tc = tcase_create("test cases");
+    tcase_add_test(tc, int64);
+    tcase_add_test(tc, uint64);
+    tcase_add_test(tc, doubles);
+    tcase_add_test(tc, floats);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
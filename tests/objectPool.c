@@ -0,0 +1,70 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "ObjectPool.h"
+#include "check.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+START_TEST(zeroedObjects)
+{
+    ObjectPool *pool = ObjectPool_new(24, 4);
+    for (int i = 0; i < 10; i++)
+    {
+        char *obj = (char *)ObjectPool_alloc(pool);
+        ck_assert(obj != NULL);
+        for (int j = 0; j < 24; j++)
+        {
+            ck_assert(obj[j] == 0);
+        }
+        memset(obj, 0xff, 24);
+    }
+    ObjectPool_delete(pool);
+}
+END_TEST
+
+START_TEST(slabs)
+{
+    ObjectPool *pool = ObjectPool_new(sizeof(double), 100);
+    ck_assert_uint_eq(ObjectPool_slabCount(pool), 0);
+    for (int i = 0; i < 100; i++)
+    {
+        ObjectPool_alloc(pool);
+    }
+    ck_assert_uint_eq(ObjectPool_slabCount(pool), 1);
+    ObjectPool_alloc(pool);
+    ck_assert_uint_eq(ObjectPool_slabCount(pool), 2);
+    ObjectPool_delete(pool);
+}
+END_TEST
+
+START_TEST(alignment)
+{
+    ObjectPool *pool = ObjectPool_new(3, 10);
+    char *a = (char *)ObjectPool_alloc(pool);
+    char *b = (char *)ObjectPool_alloc(pool);
+    ck_assert(a != b);
+    ck_assert((uintptr_t)a % sizeof(double) == 0);
+    ck_assert((uintptr_t)b % sizeof(double) == 0);
+    ObjectPool_delete(pool);
+}
+END_TEST
+
+int main(void)
+{
+    Suite *s = suite_create("ObjectPool tests");
+    TCase *tc = tcase_create("test cases");
+    tcase_add_test(tc, zeroedObjects);
+    tcase_add_test(tc, slabs);
+    tcase_add_test(tc, alignment);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
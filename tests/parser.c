@@ -5,6 +5,7 @@
 #include "check.h"
 #include "NodesetLoader/NodesetLoader.h"
 #include <stdlib.h>
+#include <string.h>
 
 unsigned short addNamespace(void *userContext, const char *uri) { return 1; }
 
@@ -49,12 +50,791 @@ START_TEST(Server_ImportBasicNodeClassTest)
 }
 END_TEST
 
+static char *readFile(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buffer = (char *)malloc((size_t)len);
+    *size = fread(buffer, 1, (size_t)len, f);
+    fclose(f);
+    return buffer;
+}
+
+static int countNodes(NodesetLoader *loader)
+{
+    int nodeCount = 0;
+    for (int i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        NodesetLoader_forEachNode(loader, (NL_NodeClass)i, &nodeCount,
+                                  (NodesetLoader_forEachNode_Func)addNode);
+    }
+    return nodeCount;
+}
+
+START_TEST(Server_ImportBufferTest)
+{
+    size_t size = 0;
+    char *buffer = readFile(nodesetPath, &size);
+    ck_assert(buffer);
+
+    NL_FileContext handler;
+    handler.addNamespace = addNamespace;
+    handler.extensionHandling = NULL;
+    handler.userContext = NULL;
+
+    NodesetLoader *fileLoader = NodesetLoader_new(NULL, NULL);
+    handler.file = nodesetPath;
+    ck_assert(NodesetLoader_importFile(fileLoader, &handler));
+    ck_assert(NodesetLoader_sort(fileLoader));
+
+    NodesetLoader *bufferLoader = NodesetLoader_new(NULL, NULL);
+    handler.file = NULL;
+    ck_assert(NodesetLoader_importBuffer(bufferLoader, &handler, buffer, size));
+    ck_assert(NodesetLoader_sort(bufferLoader));
+
+    ck_assert_int_eq(countNodes(fileLoader), countNodes(bufferLoader));
+
+    NodesetLoader_delete(fileLoader);
+    NodesetLoader_delete(bufferLoader);
+    free(buffer);
+}
+END_TEST
+
+START_TEST(Server_ImportInvalidBufferTest)
+{
+    NL_FileContext handler;
+    handler.addNamespace = addNamespace;
+    handler.extensionHandling = NULL;
+    handler.userContext = NULL;
+    handler.file = NULL;
+
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(!NodesetLoader_importBuffer(loader, &handler, NULL, 0));
+    const char truncated[] = "<UANodeSet><UAObject NodeId=\"ns=1;i=1\"";
+    ck_assert(!NodesetLoader_importBuffer(loader, &handler, truncated,
+                                          sizeof(truncated) - 1));
+    const char truncatedGzip[] = {0x1f, (char)0x8b, 0x08, 0x00};
+    ck_assert(!NodesetLoader_importBuffer(loader, &handler, truncatedGzip,
+                                          sizeof(truncatedGzip)));
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
+static void checkVariableAttributes(void *userContext, NL_Node *node)
+{
+    NL_VariableNode *var = (NL_VariableNode *)node;
+    (*((int *)userContext))++;
+    ck_assert_str_eq(var->browseName.name, "Var");
+    ck_assert_int_eq(var->accessLevel, 3);
+    ck_assert_str_eq(var->arrayDimensions, "2");
+    ck_assert_int_eq(var->valueRank, 1);
+    // attributes which are not set get the defaults of the specification
+    ck_assert_int_eq(var->userAccessLevel, 1);
+    ck_assert(var->minimumSamplingInterval == -1.0);
+    ck_assert(!(var->flags & NL_NODEFLAG_HISTORIZING));
+}
+
+START_TEST(Server_ImportAttributeDefaultsTest)
+{
+    NL_FileContext handler;
+    handler.addNamespace = addNamespace;
+    handler.extensionHandling = NULL;
+    handler.userContext = NULL;
+    handler.file = NULL;
+
+    const char nodeset[] =
+        "<UANodeSet><NamespaceUris><Uri>http://test/</Uri></NamespaceUris>"
+        "<UAVariable SymbolicName=\"Sym\" AccessLevel=\"3\" "
+        "NodeId=\"ns=1;i=1\" ValueRank=\"1\" BrowseName=\"1:Var\" "
+        "UserWriteMask=\"0\" ArrayDimensions=\"2\"><DisplayName>Var"
+        "</DisplayName></UAVariable></UANodeSet>";
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(NodesetLoader_importBuffer(loader, &handler, nodeset,
+                                         sizeof(nodeset) - 1));
+    ck_assert(NodesetLoader_sort(loader));
+    int variables = 0;
+    NodesetLoader_forEachNode(loader, NODECLASS_VARIABLE, &variables,
+                              checkVariableAttributes);
+    ck_assert_int_eq(variables, 1);
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
+static size_t countList(const NL_Reference *ref)
+{
+    size_t count = 0;
+    for (; ref; ref = ref->next)
+    {
+        count++;
+    }
+    return count;
+}
+
+static void checkCompactRefs(void *userContext, NL_Node *node)
+{
+    (*((int *)userContext))++;
+    size_t hierachical = 0;
+    size_t nonHierachical = 0;
+    const NL_Reference *hRefs =
+        NodesetLoader_getHierachicalRefs(node, &hierachical);
+    const NL_Reference *nhRefs =
+        NodesetLoader_getNonHierachicalRefs(node, &nonHierachical);
+    ck_assert_uint_eq(hierachical, countList(node->hierachicalRefs));
+    ck_assert_uint_eq(nonHierachical, countList(node->nonHierachicalRefs));
+    // the lists are still usable and are backed by the arrays
+    if (hierachical)
+    {
+        ck_assert(node->hierachicalRefs == hRefs);
+    }
+    if (nonHierachical)
+    {
+        ck_assert(node->nonHierachicalRefs == nhRefs);
+    }
+    // the non hierachical references follow the hierachical ones
+    if (hierachical && nonHierachical)
+    {
+        ck_assert(nhRefs == hRefs + hierachical);
+    }
+}
+
+START_TEST(Server_CompactReferencesTest)
+{
+    NL_FileContext handler;
+    handler.addNamespace = addNamespace;
+    handler.extensionHandling = NULL;
+    handler.userContext = NULL;
+    handler.file = nodesetPath;
+
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(NodesetLoader_importFile(loader, &handler));
+    ck_assert(NodesetLoader_sort(loader));
+    ck_assert(NodesetLoader_compactReferences(loader));
+    int nodeCount = 0;
+    for (int i = 0; i < NL_NODECLASS_COUNT; i++)
+    {
+        NodesetLoader_forEachNode(loader, (NL_NodeClass)i, &nodeCount,
+                                  checkCompactRefs);
+    }
+    ck_assert(nodeCount > 0);
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
+START_TEST(Server_GetNodeTest)
+{
+    NL_FileContext handler;
+    handler.addNamespace = addNamespace;
+    handler.extensionHandling = NULL;
+    handler.userContext = NULL;
+    handler.file = NULL;
+
+    const char nodeset[] =
+        "<UANodeSet><NamespaceUris><Uri>http://test/</Uri></NamespaceUris>"
+        "<UAObject NodeId=\"ns=1;i=1\" BrowseName=\"1:A\">"
+        "<DisplayName>A</DisplayName></UAObject>"
+        "<UAObject NodeId=\"ns=1;s=B\" BrowseName=\"1:B\">"
+        "<DisplayName>B</DisplayName></UAObject>"
+        "<UAObject NodeId=\"ns=1;i=1\" BrowseName=\"1:Duplicate\">"
+        "<DisplayName>Duplicate</DisplayName></UAObject></UANodeSet>";
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    UA_NodeId numericId = UA_NODEID_NUMERIC(1, 1);
+    ck_assert_ptr_null(NodesetLoader_getNode(loader, &numericId));
+    ck_assert(NodesetLoader_importBuffer(loader, &handler, nodeset,
+                                         sizeof(nodeset) - 1));
+    const NL_Node *node = NodesetLoader_getNode(loader, &numericId);
+    ck_assert_ptr_nonnull(node);
+    // the first node with an id is kept
+    ck_assert_str_eq(node->browseName.name, "A");
+    UA_NodeId stringId = UA_NODEID_STRING(1, "B");
+    node = NodesetLoader_getNode(loader, &stringId);
+    ck_assert_ptr_nonnull(node);
+    ck_assert_str_eq(node->browseName.name, "B");
+    UA_NodeId unknownId = UA_NODEID_NUMERIC(1, 2);
+    ck_assert_ptr_null(NodesetLoader_getNode(loader, &unknownId));
+    ck_assert(NodesetLoader_sort(loader));
+    ck_assert(NodesetLoader_getNode(loader, &stringId) == node);
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
+#define MAX_LEVEL_NODES 1000
+
+typedef struct
+{
+    const NL_Node *nodes[MAX_LEVEL_NODES];
+    size_t levels[MAX_LEVEL_NODES];
+    size_t nodeCnt;
+    size_t nextLevel;
+} LevelContext;
+
+static void collectLevel(void *context, size_t level, NL_Node **nodes,
+                         size_t nodeCount)
+{
+    LevelContext *ctx = (LevelContext *)context;
+    ck_assert_uint_eq(level, ctx->nextLevel);
+    ck_assert(nodeCount > 0);
+    ctx->nextLevel++;
+    for (size_t i = 0; i < nodeCount; i++)
+    {
+        ck_assert(ctx->nodeCnt < MAX_LEVEL_NODES);
+        ctx->nodes[ctx->nodeCnt] = nodes[i];
+        ctx->levels[ctx->nodeCnt] = level;
+        ctx->nodeCnt++;
+    }
+}
+
+static bool findLevel(const LevelContext *ctx, const NL_Node *node,
+                      size_t *level)
+{
+    for (size_t i = 0; i < ctx->nodeCnt; i++)
+    {
+        if (ctx->nodes[i] == node)
+        {
+            *level = ctx->levels[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+// every node which is a dependency of another one is on a lower level
+static LevelContext *checkLevels(NodesetLoader *loader)
+{
+    LevelContext *ctx = (LevelContext *)calloc(1, sizeof(LevelContext));
+    size_t levelCnt = NodesetLoader_forEachLevel(loader, ctx, collectLevel);
+    ck_assert_uint_eq(levelCnt, ctx->nextLevel);
+    ck_assert_int_eq((int)ctx->nodeCnt, countNodes(loader));
+    for (size_t i = 0; i < ctx->nodeCnt; i++)
+    {
+        const NL_Node *node = ctx->nodes[i];
+        for (const NL_Reference *ref = node->hierachicalRefs; ref;
+             ref = ref->next)
+        {
+            const NL_Node *target = NodesetLoader_getNode(loader, &ref->target);
+            size_t targetLevel = 0;
+            if (!target || target == node ||
+                !findLevel(ctx, target, &targetLevel))
+            {
+                continue;
+            }
+            if (ref->isForward)
+            {
+                ck_assert(ctx->levels[i] < targetLevel);
+            }
+            else
+            {
+                ck_assert(targetLevel < ctx->levels[i]);
+            }
+        }
+    }
+    return ctx;
+}
+
+START_TEST(Server_ForEachLevelTest)
+{
+    NL_FileContext handler;
+    handler.addNamespace = addNamespace;
+    handler.extensionHandling = NULL;
+    handler.userContext = NULL;
+    handler.file = nodesetPath;
+
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(NodesetLoader_importFile(loader, &handler));
+    ck_assert(NodesetLoader_sort(loader));
+    free(checkLevels(loader));
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
+static int sortSkipped = 0;
+
+static void countSkippedSort(void *context, enum NodesetLoader_LogLevel level,
+                             const char *message, ...)
+{
+    if (level == NODESETLOADER_LOGLEVEL_DEBUG &&
+        !strcmp(message, "nodes are in dependency order, sorting skipped"))
+    {
+        sortSkipped++;
+    }
+}
+
+static size_t levelOf(NodesetLoader *loader, const LevelContext *ctx,
+                      UA_UInt32 id)
+{
+    UA_NodeId nodeId = UA_NODEID_NUMERIC(1, id);
+    size_t level = 0;
+    ck_assert(findLevel(ctx, NodesetLoader_getNode(loader, &nodeId), &level));
+    return level;
+}
+
+static void sortBuffer(const char *nodeset, size_t size, bool skipped)
+{
+    NL_FileContext handler;
+    handler.addNamespace = addNamespace;
+    handler.extensionHandling = NULL;
+    handler.userContext = NULL;
+    handler.file = NULL;
+
+    NodesetLoader_Logger logger = {NULL, countSkippedSort};
+    NodesetLoader *loader = NodesetLoader_new(&logger, NULL);
+    ck_assert(NodesetLoader_importBuffer(loader, &handler, nodeset, size));
+    sortSkipped = 0;
+    ck_assert(NodesetLoader_sort(loader));
+    ck_assert_int_eq(sortSkipped, skipped ? 1 : 0);
+    LevelContext *ctx = checkLevels(loader);
+    // both orders result in the same levels, the parent of C is not part of
+    // the nodeset
+    ck_assert_uint_eq(levelOf(loader, ctx, 1), 0);
+    ck_assert_uint_eq(levelOf(loader, ctx, 2), 1);
+    ck_assert_uint_eq(levelOf(loader, ctx, 3), 0);
+    ck_assert_uint_eq(levelOf(loader, ctx, 4), 1);
+    free(ctx);
+    NodesetLoader_delete(loader);
+}
+
+#define NODE_A                                                                 \
+    "<UAObjectType NodeId=\"ns=1;i=1\" BrowseName=\"1:A\">"                  \
+    "<DisplayName>A</DisplayName><References>"                                 \
+    "<Reference ReferenceType=\"HasSubtype\" IsForward=\"false\">i=58"        \
+    "</Reference></References></UAObjectType>"
+#define NODE_B                                                                 \
+    "<UAObjectType NodeId=\"ns=1;i=2\" BrowseName=\"1:B\">"                  \
+    "<DisplayName>B</DisplayName><References>"                                 \
+    "<Reference ReferenceType=\"HasSubtype\" IsForward=\"false\">ns=1;i=1"   \
+    "</Reference></References></UAObjectType>"
+#define NODE_C                                                                 \
+    "<UAObject NodeId=\"ns=1;i=3\" BrowseName=\"1:C\">"                      \
+    "<DisplayName>C</DisplayName><References>"                                 \
+    "<Reference ReferenceType=\"HasTypeDefinition\">ns=1;i=2</Reference>"     \
+    "<Reference ReferenceType=\"Organizes\" IsForward=\"false\">i=85"         \
+    "</Reference></References></UAObject>"
+#define NODE_D                                                                 \
+    "<UAObject NodeId=\"ns=1;i=4\" BrowseName=\"1:D\" "                      \
+    "ParentNodeId=\"ns=1;i=3\"><DisplayName>D</DisplayName>"                  \
+    "<References><Reference ReferenceType=\"HasTypeDefinition\">i=58"         \
+    "</Reference><Reference ReferenceType=\"HasComponent\" "                  \
+    "IsForward=\"false\">ns=1;i=3</Reference></References></UAObject>"
+#define NODESET(nodes)                                                         \
+    "<UANodeSet><NamespaceUris><Uri>http://test/</Uri></NamespaceUris>"        \
+    "<Aliases><Alias Alias=\"Organizes\">i=35</Alias>"                        \
+    "<Alias Alias=\"HasTypeDefinition\">i=40</Alias>"                         \
+    "<Alias Alias=\"HasSubtype\">i=45</Alias>"                                \
+    "<Alias Alias=\"HasComponent\">i=47</Alias></Aliases>" nodes              \
+    "</UANodeSet>"
+
+START_TEST(Server_DocumentOrderTest)
+{
+    const char sorted[] = NODESET(NODE_A NODE_B NODE_C NODE_D);
+    sortBuffer(sorted, sizeof(sorted) - 1, true);
+    // a node of the same nodeset is referenced before it is defined
+    const char reversed[] = NODESET(NODE_D NODE_C NODE_B NODE_A);
+    sortBuffer(reversed, sizeof(reversed) - 1, false);
+}
+END_TEST
+
+START_TEST(Server_PruneUnloadedNamespacesTest)
+{
+    NL_FileContext handler;
+    handler.addNamespace = addNamespace;
+    handler.extensionHandling = NULL;
+    handler.userContext = NULL;
+    handler.file = NULL;
+
+    // the forward reference to a node of namespace 0 requires the sorting
+    // algorithm, unless namespace 0 is pruned
+    const char nodeset[] = NODESET(
+        NODE_A "<UAObject NodeId=\"ns=1;i=5\" BrowseName=\"1:E\">"
+               "<DisplayName>E</DisplayName><References>"
+               "<Reference ReferenceType=\"Organizes\">i=2253</Reference>"
+               "</References></UAObject>");
+    NodesetLoader_Logger logger = {NULL, countSkippedSort};
+    for (int prune = 0; prune < 2; prune++)
+    {
+        NodesetLoader *loader = NodesetLoader_new(&logger, NULL);
+        NodesetLoader_setPruneUnloadedNamespaces(loader, prune == 1);
+        ck_assert(NodesetLoader_importBuffer(loader, &handler, nodeset,
+                                             sizeof(nodeset) - 1));
+        sortSkipped = 0;
+        ck_assert(NodesetLoader_sort(loader));
+        ck_assert_int_eq(sortSkipped, prune);
+        LevelContext *ctx = checkLevels(loader);
+        ck_assert_uint_eq(ctx->nodeCnt, 2);
+        free(ctx);
+        NodesetLoader_delete(loader);
+    }
+}
+END_TEST
+
+// reference service which knows the reference types of the test nodesets
+typedef struct
+{
+    int hierachicalCalls;
+    bool customTypeAdded;
+} CountingRefService;
+
+static bool isNs0Type(const NL_Reference *ref, UA_UInt32 id)
+{
+    return ref->refType.namespaceIndex == 0 &&
+           ref->refType.identifier.numeric == id;
+}
+
+static bool countingIsHierachical(void *context, const NL_Reference *ref)
+{
+    CountingRefService *service = (CountingRefService *)context;
+    service->hierachicalCalls++;
+    if (ref->refType.namespaceIndex == 1)
+    {
+        return service->customTypeAdded;
+    }
+    return isNs0Type(ref, 35) || isNs0Type(ref, 45) || isNs0Type(ref, 47);
+}
+
+static bool countingIsNonHierachical(void *context, const NL_Reference *ref)
+{
+    return ref->refType.namespaceIndex == 0;
+}
+
+static bool countingIsHasTypeDef(void *context, const NL_Reference *ref)
+{
+    return isNs0Type(ref, 40);
+}
+
+static void countingAddNewReferenceType(void *context,
+                                        const NL_ReferenceTypeNode *node)
+{
+    ((CountingRefService *)context)->customTypeAdded = true;
+}
+
+START_TEST(Server_RefTypeCacheTest)
+{
+    NL_FileContext handler;
+    handler.addNamespace = addNamespace;
+    handler.extensionHandling = NULL;
+    handler.userContext = NULL;
+    handler.file = NULL;
+
+    CountingRefService counter = {0, false};
+    NL_ReferenceService service = {
+        &counter, countingIsHierachical, countingIsNonHierachical,
+        countingIsHasTypeDef, countingAddNewReferenceType};
+    // the custom reference type is classified again once it is added
+    const char nodeset[] = NODESET(
+        NODE_A NODE_B NODE_C NODE_D
+        "<UAObject NodeId=\"ns=1;i=5\" BrowseName=\"1:E\">"
+        "<DisplayName>E</DisplayName><References>"
+        "<Reference ReferenceType=\"ns=1;i=10\" IsForward=\"false\">"
+        "ns=1;i=3</Reference></References></UAObject>"
+        "<UAReferenceType NodeId=\"ns=1;i=10\" BrowseName=\"1:HasPart\">"
+        "<DisplayName>HasPart</DisplayName><References>"
+        "<Reference ReferenceType=\"HasSubtype\" IsForward=\"false\">i=47"
+        "</Reference></References></UAReferenceType>"
+        "<UAObject NodeId=\"ns=1;i=6\" BrowseName=\"1:F\">"
+        "<DisplayName>F</DisplayName><References>"
+        "<Reference ReferenceType=\"ns=1;i=10\" IsForward=\"false\">"
+        "ns=1;i=3</Reference></References></UAObject>");
+    NodesetLoader *loader = NodesetLoader_new(NULL, &service);
+    ck_assert(NodesetLoader_importBuffer(loader, &handler, nodeset,
+                                         sizeof(nodeset) - 1));
+    // HasSubtype, HasTypeDefinition, Organizes, HasComponent and the custom
+    // type before and after it was added
+    ck_assert_int_eq(counter.hierachicalCalls, 6);
+    UA_NodeId e = UA_NODEID_NUMERIC(1, 5);
+    ck_assert_ptr_null(NodesetLoader_getNode(loader, &e)->hierachicalRefs);
+    UA_NodeId f = UA_NODEID_NUMERIC(1, 6);
+    ck_assert_ptr_nonnull(NodesetLoader_getNode(loader, &f)->hierachicalRefs);
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
+#define REFTYPE(id, superType)                                                 \
+    "<UAReferenceType NodeId=\"ns=1;i=" id "\" BrowseName=\"1:R" id "\">"      \
+    "<DisplayName>R</DisplayName><References>"                                 \
+    "<Reference ReferenceType=\"HasSubtype\" IsForward=\"false\">" superType  \
+    "</Reference></References></UAReferenceType>"
+#define NODE_WITH_REF(id, refType)                                             \
+    "<UAObject NodeId=\"ns=1;i=" id "\" BrowseName=\"1:N" id "\">"             \
+    "<DisplayName>N</DisplayName><References>"                                 \
+    "<Reference ReferenceType=\"ns=1;i=" refType "\" IsForward=\"false\">"    \
+    "ns=1;i=3</Reference></References></UAObject>"
+
+static bool importAndSort(NodesetLoader *loader, const char *nodeset,
+                          size_t size)
+{
+    NL_FileContext handler;
+    handler.addNamespace = addNamespace;
+    handler.extensionHandling = NULL;
+    handler.userContext = NULL;
+    handler.file = NULL;
+    ck_assert(NodesetLoader_importBuffer(loader, &handler, nodeset, size));
+    return NodesetLoader_sort(loader);
+}
+
+START_TEST(Server_PendingRefTypeTest)
+{
+    // the supertype of 10 is defined after the type and its first use
+    const char nodeset[] = NODESET(
+        NODE_A NODE_B NODE_C NODE_WITH_REF("5", "10") REFTYPE("10", "ns=1;i=11")
+            REFTYPE("11", "i=47") NODE_WITH_REF("6", "10"));
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(importAndSort(loader, nodeset, sizeof(nodeset) - 1));
+    UA_NodeId id = UA_NODEID_NUMERIC(1, 5);
+    ck_assert_ptr_nonnull(NodesetLoader_getNode(loader, &id)->hierachicalRefs);
+    id = UA_NODEID_NUMERIC(1, 6);
+    ck_assert_ptr_nonnull(NodesetLoader_getNode(loader, &id)->hierachicalRefs);
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
+START_TEST(Server_UnresolvedRefTypeTest)
+{
+    // the supertype is missing
+    const char missing[] =
+        NODESET(REFTYPE("10", "ns=1;i=11") REFTYPE("12", "ns=1;i=10"));
+    // a cycle of HasSubtype references
+    const char cycle[] =
+        NODESET(REFTYPE("10", "ns=1;i=11") REFTYPE("11", "ns=1;i=10"));
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(!importAndSort(loader, missing, sizeof(missing) - 1));
+    NodesetLoader_delete(loader);
+    loader = NodesetLoader_new(NULL, NULL);
+    ck_assert(!importAndSort(loader, cycle, sizeof(cycle) - 1));
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
+#define VARIABLE(id, value)                                                    \
+    "<UAVariable NodeId=\"ns=1;i=" id "\" BrowseName=\"1:V" id "\">"           \
+    "<DisplayName>V</DisplayName>" value "</UAVariable>"
+
+static void compareData(const NL_Data *a, const NL_Data *b)
+{
+    if (!a || !b)
+    {
+        ck_assert(a == b);
+        return;
+    }
+    ck_assert_str_eq(a->name, b->name);
+    ck_assert_int_eq(a->type, b->type);
+    if (a->type == DATATYPE_PRIMITIVE)
+    {
+        const char *va = a->val.primitiveData.value;
+        const char *vb = b->val.primitiveData.value;
+        ck_assert((!va && !vb) || (va && vb && !strcmp(va, vb)));
+        return;
+    }
+    ck_assert_uint_eq(a->val.complexData.membersSize,
+                      b->val.complexData.membersSize);
+    for (size_t i = 0; i < a->val.complexData.membersSize; i++)
+    {
+        ck_assert(b->val.complexData.members[i]->parent == b);
+        compareData(a->val.complexData.members[i],
+                    b->val.complexData.members[i]);
+    }
+}
+
+START_TEST(Server_LazyValueTest)
+{
+    const char nodeset[] = NODESET(
+        VARIABLE("1", "<Value><Double>3.1415</Double></Value>")
+        VARIABLE("2", "<Value><ListOfUInt32 xmlns=\"http://opcfoundation.org/"
+                      "UA/2008/02/Types.xsd\"><UInt32>1</UInt32>"
+                      "<UInt32>2</UInt32></ListOfUInt32></Value>")
+        VARIABLE("3", "<Value><uax:ExtensionObject><uax:TypeId>"
+                      "<uax:Identifier>i=297</uax:Identifier></uax:TypeId>"
+                      "<uax:Body><uax:Argument><uax:Name>a &amp; b</uax:Name>"
+                      "</uax:Argument></uax:Body></uax:ExtensionObject>"
+                      "</Value>")
+        VARIABLE("4", "<Value/>")
+        VARIABLE("5", "<Value>\n  </Value>")
+        VARIABLE("6", "")
+        VARIABLE("7", "<Value ><Int32>7</Int32></Value\n >")
+        VARIABLE("8", "<n:Value xmlns:n=\"http://test/\"><Int32>8</Int32>"
+                      "</n:Value>"));
+    NL_FileContext handler;
+    handler.addNamespace = addNamespace;
+    handler.extensionHandling = NULL;
+    handler.userContext = NULL;
+    handler.file = NULL;
+    NodesetLoader *eager = NodesetLoader_new(NULL, NULL);
+    ck_assert(NodesetLoader_importBuffer(eager, &handler, nodeset,
+                                         sizeof(nodeset) - 1));
+    NodesetLoader *lazy = NodesetLoader_new(NULL, NULL);
+    NodesetLoader_setLazyValues(lazy, true);
+    ck_assert(NodesetLoader_importBuffer(lazy, &handler, nodeset,
+                                         sizeof(nodeset) - 1));
+    for (UA_UInt32 i = 1; i <= 8; i++)
+    {
+        UA_NodeId id = UA_NODEID_NUMERIC(1, i);
+        const NL_VariableNode *a =
+            (const NL_VariableNode *)NodesetLoader_getNode(eager, &id);
+        const NL_VariableNode *b =
+            (const NL_VariableNode *)NodesetLoader_getNode(lazy, &id);
+        ck_assert(!a->value == !b->value);
+        if (!a->value)
+        {
+            continue;
+        }
+        ck_assert_ptr_null(b->value->data);
+        ck_assert(NL_Value_decode(b->value));
+        // a second call keeps the data
+        const NL_Data *data = b->value->data;
+        ck_assert(NL_Value_decode(b->value));
+        ck_assert(b->value->data == data);
+        ck_assert(a->value->isArray == b->value->isArray);
+        ck_assert(a->value->isExtensionObject == b->value->isExtensionObject);
+        ck_assert((!a->value->type && !b->value->type) ||
+                  !strcmp(a->value->type, b->value->type));
+        compareData(a->value->data, b->value->data);
+    }
+    UA_NodeId id = UA_NODEID_NUMERIC(1, 2);
+    const NL_VariableNode *list =
+        (const NL_VariableNode *)NodesetLoader_getNode(lazy, &id);
+    ck_assert(!strncmp(list->value->xml, "<ListOfUInt32", 13));
+    ck_assert(list->value->xml[list->value->xmlSize - 1] == '>');
+    NodesetLoader_delete(eager);
+    NodesetLoader_delete(lazy);
+}
+END_TEST
+
+// the positions of input which is converted to UTF-8 don't match the buffer,
+// the values are decoded while parsing
+START_TEST(Server_LazyValueFallbackTest)
+{
+    const char nodeset[] =
+        "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>" NODESET(
+            VARIABLE("1", "<Value><String>caf\xe9</String></Value>"));
+    NL_FileContext handler;
+    handler.addNamespace = addNamespace;
+    handler.extensionHandling = NULL;
+    handler.userContext = NULL;
+    handler.file = NULL;
+    NodesetLoader *lazy = NodesetLoader_new(NULL, NULL);
+    NodesetLoader_setLazyValues(lazy, true);
+    ck_assert(NodesetLoader_importBuffer(lazy, &handler, nodeset,
+                                         sizeof(nodeset) - 1));
+    UA_NodeId id = UA_NODEID_NUMERIC(1, 1);
+    const NL_VariableNode *node =
+        (const NL_VariableNode *)NodesetLoader_getNode(lazy, &id);
+    ck_assert_ptr_nonnull(node->value);
+    ck_assert_ptr_nonnull(node->value->data);
+    ck_assert_str_eq(node->value->data->val.primitiveData.value,
+                     "caf\xc3\xa9");
+    NodesetLoader_delete(lazy);
+}
+END_TEST
+
+typedef struct
+{
+    char events[256];
+    size_t decoders;
+    bool finished;
+} RecordingDecoder;
+
+static void *newRecordingDecoder(void *context, const NL_VariableNode *node)
+{
+    // values of strings are declined
+    UA_NodeId stringType = UA_NODEID_NUMERIC(0, 12);
+    if (UA_NodeId_equal(&node->datatype, &stringType))
+    {
+        return NULL;
+    }
+    RecordingDecoder *decoder = (RecordingDecoder *)context;
+    decoder->decoders++;
+    decoder->events[0] = '\0';
+    decoder->finished = false;
+    return decoder;
+}
+
+static void startRecording(void *decoder, const char *name)
+{
+    RecordingDecoder *d = (RecordingDecoder *)decoder;
+    strcat(d->events, "<");
+    strcat(d->events, name);
+}
+
+static void endRecording(void *decoder, const char *name, const char *text)
+{
+    RecordingDecoder *d = (RecordingDecoder *)decoder;
+    strcat(d->events, text ? text : "");
+    strcat(d->events, ">");
+}
+
+static void finishRecording(void *decoder)
+{
+    ((RecordingDecoder *)decoder)->finished = true;
+}
+
+START_TEST(Server_ValueInterfaceTest)
+{
+    const char nodeset[] = NODESET(
+        VARIABLE("1", "<Value><ListOfUInt32 xmlns=\"http://opcfoundation.org/"
+                      "UA/2008/02/Types.xsd\"><UInt32>1</UInt32>"
+                      "<UInt32>2</UInt32></ListOfUInt32></Value>")
+        "<UAVariable NodeId=\"ns=1;i=2\" BrowseName=\"1:V2\" "
+        "DataType=\"i=12\"><DisplayName>V</DisplayName>"
+        "<Value><String>text</String></Value></UAVariable>");
+    NL_FileContext handler;
+    handler.addNamespace = addNamespace;
+    handler.extensionHandling = NULL;
+    handler.userContext = NULL;
+    handler.file = NULL;
+    RecordingDecoder decoder;
+    memset(&decoder, 0, sizeof(decoder));
+    const NL_ValueInterface valueInterface = {
+        &decoder, newRecordingDecoder, startRecording, endRecording,
+        finishRecording};
+    NodesetLoader *loader = NodesetLoader_new(NULL, NULL);
+    // the interface takes precedence over lazy values
+    NodesetLoader_setLazyValues(loader, true);
+    NodesetLoader_setValueInterface(loader, &valueInterface);
+    ck_assert(NodesetLoader_importBuffer(loader, &handler, nodeset,
+                                         sizeof(nodeset) - 1));
+    ck_assert_uint_eq(decoder.decoders, 1);
+    ck_assert(decoder.finished);
+    ck_assert_str_eq(decoder.events, "<ListOfUInt32<UInt321><UInt322>>");
+
+    UA_NodeId id = UA_NODEID_NUMERIC(1, 1);
+    const NL_VariableNode *node =
+        (const NL_VariableNode *)NodesetLoader_getNode(loader, &id);
+    ck_assert(node->value->decoder == &decoder);
+    ck_assert_ptr_null(node->value->data);
+    ck_assert_ptr_null(node->value->xml);
+    // the declined value is kept as xml
+    id = UA_NODEID_NUMERIC(1, 2);
+    node = (const NL_VariableNode *)NodesetLoader_getNode(loader, &id);
+    ck_assert_ptr_null(node->value->decoder);
+    ck_assert(NL_Value_decode(node->value));
+    ck_assert_str_eq(node->value->data->val.primitiveData.value, "text");
+    NodesetLoader_delete(loader);
+}
+END_TEST
+
 static Suite *testSuite_Client(void)
 {
     Suite *s = suite_create("server nodeset import");
     TCase *tc_server = tcase_create("server nodeset import");
     tcase_add_unchecked_fixture(tc_server, setup, teardown);
     tcase_add_test(tc_server, Server_ImportBasicNodeClassTest);
+    tcase_add_test(tc_server, Server_ImportBufferTest);
+    tcase_add_test(tc_server, Server_ImportInvalidBufferTest);
+    tcase_add_test(tc_server, Server_ImportAttributeDefaultsTest);
+    tcase_add_test(tc_server, Server_CompactReferencesTest);
+    tcase_add_test(tc_server, Server_GetNodeTest);
+    tcase_add_test(tc_server, Server_ForEachLevelTest);
+    tcase_add_test(tc_server, Server_DocumentOrderTest);
+    tcase_add_test(tc_server, Server_PruneUnloadedNamespacesTest);
+    tcase_add_test(tc_server, Server_RefTypeCacheTest);
+    tcase_add_test(tc_server, Server_PendingRefTypeTest);
+    tcase_add_test(tc_server, Server_UnresolvedRefTypeTest);
+    tcase_add_test(tc_server, Server_LazyValueTest);
+    tcase_add_test(tc_server, Server_LazyValueFallbackTest);
+    tcase_add_test(tc_server, Server_ValueInterfaceTest);
     suite_add_tcase(s, tc_server);
     return s;
 }
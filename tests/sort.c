@@ -4,18 +4,28 @@
 #include <stdio.h>
 
 static const NL_Node* sortedNodes[100];
+static size_t sortedLevels[100];
 static int sortedNodesCnt = 0;
 
 struct Nodeset;
 
-static void sortCallback(struct Nodeset* nodeset, NL_Node *node) 
+static bool sortCallback(struct Nodeset* nodeset, NL_Node *node, size_t level) 
 { 
     UA_String idStr = {0};
     UA_NodeId_print(&node->id, &idStr);
     printf("%.*s\n", (int)idStr.length, (char*)idStr.data);
     UA_String_clear(&idStr);
     sortedNodes[sortedNodesCnt] = node;
+    sortedLevels[sortedNodesCnt] = level;
     sortedNodesCnt++;
+    return true;
+}
+
+// fails for the second node, like the nodeset does if memory runs out
+static bool failingCallback(struct Nodeset *nodeset, NL_Node *node,
+                            size_t level)
+{
+    return sortedNodesCnt++ == 0;
 }
 
 static void initNode(NL_VariableNode* n)
@@ -131,7 +141,7 @@ START_TEST(nodeWithRefs_2) {
 END_TEST
 
 // cycle nodeB -> nodeA and NodeA -> NodeB
-// expect: cycle detection
+// expect: cycle is broken
 START_TEST(cycleDetect) {
     sortedNodesCnt = 0;
     SortContext *ctx = Sort_init();
@@ -160,7 +170,219 @@ START_TEST(cycleDetect) {
 
     Sort_addNode(ctx, (NL_Node *)&b);
     Sort_addNode(ctx, (NL_Node *)&a);
-    ck_assert(!Sort_start(ctx, NULL, sortCallback, NULL));
+    // the cycle is broken by demoting the reference which was added last
+    ck_assert(Sort_start(ctx, NULL, sortCallback, NULL));
+    ck_assert(sortedNodesCnt == 2);
+    ck_assert(sortedNodes[0] == (NL_Node *)&a);
+    ck_assert(sortedNodes[1] == (NL_Node *)&b);
+    ck_assert(a.hierachicalRefs == NULL);
+    ck_assert(a.nonHierachicalRefs == &ref_AToB);
+    ck_assert(b.hierachicalRefs == &ref_BToA);
+    Sort_cleanup(ctx);
+}
+END_TEST
+
+static void initChild(NL_VariableNode *n, char *id, NL_Reference *refs,
+                      const NL_VariableNode **parents, size_t parentCnt)
+{
+    initNode(n);
+    n->id = UA_NODEID_STRING(1, id);
+    for (size_t i = 0; i < parentCnt; i++)
+    {
+        refs[i].isForward = false;
+        refs[i].target = parents[i]->id;
+        refs[i].next = n->hierachicalRefs;
+        n->hierachicalRefs = &refs[i];
+    }
+}
+
+static size_t levelOf(const NL_VariableNode *n)
+{
+    for (int i = 0; i < sortedNodesCnt; i++)
+    {
+        if (sortedNodes[i] == (const NL_Node *)n)
+        {
+            return sortedLevels[i];
+        }
+    }
+    ck_abort_msg("node was not sorted");
+    return 0;
+}
+
+// a <- b <- d, a <- c, e
+// f depends on a and d, it's on the level after the longest path
+START_TEST(levels)
+{
+    sortedNodesCnt = 0;
+    SortContext *ctx = Sort_init();
+    NL_Reference refs[6];
+    NL_VariableNode a, b, c, d, e, f;
+    initChild(&a, "a", NULL, NULL, 0);
+    initChild(&e, "e", NULL, NULL, 0);
+    const NL_VariableNode *parentA[] = {&a};
+    initChild(&b, "b", &refs[0], parentA, 1);
+    initChild(&c, "c", &refs[1], parentA, 1);
+    const NL_VariableNode *parentB[] = {&b};
+    initChild(&d, "d", &refs[2], parentB, 1);
+    const NL_VariableNode *parentsF[] = {&a, &d};
+    initChild(&f, "f", &refs[3], parentsF, 2);
+
+    Sort_addNode(ctx, (NL_Node *)&f);
+    Sort_addNode(ctx, (NL_Node *)&d);
+    Sort_addNode(ctx, (NL_Node *)&c);
+    Sort_addNode(ctx, (NL_Node *)&b);
+    Sort_addNode(ctx, (NL_Node *)&a);
+    Sort_addNode(ctx, (NL_Node *)&e);
+    ck_assert(Sort_start(ctx, NULL, sortCallback, NULL));
+    ck_assert(sortedNodesCnt == 6);
+    ck_assert_uint_eq(levelOf(&a), 0);
+    ck_assert_uint_eq(levelOf(&e), 0);
+    ck_assert_uint_eq(levelOf(&b), 1);
+    ck_assert_uint_eq(levelOf(&c), 1);
+    ck_assert_uint_eq(levelOf(&d), 2);
+    ck_assert_uint_eq(levelOf(&f), 3);
+    // the levels are reported in ascending order
+    for (int i = 1; i < sortedNodesCnt; i++)
+    {
+        ck_assert(sortedLevels[i - 1] <= sortedLevels[i]);
+    }
+    Sort_cleanup(ctx);
+}
+END_TEST
+
+// nodeB is a child of nodeA and also references nodeA in forward direction,
+// nodeC is a child of nodeB and can only be sorted after the cycle is broken
+// expect: the forward reference is demoted, nodeA, nodeB, nodeC
+START_TEST(cycleWithDependents) {
+    sortedNodesCnt = 0;
+    SortContext *ctx = Sort_init();
+
+    NL_VariableNode a;
+    initNode(&a);
+    a.id = UA_NODEID_STRING(1, "nodeA");
+
+    NL_Reference parentOfB;
+    parentOfB.isForward = false;
+    parentOfB.target = a.id;
+    parentOfB.next = NULL;
+    NL_Reference forwardToA;
+    forwardToA.isForward = true;
+    forwardToA.target = a.id;
+    forwardToA.next = &parentOfB;
+    NL_VariableNode b;
+    initNode(&b);
+    b.id = UA_NODEID_STRING(1, "nodeB");
+    b.hierachicalRefs = &forwardToA;
+
+    NL_Reference parentOfC;
+    parentOfC.isForward = false;
+    parentOfC.target = b.id;
+    parentOfC.next = NULL;
+    NL_VariableNode c;
+    initNode(&c);
+    c.id = UA_NODEID_STRING(1, "nodeC");
+    c.hierachicalRefs = &parentOfC;
+
+    Sort_addNode(ctx, (NL_Node *)&c);
+    Sort_addNode(ctx, (NL_Node *)&b);
+    Sort_addNode(ctx, (NL_Node *)&a);
+    ck_assert(Sort_start(ctx, NULL, sortCallback, NULL));
+    ck_assert(sortedNodesCnt == 3);
+    ck_assert(sortedNodes[0] == (NL_Node *)&a);
+    ck_assert(sortedNodes[1] == (NL_Node *)&b);
+    ck_assert(sortedNodes[2] == (NL_Node *)&c);
+    ck_assert(b.hierachicalRefs == &parentOfB);
+    ck_assert(b.nonHierachicalRefs == &forwardToA);
+    ck_assert(forwardToA.next == NULL);
+    Sort_cleanup(ctx);
+}
+END_TEST
+
+static bool isNotNs0(const void *context, const UA_NodeId *target)
+{
+    return target->namespaceIndex != 0;
+}
+
+// objects <- a <- b, the references to namespace 0 get no entry in the graph
+START_TEST(targetFilter)
+{
+    for (int filtered = 0; filtered < 2; filtered++)
+    {
+        sortedNodesCnt = 0;
+        SortContext *ctx = Sort_init();
+        if (filtered)
+        {
+            Sort_setTargetFilter(ctx, isNotNs0, NULL);
+        }
+        NL_Reference refs[2];
+        NL_VariableNode objects, a, b;
+        initNode(&objects);
+        objects.id = UA_NODEID_NUMERIC(0, 85);
+        const NL_VariableNode *parentA[] = {&objects};
+        initChild(&a, "a", &refs[0], parentA, 1);
+        const NL_VariableNode *parentB[] = {&a};
+        initChild(&b, "b", &refs[1], parentB, 1);
+
+        Sort_addNode(ctx, (NL_Node *)&b);
+        Sort_addNode(ctx, (NL_Node *)&a);
+        ck_assert(Sort_start(ctx, NULL, sortCallback, NULL));
+        ck_assert(sortedNodesCnt == 2);
+        ck_assert_uint_eq(levelOf(&a), filtered ? 0 : 1);
+        ck_assert_uint_eq(levelOf(&b), filtered ? 1 : 2);
+        Sort_cleanup(ctx);
+    }
+}
+END_TEST
+
+// a <- b only through the ParentNodeId of b, b is added first
+START_TEST(parentNodeId)
+{
+    sortedNodesCnt = 0;
+    SortContext *ctx = Sort_init();
+    NL_VariableNode a, b;
+    initNode(&a);
+    a.id = UA_NODEID_NUMERIC(1, 1);
+    a.nodeClass = NODECLASS_VARIABLE;
+    initNode(&b);
+    b.id = UA_NODEID_NUMERIC(1, 2);
+    b.nodeClass = NODECLASS_VARIABLE;
+    b.parentNodeId = a.id;
+
+    ck_assert(Sort_addNode(ctx, (NL_Node *)&b));
+    ck_assert(Sort_addNode(ctx, (NL_Node *)&a));
+    ck_assert(b.hierachicalRefs != NULL);
+    ck_assert(Sort_start(ctx, NULL, sortCallback, NULL));
+    ck_assert(sortedNodesCnt == 2);
+    ck_assert(sortedNodes[0] == (NL_Node *)&a);
+    ck_assert_uint_eq(levelOf(&b), 1);
+    Sort_cleanup(ctx);
+}
+END_TEST
+
+START_TEST(failingCallback_abortsSort)
+{
+    sortedNodesCnt = 0;
+    SortContext *ctx = Sort_init();
+
+    NL_VariableNode a;
+    initNode(&a);
+    a.id = UA_NODEID_STRING(0, "nodeA");
+    a.nodeClass = NODECLASS_VARIABLE;
+    NL_VariableNode b;
+    initNode(&b);
+    b.id = UA_NODEID_STRING(0, "nodeB");
+    b.nodeClass = NODECLASS_VARIABLE;
+    NL_VariableNode c;
+    initNode(&c);
+    c.id = UA_NODEID_STRING(0, "nodeC");
+    c.nodeClass = NODECLASS_VARIABLE;
+
+    ck_assert(Sort_addNode(ctx, (NL_Node *)&a));
+    ck_assert(Sort_addNode(ctx, (NL_Node *)&b));
+    ck_assert(Sort_addNode(ctx, (NL_Node *)&c));
+    ck_assert(!Sort_start(ctx, NULL, failingCallback, NULL));
+    // no node is reported after the failure
+    ck_assert(sortedNodesCnt == 2);
     Sort_cleanup(ctx);
 }
 END_TEST
@@ -181,6 +403,11 @@ int main(void) {
     tcase_add_test(tc, nodeWithRefs_1);
     tcase_add_test(tc, nodeWithRefs_2);
     tcase_add_test(tc, cycleDetect);
+    tcase_add_test(tc, cycleWithDependents);
+    tcase_add_test(tc, levels);
+    tcase_add_test(tc, targetFilter);
+    tcase_add_test(tc, parentNodeId);
+    tcase_add_test(tc, failingCallback_abortsSort);
     tcase_add_test(tc, empty);
     suite_add_tcase(s, tc);
 